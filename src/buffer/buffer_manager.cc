@@ -3,55 +3,312 @@
 
 #include "recovery/recovery_manager.h"
 #include "buffer/buffer_manager.h"
+#include "buffer/lru_replace.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "file/file_registry.h"
 #include "config/macro.h"
 
+#include <algorithm>
 #include <iostream>
+#include <fstream>
+#include <cstdio>
 #include <cstring>
 #include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace SimpleDB {
     
 
-// free_list_, replacer_, page_table_, available_num_, buffer_pool_
-BufferManager::BufferManager(FileManager *fm, RecoveryManager *rm, int buffer_nums) 
+// shards_, buffer_pool_
+BufferManager::BufferManager(FileManager *fm, RecoveryManager *rm, int buffer_nums, int shard_num,
+                             ReplacerType replacer_type) 
     : file_manager_(fm), recovery_manager_(rm) {
     
-    available_num_ = buffer_nums;
-    for(int i = 0;i < buffer_nums;i ++) {
-        auto buffer = std::make_unique<Buffer>(file_manager_);
-        buffer_pool_.emplace_back(std::move(buffer));
+    SIMPLEDB_ASSERT(shard_num >= 1 && shard_num <= buffer_nums, "invalid shard number");
+    for (int i = 0;i < shard_num;i ++) {
+        auto shard = std::make_unique<BufferShard>();
+        shard->replacer_ = CreateReplacer(replacer_type, buffer_nums);
+        shards_.emplace_back(std::move(shard));
+    }
 
+    // all frames are stored in a contiguous arena
+    buffer_pool_ = AllocateFrames(buffer_nums);
+    buffer_num_ = buffer_nums;
+    for(int i = 0;i < buffer_nums;i ++) {
         // At the beginning, all buffer is unused
-        free_list_.push_back(i); 
+        auto &shard = *shards_[i % shard_num];
+        shard.free_list_.push_back(i); 
+        shard.available_num_ ++;
     }
-    
-    replacer_ = std::make_unique<LRUReplacer>(buffer_nums);
 }
 
 
-frame_id_t BufferManager::VictimHelper() {
+BufferManager::~BufferManager() {
+    StopBackgroundWriter();
+
+    // remember what is hot for next startup
+    if (!dump_file_name_.empty()) {
+        DumpResidentBlocks(dump_file_name_);
+    }
+
+    // the frames may still be written by prefetching
+    for (auto &buffer : buffer_pool_) {
+        WaitForPrefetch(buffer.get());
+    }
+}
+
+
+std::unique_ptr<Replacer> BufferManager::CreateReplacer(ReplacerType replacer_type, int num_pages) {
+    switch (replacer_type) {
+    case ReplacerType::CLOCK:
+        return std::make_unique<ClockReplacer>(num_pages);
+    case ReplacerType::LRU_K:
+        return std::make_unique<LRUKReplacer>(num_pages);
+    default:
+        return std::make_unique<LRUReplacer>(num_pages);
+    }
+}
+
+
+std::vector<std::unique_ptr<Buffer>> BufferManager::AllocateFrames(int buffer_nums) {
+    std::vector<std::unique_ptr<Buffer>> buffers;
+    int block_size = file_manager_->BlockSize();
+
+    for (frame_id_t i = buffer_pool_.size();i < buffer_nums;i ++) {
+        // the tail of last segment may be left by shrinking, reuse it first
+        if (arenas_.empty() || 
+            i >= arenas_.back().begin_ + arenas_.back().arena_->GetFrameNum()) {
+            arenas_.push_back({i, std::make_unique<FrameArena>(buffer_nums - i, block_size)});
+        }
+
+        auto &segment = arenas_.back();
+        buffers.emplace_back(std::make_unique<Buffer>(
+            segment.arena_->GetFrame(i - segment.begin_), block_size));
+        buffers.back()->frame_id_ = i;
+    }
+
+    return buffers;
+}
+
+
+std::vector<std::unique_lock<std::mutex>> BufferManager::LockAllShards() {
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for (auto &shard : shards_) {
+        locks.emplace_back(shard->latch_);
+    }
+    return locks;
+}
+
+
+bool BufferManager::Resize(int buffer_nums) {
+    SIMPLEDB_ASSERT(buffer_nums >= static_cast<int>(shards_.size()), 
+                    "every shard should have a buffer at least");
+    std::lock_guard<std::mutex> resize_lock(resize_latch_);
+    int old_num = buffer_num_;
+    int shard_num = shards_.size();
+
+    if (buffer_nums >= old_num) {
+        // map memory before blocking others
+        auto buffers = AllocateFrames(buffer_nums);
+        auto locks = LockAllShards();
+        for (auto &buffer : buffers) {
+            buffer_pool_.emplace_back(std::move(buffer));
+        }
+        for (auto &shard : shards_) {
+            shard->replacer_->Resize(buffer_nums);
+        }
+
+        // the retiring buffers become usable again, a pinned one
+        // will be counted when it's unpinned
+        for (frame_id_t i = old_num;i < buffer_nums;i ++) {
+            auto *buffer = buffer_pool_[i].get();
+            auto &shard = *shards_[i % shard_num];
+            if (buffer->IsPinned()) {
+                continue;
+            }
+
+            auto iter = shard.page_table_.find(buffer->GetBlockID());
+            if (iter != shard.page_table_.end() && iter->second == i) {
+                shard.replacer_->Unpin(i);
+            } else {
+                shard.free_list_.push_back(i);
+            }
+            shard.available_num_ ++;
+        }
+        buffer_num_ = buffer_nums;
+
+        for (auto &shard : shards_) {
+            HandOffFrames(*shard);
+        }
+        return true;
+    }
+
+
+    // 1. stop using the buffers which will be removed
+    {
+        auto locks = LockAllShards();
+        for (frame_id_t i = buffer_nums;i < old_num;i ++) {
+            if (!buffer_pool_[i]->IsPinned()) {
+                shards_[i % shard_num]->available_num_ --;
+            }
+        }
+        for (auto &shard : shards_) {
+            shard->free_list_.remove_if([buffer_nums](frame_id_t frame_id) { 
+                return frame_id >= buffer_nums; 
+            });
+            shard->replacer_->Resize(buffer_nums);
+        }
+        buffer_num_ = buffer_nums;
+    }
+
+    // 2. evict them, wait for the buffers which are still pinned
+    auto start = std::chrono::high_resolution_clock::now();
+    while (true) {
+        {
+            auto locks = LockAllShards();
+            if (DropRetiringFrames() == 0) {
+                buffer_pool_.resize(buffer_nums);
+                break;
+            }
+        }
+
+        if (WaitTooLong(start)) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // 3. return the memory to os
+    while (arenas_.back().begin_ >= buffer_nums) {
+        arenas_.pop_back();
+    }
+    auto &segment = arenas_.back();
+    segment.arena_->Discard(buffer_nums - segment.begin_);
+    return true;
+}
+
+
+int BufferManager::DropRetiringFrames() {
+    int shard_num = shards_.size();
+    int used_num = 0;
+
+    for (frame_id_t i = buffer_num_;i < static_cast<int>(buffer_pool_.size());i ++) {
+        auto *buffer = buffer_pool_[i].get();
+        auto &shard = *shards_[i % shard_num];
+        auto iter = shard.page_table_.find(buffer->GetBlockID());
+        if (iter == shard.page_table_.end() || iter->second != i) {
+            // unused or has been evicted
+            continue;
+        }
+
+        if (buffer->IsPinned() || buffer->io_in_progress_) {
+            used_num ++;
+            continue;
+        }
+
+        WaitForPrefetch(buffer);
+        shard.page_table_.erase(iter);
+        FlushHelper(shard, buffer);
+        buffer->block_ = BlockId();
+    }
+
+    return used_num;
+}
+
+
+int BufferManager::available() {
+    int available_num = 0;
+    for (auto &shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->latch_);
+        available_num += shard->available_num_;
+    }
+    return available_num;
+}
+
+
+frame_id_t BufferManager::VictimHelper(BufferShard &shard) {
     frame_id_t frame_id;
     
     // 1. first select a unused buffer
-    if(!free_list_.empty()) {
-        frame_id = free_list_.front();
-        free_list_.pop_front();
+    if(!shard.free_list_.empty()) {
+        frame_id = shard.free_list_.front();
+        shard.free_list_.pop_front();
         return frame_id;
     }
 
-    // 2. select a victim buffer
-    bool is_find = replacer_->Evict(&frame_id);
+    // 2. select a victim buffer, the buffers which are being written
+    // by background writer can't be reused now, put them back later
+    bool is_find;
+    std::vector<frame_id_t> writing;
+    while ((is_find = shard.replacer_->Evict(&frame_id)) && 
+           buffer_pool_[frame_id]->io_in_progress_) {
+        writing.push_back(frame_id);
+    }
+    for (auto id : writing) {
+        shard.replacer_->Unpin(id);
+    }
 
     // 3. if we can not find a available frame, return -1 means error
-    if(!is_find && !available_num_) {
+    if(!is_find) {
         return INVALID_FRAME_ID; /* fail */
     }
     
+    WaitForPrefetch(buffer_pool_[frame_id].get());
+    return frame_id;
+}
+
+
+frame_id_t BufferManager::StrategyVictimHelper(BufferShard &shard, 
+                                               BufferAccessStrategy *strategy, 
+                                               const BlockId &block) {
+    auto &ring = strategy->ring_;
+    int ring_size = ring.size();
+    if (ring_size == 0) {
+        return VictimHelper(shard);
+    }
+
+    // 1. recycle a frame of ring. it should belong to this shard, 
+    // nobody else pins it or has replaced its block, and it's not 
+    // a block read ahead which the scan hasn't reached
+    for (auto &slot : ring) {
+        if (slot.frame_id_ == INVALID_FRAME_ID || IsRetiring(slot.frame_id_) ||
+            shards_[slot.frame_id_ % shards_.size()].get() != &shard) {
+            continue;
+        }
+
+        auto *buffer = buffer_pool_[slot.frame_id_].get();
+        if (buffer->IsPinned() || buffer->io_in_progress_ ||
+            buffer->GetBlockID() != slot.block_) {
+            continue;
+        }
+        if (slot.block_.BlockNum() > strategy->last_block_ &&
+            slot.block_.FileName() == strategy->file_name_) {
+            continue;
+        }
+
+        slot.block_ = block;
+        WaitForPrefetch(buffer);
+        return slot.frame_id_;
+    }
+
+    // 2. the ring is not full or no frame can be recycled, 
+    // select a victim from pool and remember it
+    frame_id_t frame_id = VictimHelper(shard);
+    if (frame_id != INVALID_FRAME_ID) {
+        auto &slot = ring[strategy->current_];
+        slot.frame_id_ = frame_id;
+        slot.block_ = block;
+        strategy->current_ = (strategy->current_ + 1) % ring_size;
+    }
+
     return frame_id;
 }
 
 
-void BufferManager::PinHelper(frame_id_t frame_id, 
+void BufferManager::PinHelper(BufferShard &shard,
+                              frame_id_t frame_id, 
                               const BlockId &new_block, 
                               bool if_write_to_disk) {
     auto buffer = buffer_pool_[frame_id].get();
@@ -59,16 +316,23 @@ void BufferManager::PinHelper(frame_id_t frame_id,
     // block's content into memory
     if(!buffer->IsPinned()) {
         BlockId old_block = buffer->GetBlockID();
-        page_table_.erase(old_block);
+        shard.page_table_.erase(old_block);
 
         if (if_write_to_disk) {
-            FlushHelper(buffer);
+            FlushHelper(shard, buffer);
         }
 
-        available_num_--;
-        replacer_->Pin(frame_id);
+        if (!IsRetiring(frame_id)) {
+            shard.available_num_--;
+        }
         buffer->block_ = new_block;
-        page_table_[new_block] = frame_id;
+        shard.page_table_[new_block] = frame_id;
+    }
+
+    // every access is told to replacer, some policies
+    // need the history of accesses
+    if (!IsRetiring(frame_id)) {
+        shard.replacer_->Pin(frame_id);
     }
     buffer->pin();
 
@@ -76,34 +340,41 @@ void BufferManager::PinHelper(frame_id_t frame_id,
 
 
 
-Buffer* BufferManager::TryToPin(const BlockId &block) {
+Buffer* BufferManager::TryToPin(BufferShard &shard, const BlockId &block, 
+                                BufferAccessStrategy *strategy) {
     Buffer *buffer = nullptr;
     frame_id_t frame_id;
     
     // if the corresponding block exist in pool, just use it
-    if (page_table_.find(block) != page_table_.end()) { 
-        
+    auto iter = shard.page_table_.find(block);
+    if (iter != shard.page_table_.end()) { 
+        shard.hit_num_ ++;
+        shard.GetFileStats(block).hit_num_ ++;
+
         // don't need to write to disk
-        frame_id = page_table_[block];
-        PinHelper(frame_id, block, false);
+        frame_id = iter->second;
+        PinHelper(shard, frame_id, block, false);
         return buffer_pool_[frame_id].get();
     } else {
         // otherwise, find a victim buffer
-        frame_id = VictimHelper();
+        frame_id = strategy == nullptr ? VictimHelper(shard) 
+                                       : StrategyVictimHelper(shard, strategy, block);
         
         // in PinBlock method, return NUll make txn wait 
         // until a unpinned buffer occur
         if (frame_id == INVALID_FRAME_ID) {
-            assert(available_num_ == 0);
+            assert(shard.available_num_ == shard.handing_num_ || shard.writing_num_ > 0);
             return nullptr;
         }
         
         // success
         SIMPLEDB_ASSERT(buffer_pool_[frame_id]->GetPinCount() == 0,
                         "a new buffer should not be dirty");
-        PinHelper(frame_id, block, true);
+        PinHelper(shard, frame_id, block, true);
         buffer = buffer_pool_[frame_id].get();
         file_manager_->Read(block, buffer->contents());
+        shard.miss_num_ ++;
+        shard.GetFileStats(block).miss_num_ ++;
     }
 
     return buffer;
@@ -115,58 +386,308 @@ bool BufferManager::WaitTooLong(
     std::chrono::time_point<std::chrono::high_resolution_clock> start) {
     
     auto now = std::chrono::high_resolution_clock::now();
-    double elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count();
-    
-    bool res = elapsed > max_time_;
+    bool res = now - start > pin_timeout_;
     return res;
 }
 
 
+Buffer* BufferManager::PinBlock(const BlockId &block, BufferAccessStrategy *strategy) {
+    return PinBlockHelper(block, strategy, true);
+}
+
+
+Buffer* BufferManager::TryPinBlock(const BlockId &block, BufferAccessStrategy *strategy) {
+    return PinBlockHelper(block, strategy, false);
+}
+
+
 // if we can not find a victim buffer
 // then should add this thread to wait list
-Buffer* BufferManager::PinBlock(const BlockId &block) {
-    std::unique_lock<std::mutex> lock(latch_);
+Buffer* BufferManager::PinBlockHelper(const BlockId &block, BufferAccessStrategy *strategy,
+                                      bool wait) {
+    auto &shard = GetShard(block);
+    std::unique_lock<std::mutex> lock(shard.latch_);
     auto start = std::chrono::high_resolution_clock::now();
-    Buffer *buffer = TryToPin(block);
 
-    
-    while (buffer == NULL && !WaitTooLong(start)) {        
-        // wait until a pinned buffer release
-        victim_cv_.wait_for(lock, std::chrono::milliseconds(max_time_));
-        // require the buffer again
-        buffer = TryToPin(block);
+    // a miss can't overtake the threads which are waiting for a 
+    // free frame, but a hit doesn't need a free frame
+    Buffer *buffer = nullptr;
+    if (shard.waiters_.empty() || shard.page_table_.count(block) > 0) {
+        buffer = TryToPin(shard, block, strategy);
+    }
+    bool waited = buffer == nullptr;
+
+    if (buffer == nullptr) {
+        if (!wait) {
+            return nullptr;
+        }
+
+        frame_id_t frame_id = WaitForFrame(lock, shard, start);
+        
+        // still can not acquire it
+        if (frame_id == INVALID_FRAME_ID) { 
+            throw std::runtime_error("wait too long while bufferpool pin");
+        }
+        buffer = InstallHandedFrame(shard, frame_id, block, strategy);
+    }
+
+    waited |= buffer->pending_read_ != nullptr;
+    WaitForPinnedRead(lock, buffer);
+    lock.unlock();
+
+    if (waited) {
+        pin_wait_latency_.Record(std::chrono::high_resolution_clock::now() - start);
+    }
+
+    if (strategy != nullptr && strategy->read_ahead_num_ > 0) {
+        ReadAhead(block, strategy);
+    }
+    return buffer;
+}
+
+
+frame_id_t BufferManager::WaitForFrame(std::unique_lock<std::mutex> &lock, BufferShard &shard,
+    std::chrono::time_point<std::chrono::high_resolution_clock> start) {
+    PinWaiter waiter;
+    shard.waiters_.push_back(&waiter);
+
+    // only the first waiter is woken up when a frame is freed,
+    // others keep sleeping
+    auto deadline = start + pin_timeout_;
+    while (true) {
+        if (waiter.cv_.wait_until(lock, deadline) == std::cv_status::timeout &&
+            waiter.frame_id_ == INVALID_FRAME_ID) {
+            shard.waiters_.remove(&waiter);
+            return INVALID_FRAME_ID;
+        }
+
+        if (waiter.frame_id_ == INVALID_FRAME_ID) {
+            continue;
+        }
+        shard.handing_num_ --;
+
+        // the frame may be removed by shrinking before we wake up,
+        // then we are still the first one to get the next frame
+        if (IsRetiring(waiter.frame_id_)) {
+            waiter.frame_id_ = INVALID_FRAME_ID;
+            shard.waiters_.push_front(&waiter);
+            continue;
+        }
+
+        return waiter.frame_id_;
     }
+}
 
 
-    // still can not acquire it
-    if(!buffer) { 
-        throw std::runtime_error("wait too long while bufferpool pin");
+void BufferManager::HandOffFrames(BufferShard &shard) {
+    while (!shard.waiters_.empty()) {
+        frame_id_t frame_id = VictimHelper(shard);
+        if (frame_id == INVALID_FRAME_ID) {
+            return;
+        }
+
+        // evict it now, so nobody can pin its old block before the
+        // waiter wakes up. it's still counted as available until 
+        // the waiter pins it
+        auto *buffer = buffer_pool_[frame_id].get();
+        shard.page_table_.erase(buffer->GetBlockID());
+        FlushHelper(shard, buffer);
+        buffer->block_ = BlockId();
+
+        auto *waiter = shard.waiters_.front();
+        shard.waiters_.pop_front();
+        waiter->frame_id_ = frame_id;
+        shard.handing_num_ ++;
+        waiter->cv_.notify_one();
     }
+}
 
+
+Buffer* BufferManager::InstallHandedFrame(BufferShard &shard, frame_id_t frame_id, 
+                                          const BlockId &block, BufferAccessStrategy *strategy) {
+    if (shard.page_table_.count(block) > 0) {
+        shard.free_list_.push_back(frame_id);
+        HandOffFrames(shard);
+        return TryToPin(shard, block, strategy);
+    }
+
+    PinHelper(shard, frame_id, block, true);
+    auto *buffer = buffer_pool_[frame_id].get();
+    file_manager_->Read(block, buffer->contents());
+    shard.miss_num_ ++;
+    shard.GetFileStats(block).miss_num_ ++;
     return buffer;
 }
 
 
-Buffer* BufferManager::TryToAllocatePin(const BlockId &block) { 
+void BufferManager::WaitForPinnedRead(std::unique_lock<std::mutex> &lock, Buffer *buffer) {
+    if (buffer->pending_read_ == nullptr) {
+        return;
+    }
+
+    // the buffer is pinned by us, so it won't be evicted while we
+    // wait without the latch
+    auto completion = buffer->pending_read_;
+    bool success = true;
+    lock.unlock();
+    try {
+        completion->Wait();
+    } catch (const std::runtime_error &) {
+        success = false;
+    }
+    lock.lock();
+
+    if (buffer->pending_read_ == completion) {
+        buffer->pending_read_ = nullptr;
+        // prefetching failed, read it by ourselves
+        if (!success) {
+            file_manager_->Read(buffer->GetBlockID(), buffer->contents());
+        }
+    }
+}
+
+
+void BufferManager::WaitForPrefetch(Buffer *buffer) {
+    if (buffer->pending_read_ == nullptr) {
+        return;
+    }
+
+    try {
+        buffer->pending_read_->Wait();
+    } catch (const std::runtime_error &) {
+        // the frame will hold another block, the failed read doesn't matter
+    }
+    buffer->pending_read_ = nullptr;
+}
+
+
+void BufferManager::ReadAhead(const BlockId &block, BufferAccessStrategy *strategy) {
+    int block_num = block.BlockNum();
+    if (block.FileName() == strategy->file_name_ && block_num == strategy->last_block_) {
+        // the same block is pinned again
+        return;
+    }
+
+    bool sequential = block_num == strategy->last_block_ + 1 &&
+                      (strategy->file_name_.empty() || block.FileName() == strategy->file_name_);
+    if (block.FileName() != strategy->file_name_) {
+        strategy->file_name_ = block.FileName();
+    }
+    strategy->last_block_ = block_num;
+
+    if (!sequential) {
+        strategy->prefetch_end_ = block_num + 1;
+        return;
+    }
+
+    // when the scan enters the last window, issue the next one. so there
+    // is always a whole window in flight while the scan consumes another
+    int read_ahead_num = strategy->read_ahead_num_;
+    if (strategy->prefetch_end_ - block_num > read_ahead_num) {
+        return;
+    }
+
+    int start_block = std::max(strategy->prefetch_end_, block_num + 1);
+    int end_block = std::min(start_block + read_ahead_num, 
+                             file_manager_->GetFileBlockNum(block.FileName()));
+    if (start_block >= end_block) {
+        return;
+    }
+
+    Prefetch(block.FileName(), start_block, end_block, strategy);
+    strategy->prefetch_end_ = end_block;
+}
+
+
+void BufferManager::Prefetch(const std::string &file_name, int start_block, int end_block,
+                             BufferAccessStrategy *strategy) {
+    end_block = std::min(end_block, file_manager_->GetFileBlockNum(file_name));
+    std::vector<BlockId> blocks;
+    for (int i = start_block;i < end_block;i ++) {
+        blocks.emplace_back(file_name, i);
+    }
+
+    PrefetchBlocks(blocks, strategy);
+}
+
+
+void BufferManager::PrefetchBlocks(const std::vector<BlockId> &all_blocks, 
+                                   BufferAccessStrategy *strategy) {
+    // blocks of the same shard are submitted as one batch
+    std::vector<std::vector<BlockId>> shard_blocks(shards_.size());
+    for (auto &block : all_blocks) {
+        shard_blocks[block.Hash() % shards_.size()].push_back(block);
+    }
+
+    for (int i = 0;i < static_cast<int>(shards_.size());i ++) {
+        if (shard_blocks[i].empty()) {
+            continue;
+        }
+
+        auto &shard = *shards_[i];
+        std::lock_guard<std::mutex> lock(shard.latch_);
+        std::vector<BlockId> blocks;
+        std::vector<Page*> pages;
+        std::vector<Buffer*> buffers;
+
+        for (auto &block : shard_blocks[i]) {
+            if (shard.page_table_.find(block) != shard.page_table_.end()) {
+                continue;
+            }
+
+            // prefetching is only a hint, don't wait for a free frame
+            frame_id_t frame_id = strategy == nullptr ? VictimHelper(shard) 
+                                                      : StrategyVictimHelper(shard, strategy, block);
+            if (frame_id == INVALID_FRAME_ID) {
+                break;
+            }
+
+            auto *buffer = buffer_pool_[frame_id].get();
+            shard.page_table_.erase(buffer->GetBlockID());
+            FlushHelper(shard, buffer);
+            buffer->block_ = block;
+            shard.page_table_[block] = frame_id;
+
+            // the frame stays unpinned and can be evicted after the read finishes
+            shard.replacer_->Unpin(frame_id);
+            blocks.push_back(block);
+            pages.push_back(buffer->contents());
+            buffers.push_back(buffer);
+        }
+
+        if (blocks.empty()) {
+            continue;
+        }
+
+        // nobody can see the frames before we release the latch
+        auto completion = file_manager_->SubmitRead(blocks, pages);
+        for (auto *buffer : buffers) {
+            buffer->pending_read_ = completion;
+        }
+    }
+}
+
+
+Buffer* BufferManager::TryToAllocatePin(BufferShard &shard, const BlockId &block) { 
     Buffer *buffer = nullptr;
     frame_id_t frame_id;
     
     // if the corresponding block exist in pool, just use it
-    if (page_table_.find(block) != page_table_.end()) { 
+    if (shard.page_table_.find(block) != shard.page_table_.end()) { 
         SIMPLEDB_ASSERT(false, "new block should not exist in bufferpool");
     } else {
         // otherwise, find a victim buffer
-        frame_id = VictimHelper();
+        frame_id = VictimHelper(shard);
         
         if (frame_id == INVALID_FRAME_ID) {
-            assert(available_num_ == 0);
+            assert(shard.available_num_ == shard.handing_num_ || shard.writing_num_ > 0);
             return nullptr;
         }
         
         // success
         SIMPLEDB_ASSERT(buffer_pool_[frame_id]->GetPinCount() == 0,
                         "a new buffer should not be dirty");
-        PinHelper(frame_id, block, true);
+        PinHelper(shard, frame_id, block, true);
     }
 
     
@@ -177,20 +698,27 @@ Buffer* BufferManager::TryToAllocatePin(const BlockId &block) {
 
 
 Buffer* BufferManager::NewBlock(const std::string &file_name, int *block_num) {
-    std::unique_lock<std::mutex> lock(latch_);
-    auto start = std::chrono::high_resolution_clock::now();
+    // appending is serialized by filemanager, so it don't need our latch
     auto block = file_manager_->Append(file_name);
-    Buffer *buffer = TryToAllocatePin(block);
+    auto &shard = GetShard(block);
+    std::unique_lock<std::mutex> lock(shard.latch_);
+    auto start = std::chrono::high_resolution_clock::now();
 
-    while (buffer == NULL && !WaitTooLong(start)) {
-        // wait until a pinned buffer release
-        victim_cv_.wait_for(lock, std::chrono::milliseconds(max_time_));
-        // require the buffer again
-        buffer = TryToAllocatePin(block);
+    // queue up behind the threads waiting for a free frame
+    Buffer *buffer = nullptr;
+    if (shard.waiters_.empty()) {
+        buffer = TryToAllocatePin(shard, block);
     }
 
-    if(!buffer) { // still can not acquire it
-        throw std::runtime_error("wait too long while bufferpool pin");
+    if (buffer == nullptr) {
+        frame_id_t frame_id = WaitForFrame(lock, shard, start);
+        if (frame_id == INVALID_FRAME_ID) { // still can not acquire it
+            throw std::runtime_error("wait too long while bufferpool pin");
+        }
+
+        // nobody else can pin a new block, so the frame is ours
+        PinHelper(shard, frame_id, block, true);
+        buffer = buffer_pool_[frame_id].get();
     }
     
     if (block_num) {
@@ -203,34 +731,68 @@ Buffer* BufferManager::NewBlock(const std::string &file_name, int *block_num) {
 
 
 
-bool BufferManager::UnpinBlock(Buffer *buffer) {
-    std::unique_lock<std::mutex> lock(latch_);
-    
+bool BufferManager::UnpinBlock(Buffer *buffer, bool is_dirty) {
     assert(buffer != nullptr);
-    auto block = buffer->GetBlockID();
+
+    // a pinned buffer can't be evicted, so its block and frame id are
+    // stable and we don't need to look up page table
+    const auto &block = buffer->GetBlockID();
+    auto &shard = GetShard(block);
+    std::unique_lock<std::mutex> lock(shard.latch_);
     
-    // not exist
-    if(page_table_.find(block) == page_table_.end()){
+    // unpin a non-pinned block
+    if (buffer->GetPinCount() == 0) {
         return false;
     }
 
-    auto frame_id = page_table_[block];
-    UnpinHelper(frame_id, block);
+    if (is_dirty) {
+        buffer->is_dirty_ = true;
+    }
+    UnpinHelper(shard, buffer->frame_id_, block);
     return true;
 }
 
 
+BasicPageGuard BufferManager::PinBlockGuarded(const BlockId &block, 
+                                              BufferAccessStrategy *strategy) {
+    return BasicPageGuard(this, PinBlock(block, strategy));
+}
+
+
+ReadPageGuard BufferManager::PinBlockRead(const BlockId &block, 
+                                          BufferAccessStrategy *strategy) {
+    auto *buffer = PinBlock(block, strategy);
+    buffer->RLock();
+    return ReadPageGuard(BasicPageGuard(this, buffer));
+}
+
+
+WritePageGuard BufferManager::PinBlockWrite(const BlockId &block, 
+                                            BufferAccessStrategy *strategy) {
+    auto *buffer = PinBlock(block, strategy);
+    buffer->WLock();
+    return WritePageGuard(BasicPageGuard(this, buffer));
+}
+
+
+BasicPageGuard BufferManager::NewBlockGuarded(const std::string &file_name, int *block_num) {
+    return BasicPageGuard(this, NewBlock(file_name, block_num));
+}
+
+
 
 bool BufferManager::UnpinBlock(const BlockId &block, bool is_dirty) {
-    std::unique_lock<std::mutex> lock(latch_);
+    auto &shard = GetShard(block);
+    std::unique_lock<std::mutex> lock(shard.latch_);
     
 
     // not exist
-    if(page_table_.find(block) == page_table_.end()){
+    auto iter = shard.page_table_.find(block);
+    if(iter == shard.page_table_.end()){
         return false;
     }
     
-    auto frame_id = page_table_[block];
+    auto frame_id = iter->second;
     auto *buffer = buffer_pool_[frame_id].get();
     
     // unpin a non-pinned block
@@ -239,13 +801,15 @@ bool BufferManager::UnpinBlock(const BlockId &block, bool is_dirty) {
     }
 
     
-    buffer->is_dirty_ |= is_dirty;
-    UnpinHelper(frame_id, block);
+    if (is_dirty) {
+        buffer->is_dirty_ = true;
+    }
+    UnpinHelper(shard, frame_id, block);
     return true;
 }
 
 
-void BufferManager::UnpinHelper(frame_id_t frame_id, const BlockId &block) {
+void BufferManager::UnpinHelper(BufferShard &shard, frame_id_t frame_id, const BlockId &block) {
     auto buffer = buffer_pool_[frame_id].get();
 
     buffer->unpin();
@@ -253,12 +817,13 @@ void BufferManager::UnpinHelper(frame_id_t frame_id, const BlockId &block) {
     // update replacer object and buffer, don't need to update page table immediately.
     // and don't need to flush the content of block to disk immediately
     // this will bring some extra io cost.
-    if(!buffer->IsPinned()) {
-        available_num_ ++;
-        replacer_->Unpin(frame_id);
+    // a retiring buffer will be evicted by resizing instead
+    if(!buffer->IsPinned() && !IsRetiring(frame_id)) {
+        shard.available_num_ ++;
+        shard.replacer_->Unpin(frame_id);
 
-        // notify other txns which acquire a free frame
-        victim_cv_.notify_all();
+        // give a frame to the first txn which waits for it
+        HandOffFrames(shard);
     }
 
 }
@@ -266,23 +831,79 @@ void BufferManager::UnpinHelper(frame_id_t frame_id, const BlockId &block) {
 
 
 void BufferManager::FlushAll() {
-    std::lock_guard<std::mutex> lock(latch_);
-    int buffer_pool_size = static_cast<int> (buffer_pool_.size());
+    auto locks = LockAllShards();
+
+    std::vector<Buffer*> dirty_buffers;
+    std::vector<BlockId> blocks;
+    std::vector<Page*> pages;
+
+    // collect all dirty buffers and write them as one batch, so
+    // many ios are in flight instead of one by one.
+    // unlike FlushHelper, buffers are still resident after flushing,
+    // so we don't reset them.
+    for (auto &buffer : buffer_pool_) {
+        if (buffer->IsDirty()) {
+            dirty_buffers.push_back(buffer.get());
+            blocks.push_back(buffer->GetBlockID());
+            pages.push_back(buffer->contents());
+        }
+    }
 
-    for(int i = 0;i < buffer_pool_size;i ++) {
-        auto *buffer = buffer_pool_[i].get();
-        FlushHelper(buffer);
+    file_manager_->WriteBatch(blocks, pages);
+    for (auto *buffer : dirty_buffers) {
+        buffer->is_dirty_ = false;
     }
+
+    // one barrier for the whole batch instead of one per block
+    file_manager_->SyncAll();
 }
 
 
 
-void BufferManager::FlushHelper(Buffer *buffer) {
+BufferStatsSnapshot BufferManager::GetStats() {
+    BufferStatsSnapshot stats;
+    for (auto &shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->latch_);
+        stats.hit_num_ += shard->hit_num_;
+        stats.miss_num_ += shard->miss_num_;
+        stats.clean_eviction_num_ += shard->clean_eviction_num_;
+        stats.dirty_eviction_num_ += shard->dirty_eviction_num_;
+
+        auto &registry = FileRegistry::GetInstance();
+        for (uint32_t file_id = 0;file_id < shard->file_stats_.size();file_id ++) {
+            auto &file_stats = shard->file_stats_[file_id];
+            if (file_stats.hit_num_ + file_stats.miss_num_ == 0) {
+                continue;
+            }
+            auto &total = stats.file_stats_[registry.GetFileName(file_id)];
+            total.hit_num_ += file_stats.hit_num_;
+            total.miss_num_ += file_stats.miss_num_;
+        }
+    }
+
+    stats.background_write_num_ = background_write_num_;
+    stats.pin_wait_ = pin_wait_latency_.GetSnapshot();
+    stats.io_ = file_manager_->GetIOStats();
+    return stats;
+}
+
+
+void BufferManager::FlushHelper(BufferShard &shard, Buffer *buffer) {
     // because of WAL protocol, we should flush relative log record
     // before writing block to disk.
 
     clock_t begin, end;
     begin = clock();
+
+    // free frames hold no block
+    if (buffer->GetBlockID().BlockNum() >= 0) {
+        if (buffer->IsDirty()) {
+            shard.dirty_eviction_num_ ++;
+        } else {
+            shard.clean_eviction_num_ ++;
+        }
+    }
+
     // we don't flush log to disk every time for reducing io cost purpose.
     if (buffer->IsDirty() && buffer->GetPageLsn() > INVALID_LSN) {
         // recovery_manager_->FlushBlock(buffer->GetBlockID(), buffer->GetPageLsn());
@@ -291,26 +912,292 @@ void BufferManager::FlushHelper(Buffer *buffer) {
     if (buffer->IsDirty()) {
         file_manager_->Write(buffer->GetBlockID(), buffer->contents());
         buffer->is_dirty_ = false;
+        foreground_write_num_ ++;
     }
 
     buffer->Init();
 
     end = clock();
-    pin_time_ += double(end - begin);
+    shard.pin_time_ += double(end - begin);
 }
 
 
 Buffer* BufferManager::NewBlock(const std::string &file_name) {
-    std::unique_lock<std::mutex> lock(latch_);
     BlockId block = file_manager_->Append(file_name);
-    return TryToAllocatePin(block);
+    auto &shard = GetShard(block);
+    std::unique_lock<std::mutex> lock(shard.latch_);
+    return TryToAllocatePin(shard, block);
+}
+
+
+
+void BufferManager::StartBackgroundWriter(int clean_target, 
+                                          std::chrono::milliseconds interval) {
+    std::lock_guard<std::mutex> lock(writer_latch_);
+    if (writer_thread_ != nullptr) {
+        return;
+    }
+
+    writer_stop_ = false;
+    writer_thread_ = std::make_unique<std::thread>(
+        &BufferManager::BackgroundWriterLoop, this, clean_target, interval);
+}
+
+
+void BufferManager::StopBackgroundWriter() {
+    {
+        std::lock_guard<std::mutex> lock(writer_latch_);
+        if (writer_thread_ == nullptr) {
+            return;
+        }
+        writer_stop_ = true;
+    }
+
+    writer_cv_.notify_all();
+    writer_thread_->join();
+    writer_thread_.reset();
+}
+
+
+void BufferManager::BackgroundWriterLoop(int clean_target, 
+                                         std::chrono::milliseconds interval) {
+    // every shard keeps its share of clean buffers
+    int shard_target = (clean_target + shards_.size() - 1) / shards_.size();
+    auto last_dump = std::chrono::steady_clock::now();
+
+    while (true) {
+        std::string dump_file_name;
+        std::chrono::milliseconds dump_interval;
+        {
+            std::unique_lock<std::mutex> lock(writer_latch_);
+            if (writer_cv_.wait_for(lock, interval, [this]() { return writer_stop_; })) {
+                return;
+            }
+            dump_file_name = dump_file_name_;
+            dump_interval = dump_interval_;
+        }
+
+        for (int i = 0;i < static_cast<int>(shards_.size());i ++) {
+            CleanShard(i, shard_target);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (!dump_file_name.empty() && now - last_dump >= dump_interval) {
+            DumpResidentBlocks(dump_file_name);
+            last_dump = now;
+        }
+    }
+}
+
+
+void BufferManager::SetDumpFile(const std::string &file_name, 
+                                std::chrono::milliseconds interval) {
+    std::lock_guard<std::mutex> lock(writer_latch_);
+    dump_file_name_ = file_name;
+    dump_interval_ = interval;
+}
+
+
+void BufferManager::DumpResidentBlocks(const std::string &file_name) {
+    int shard_num = shards_.size();
+    std::vector<std::vector<BlockId>> shard_blocks(shard_num);
+
+    for (int i = 0;i < shard_num;i ++) {
+        auto &shard = *shards_[i];
+        std::lock_guard<std::mutex> lock(shard.latch_);
+
+        // the pinned blocks are being used, they are the hottest
+        for (frame_id_t frame_id = i;frame_id < buffer_num_;frame_id += shard_num) {
+            auto *buffer = buffer_pool_[frame_id].get();
+            if (buffer->IsPinned()) {
+                shard_blocks[i].push_back(buffer->GetBlockID());
+            }
+        }
+        for (auto frame_id : shard.replacer_->GetFramesByRecency()) {
+            shard_blocks[i].push_back(buffer_pool_[frame_id]->GetBlockID());
+        }
+    }
+
+    // take blocks from shards in turn, so the order is close to 
+    // the recency of the whole bufferpool
+    std::string path = file_manager_->GetFilePath(file_name);
+    std::string temp_path = path + ".temp";
+    std::ofstream out(temp_path, std::ios::trunc);
+    for (size_t rank = 0;;rank ++) {
+        bool has_more = false;
+        for (auto &blocks : shard_blocks) {
+            if (rank < blocks.size()) {
+                out << blocks[rank].BlockNum() << " " << blocks[rank].FileName() << "\n";
+                has_more = true;
+            }
+        }
+
+        if (!has_more) {
+            break;
+        }
+    }
+
+    out.close();
+
+    auto sync_path = [](const std::string &file_path) {
+        int fd = open(file_path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            return false;
+        }
+        bool res = (fsync(fd) == 0);
+        close(fd);
+        return res;
+    };
+
+    // a crash never leaves a partial dump, the content must be durable
+    // before rename, and the directory is synced to make rename durable
+    if (!out || !sync_path(temp_path) || 
+        std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        return;
+    }
+    sync_path(path.substr(0, path.rfind('/')));
+}
+
+
+int BufferManager::LoadResidentBlocks(const std::string &file_name) {
+    std::ifstream in(file_manager_->GetFilePath(file_name));
+    if (!in) {
+        return 0;
+    }
+
+    // only the hottest blocks which fit in bufferpool are read,
+    // and the tables may have been dropped or truncated
+    std::vector<BlockId> hot_blocks;
+    int block_num;
+    std::string block_file_name;
+    while (static_cast<int>(hot_blocks.size()) < buffer_num_ && 
+           in >> block_num && in.get() == ' ' && std::getline(in, block_file_name)) {
+        if (file_manager_->IsFileExist(block_file_name) &&
+            block_num < file_manager_->GetFileBlockNum(block_file_name)) {
+            hot_blocks.emplace_back(block_file_name, block_num);
+        }
+    }
+
+    // read in the order of disk
+    std::vector<BlockId> blocks = hot_blocks;
+    std::sort(blocks.begin(), blocks.end());
+    blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+    PrefetchBlocks(blocks, nullptr);
+
+    for (auto &shard : shards_) {
+        std::unique_lock<std::mutex> lock(shard->latch_);
+        for (auto &block : blocks) {
+            auto iter = shard->page_table_.find(block);
+            if (iter != shard->page_table_.end()) {
+                // it isn't pinned, but it's also safe if someone evicts it 
+                // while we are waiting
+                WaitForPinnedRead(lock, buffer_pool_[iter->second].get());
+            }
+        }
+    }
+
+    // the frames were given to replacer in the order of disk, 
+    // give them again from the coldest one to restore the recency
+    for (auto iter = hot_blocks.rbegin();iter != hot_blocks.rend();iter ++) {
+        auto &shard = GetShard(*iter);
+        std::lock_guard<std::mutex> lock(shard.latch_);
+        auto entry = shard.page_table_.find(*iter);
+        if (entry == shard.page_table_.end() || IsRetiring(entry->second) ||
+            buffer_pool_[entry->second]->IsPinned()) {
+            continue;
+        }
+
+        shard.replacer_->Pin(entry->second);
+        shard.replacer_->Unpin(entry->second);
+    }
+
+    return blocks.size();
 }
 
 
+void BufferManager::CleanShard(int shard_id, int clean_target) {
+    auto &shard = *shards_[shard_id];
+    int shard_num = shards_.size();
+    std::vector<Buffer*> frames;
+
+    {
+        std::lock_guard<std::mutex> lock(shard.latch_);
+        int clean_num = 0;
+        std::vector<frame_id_t> dirty_frames;
+        // buffer_pool_ may be changed by resizing when we don't hold 
+        // the latch, so remember the buffers instead of their frame id
+        for (frame_id_t i = shard_id;i < buffer_num_;i += shard_num) {
+            auto *buffer = buffer_pool_[i].get();
+            if (buffer->IsPinned() || buffer->io_in_progress_) {
+                continue;
+            }
+            
+            if (buffer->IsDirty()) {
+                dirty_frames.push_back(i);
+            } else {
+                clean_num ++;
+            }
+        }
+
+        // mark the buffers, so they won't be evicted while writing
+        for (auto frame_id : dirty_frames) {
+            if (clean_num + static_cast<int>(frames.size()) >= clean_target) {
+                break;
+            }
+            buffer_pool_[frame_id]->io_in_progress_ = true;
+            frames.push_back(buffer_pool_[frame_id].get());
+        }
+        shard.writing_num_ += frames.size();
+    }
+
+    if (frames.empty()) {
+        return;
+    }
+
+    // someone may pin the buffer now, but he can't modify it until
+    // we release the read latch, so we write a consistent page
+    for (auto *buffer : frames) {
+        buffer->RLock();
+        
+        // WAL, log records should be durable before the page
+        if (recovery_manager_ != nullptr && buffer->GetPageLsn() > INVALID_LSN) {
+            recovery_manager_->FlushBlock(buffer->GetBlockID(), buffer->GetPageLsn());
+        }
+
+        file_manager_->Write(buffer->GetBlockID(), buffer->contents());
+        if (recovery_manager_ != nullptr) {
+            recovery_manager_->BlockCleaned(buffer->GetBlockID());
+        }
+        
+        // a writer modifies the page under the write latch and marks it 
+        // dirty after that, so a later modification is never lost
+        buffer->is_dirty_ = false;
+        buffer->RUnlock();
+    }
+    background_write_num_ += frames.size();
+
+    {
+        std::lock_guard<std::mutex> lock(shard.latch_);
+        for (auto *buffer : frames) {
+            buffer->io_in_progress_ = false;
+        }
+        shard.writing_num_ -= frames.size();
+
+        // the frames can be reused by txns which wait for a victim
+        HandOffFrames(shard);
+    }
+}
+
 
 void BufferManager::GetBufferPoolConsumeTime() {
+    double pin_time = 0;
+    for (auto &shard : shards_) {
+        pin_time += shard->pin_time_;
+    }
+
     std::cout << std::fixed;
-    std::cout << pin_time_ << "   " << unpin_time_ << std::endl;
+    std::cout << pin_time << "   " << unpin_time_ << std::endl;
 }
 
 
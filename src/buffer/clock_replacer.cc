@@ -0,0 +1,109 @@
+#ifndef CLOCK_REPLACER_CC
+#define CLOCK_REPLACER_CC
+
+#include "buffer/clock_replacer.h"
+
+namespace SimpleDB {
+
+ClockReplacer::ClockReplacer(frame_id_t num_pages) 
+    : capacity_(num_pages),
+      in_replacer_(new std::atomic<bool>[num_pages]),
+      ref_bits_(new std::atomic<bool>[num_pages]) {
+    
+    for (frame_id_t i = 0;i < capacity_;i ++) {
+        in_replacer_[i] = false;
+        ref_bits_[i] = false;
+    }
+}
+
+bool ClockReplacer::Evict(frame_id_t *victim) {
+    std::lock_guard<std::mutex> lock(latch_);
+    
+    // every frame is visited at most twice, the first time
+    // clears its reference bit and the second time evicts it
+    for (frame_id_t i = 0;i < 2 * capacity_ + 1 && size_ > 0;i ++) {
+        frame_id_t frame_id = hand_;
+        hand_ = (hand_ + 1) % capacity_;
+
+        if (!in_replacer_[frame_id]) {
+            continue;
+        }
+
+        // give it a second chance
+        if (ref_bits_[frame_id].exchange(false)) {
+            continue;
+        }
+
+        // the frame may be pinned concurrently
+        if (in_replacer_[frame_id].exchange(false)) {
+            size_ --;
+            *victim = frame_id;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ClockReplacer::Resize(frame_id_t num_pages) {
+    std::lock_guard<std::mutex> lock(latch_);
+    std::unique_ptr<std::atomic<bool>[]> in_replacer(new std::atomic<bool>[num_pages]);
+    std::unique_ptr<std::atomic<bool>[]> ref_bits(new std::atomic<bool>[num_pages]);
+    
+    int size = 0;
+    for (frame_id_t i = 0;i < num_pages;i ++) {
+        bool keep = i < capacity_;
+        in_replacer[i] = keep && in_replacer_[i].load();
+        ref_bits[i] = keep && ref_bits_[i].load();
+        size += in_replacer[i] ? 1 : 0;
+    }
+
+    in_replacer_ = std::move(in_replacer);
+    ref_bits_ = std::move(ref_bits);
+    capacity_ = num_pages;
+    size_ = size;
+    if (hand_ >= capacity_) {
+        hand_ = 0;
+    }
+}
+
+std::vector<frame_id_t> ClockReplacer::GetFramesByRecency() {
+    std::lock_guard<std::mutex> lock(latch_);
+    std::vector<frame_id_t> referenced;
+    std::vector<frame_id_t> unreferenced;
+
+    // clock only knows whether a frame is used recently. the hand evicts 
+    // the frames after it first, so the frames before it come first
+    for (frame_id_t i = 0;i < capacity_;i ++) {
+        frame_id_t frame_id = (hand_ + capacity_ - 1 - i) % capacity_;
+        if (!in_replacer_[frame_id]) {
+            continue;
+        }
+        
+        if (ref_bits_[frame_id]) {
+            referenced.push_back(frame_id);
+        } else {
+            unreferenced.push_back(frame_id);
+        }
+    }
+
+    referenced.insert(referenced.end(), unreferenced.begin(), unreferenced.end());
+    return referenced;
+}
+
+void ClockReplacer::Pin(frame_id_t frame_id) {
+    if (in_replacer_[frame_id].exchange(false)) {
+        size_ --;
+    }
+}
+
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+    ref_bits_[frame_id] = true;
+    if (!in_replacer_[frame_id].exchange(true)) {
+        size_ ++;
+    }
+}
+
+} // namespace SimpleDB
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef FRAME_ARENA_CC
+#define FRAME_ARENA_CC
+
+#include "buffer/frame_arena.h"
+#include "config/config.h"
+
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace SimpleDB {
+
+// the size of a huge page on x86-64 and aarch64
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+static size_t RoundUp(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+FrameArena::FrameArena(int frame_num, int frame_size) 
+    : frame_size_(frame_size), frame_num_(frame_num) {
+    size_t need_size = static_cast<size_t>(frame_num) * frame_size;
+    void *ptr = MAP_FAILED;
+
+    // 1. try explicit huge pages, it fails if no huge page is reserved
+    if (SIMPLEDB_BUFFER_POOL_HUGE_PAGE && need_size >= HUGE_PAGE_SIZE) {
+        size_ = RoundUp(need_size, HUGE_PAGE_SIZE);
+        ptr = mmap(nullptr, size_, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        huge_page_ = (ptr != MAP_FAILED);
+    }
+
+    // 2. fallback to normal pages, and ask for transparent huge pages
+    if (ptr == MAP_FAILED) {
+        size_ = RoundUp(need_size == 0 ? 1 : need_size, sysconf(_SC_PAGESIZE));
+        ptr = mmap(nullptr, size_, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+
+#ifdef MADV_HUGEPAGE
+        if (SIMPLEDB_BUFFER_POOL_HUGE_PAGE && size_ >= HUGE_PAGE_SIZE) {
+            // it's only a hint, ignore the error
+            madvise(ptr, size_, MADV_HUGEPAGE);
+        }
+#endif
+    }
+
+    data_ = static_cast<char*>(ptr);
+}
+
+void FrameArena::Discard(frame_id_t begin_frame) {
+    // only whole pages can be returned, a huge page is returned 
+    // if all frames on it are discarded
+    size_t page_size = huge_page_ ? HUGE_PAGE_SIZE : sysconf(_SC_PAGESIZE);
+    size_t begin = RoundUp(static_cast<size_t>(begin_frame) * frame_size_, page_size);
+    if (begin < size_) {
+        // it's only an optimization, ignore the error
+        madvise(data_ + begin, size_ - begin, MADV_DONTNEED);
+    }
+}
+
+FrameArena::~FrameArena() {
+    munmap(data_, size_);
+}
+
+} // namespace SimpleDB
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef LRU_K_REPLACER_CC
+#define LRU_K_REPLACER_CC
+
+#include "buffer/lru_k_replacer.h"
+
+namespace SimpleDB {
+
+LRUKReplacer::LRUKReplacer(frame_id_t num_pages, int k) 
+    : k_(k), history_(num_pages), evictable_(num_pages, false) {}
+
+bool LRUKReplacer::Evict(frame_id_t *victim) {
+    std::lock_guard<std::mutex> lock(latch_);
+    
+    // infinite backward k-distance first
+    auto &candidates = young_.empty() ? old_ : young_;
+    if (candidates.empty()) {
+        return false;
+    }
+
+    *victim = candidates.begin()->second;
+    candidates.erase(candidates.begin());
+    evictable_[*victim] = false;
+    // the frame will hold another block, so forget its history
+    history_[*victim].clear();
+    return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+    std::lock_guard<std::mutex> lock(latch_);
+    auto &history = history_[frame_id];
+
+    if (evictable_[frame_id]) {
+        auto &candidates = static_cast<int>(history.size()) < k_ ? young_ : old_;
+        candidates.erase({history.front(), frame_id});
+        evictable_[frame_id] = false;
+    }
+
+    // only the last k accesses are needed
+    history.push_back(current_timestamp_++);
+    if (static_cast<int>(history.size()) > k_) {
+        history.pop_front();
+    }
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+    std::lock_guard<std::mutex> lock(latch_);
+    auto &history = history_[frame_id];
+
+    if (evictable_[frame_id]) {
+        return;
+    }
+
+    // a frame which is never pinned is viewed as accessed now
+    if (history.empty()) {
+        history.push_back(current_timestamp_++);
+    }
+
+    // the front of history is the earliest access when accessed less 
+    // than k times, otherwise it is the k-th most recent access
+    auto &candidates = static_cast<int>(history.size()) < k_ ? young_ : old_;
+    candidates.insert({history.front(), frame_id});
+    evictable_[frame_id] = true;
+}
+
+void LRUKReplacer::Resize(frame_id_t num_pages) {
+    std::lock_guard<std::mutex> lock(latch_);
+    for (frame_id_t i = num_pages;i < static_cast<frame_id_t>(evictable_.size());i ++) {
+        if (evictable_[i]) {
+            auto &candidates = static_cast<int>(history_[i].size()) < k_ ? young_ : old_;
+            candidates.erase({history_[i].front(), i});
+        }
+    }
+
+    history_.resize(num_pages);
+    evictable_.resize(num_pages, false);
+}
+
+std::vector<frame_id_t> LRUKReplacer::GetFramesByRecency() {
+    std::lock_guard<std::mutex> lock(latch_);
+    std::vector<frame_id_t> frames;
+    
+    // reverse the order of eviction
+    for (auto iter = old_.rbegin();iter != old_.rend();iter ++) {
+        frames.push_back(iter->second);
+    }
+    for (auto iter = young_.rbegin();iter != young_.rend();iter ++) {
+        frames.push_back(iter->second);
+    }
+    return frames;
+}
+
+int LRUKReplacer::Size() {
+    std::lock_guard<std::mutex> lock(latch_);
+    return young_.size() + old_.size();
+}
+
+} // namespace SimpleDB
+
+#endif
@@ -44,6 +44,24 @@ int LRUReplacer::Size() {
     return list_.size();
 }
 
+void LRUReplacer::Resize(frame_id_t num_pages) {
+    std::lock_guard<std::mutex> lock(latch_);
+    for (auto iter = list_.begin();iter != list_.end();) {
+        if (*iter >= num_pages) {
+            table_.erase(*iter);
+            iter = list_.erase(iter);
+        } else {
+            iter ++;
+        }
+    }
+}
+
+std::vector<frame_id_t> LRUReplacer::GetFramesByRecency() {
+    std::lock_guard<std::mutex> lock(latch_);
+    // the tail of queue is the most recently unpinned
+    return std::vector<frame_id_t>(list_.rbegin(), list_.rend());
+}
+
 
 void LRUReplacer::PrintLRU() {
     std::cout << "Print start" << std::endl;
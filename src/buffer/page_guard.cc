@@ -0,0 +1,92 @@
+#ifndef PAGE_GUARD_CC
+#define PAGE_GUARD_CC
+
+#include "buffer/page_guard.h"
+#include "buffer/buffer_manager.h"
+
+namespace SimpleDB {
+
+BasicPageGuard::BasicPageGuard(BasicPageGuard &&that) noexcept
+    : bpm_(that.bpm_), buffer_(that.buffer_), is_dirty_(that.is_dirty_) {
+    that.bpm_ = nullptr;
+    that.buffer_ = nullptr;
+    that.is_dirty_ = false;
+}
+
+
+BasicPageGuard& BasicPageGuard::operator=(BasicPageGuard &&that) noexcept {
+    if (&that != this) {
+        Drop();
+        bpm_ = that.bpm_;
+        buffer_ = that.buffer_;
+        is_dirty_ = that.is_dirty_;
+        that.bpm_ = nullptr;
+        that.buffer_ = nullptr;
+        that.is_dirty_ = false;
+    }
+    return *this;
+}
+
+
+void BasicPageGuard::Drop() {
+    if (buffer_ != nullptr) {
+        bpm_->UnpinBlock(buffer_, is_dirty_);
+    }
+    bpm_ = nullptr;
+    buffer_ = nullptr;
+    is_dirty_ = false;
+}
+
+
+Buffer* BasicPageGuard::Release() {
+    auto *buffer = buffer_;
+    bpm_ = nullptr;
+    buffer_ = nullptr;
+    is_dirty_ = false;
+    return buffer;
+}
+
+
+
+ReadPageGuard& ReadPageGuard::operator=(ReadPageGuard &&that) noexcept {
+    if (&that != this) {
+        Drop();
+        guard_ = std::move(that.guard_);
+    }
+    return *this;
+}
+
+
+void ReadPageGuard::Drop() {
+    if (guard_.IsValid()) {
+        guard_.GetBuffer()->RUnlock();
+    }
+    guard_.Drop();
+}
+
+
+Buffer* ReadPageGuard::Release() {
+    return guard_.Release();
+}
+
+
+
+WritePageGuard& WritePageGuard::operator=(WritePageGuard &&that) noexcept {
+    if (&that != this) {
+        Drop();
+        guard_ = std::move(that.guard_);
+    }
+    return *this;
+}
+
+
+void WritePageGuard::Drop() {
+    if (guard_.IsValid()) {
+        guard_.GetBuffer()->WUnlock();
+    }
+    guard_.Drop();
+}
+
+} // namespace SimpleDB
+
+#endif
@@ -7,13 +7,14 @@
 namespace SimpleDB {
 
 std::unique_ptr<Transaction> TransactionManager::Begin
-(IsoLationLevel level) {
+(IsoLationLevel level, bool async_commit) {
     
     // get txn_id
     txn_id_t txn_id = txn_map_->GetNextTransactionID();
     
     // create a new txn
     auto txn = std::make_unique<Transaction>(file_manager_, buffer_manager_, lock_mgr_.get(), txn_id, level);
+    txn->SetAsyncCommit(async_commit);
     
     // insert into txn_map
     txn_map_->InsertTransaction(txn.get());
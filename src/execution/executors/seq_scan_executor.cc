@@ -12,7 +12,8 @@ void SeqScanExecutor::Init() {
     table_info_ = content_->GetMetadataMgr()->GetTable(node.table_name_, txn_);
     
     table_schema_ = &table_info_->schema_;
-    iterator_ = table_info_->table_heap_->Begin(txn_);
+    // a scan of large table should not destroy the working set of bufferpool
+    iterator_ = table_info_->table_heap_->Begin(txn_, true);
 }
 
 
@@ -0,0 +1,363 @@
+#ifndef ASYNC_IO_CC
+#define ASYNC_IO_CC
+
+#include "file/async_io.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define SIMPLEDB_HAVE_IO_URING
+#endif
+#endif
+
+namespace SimpleDB {
+
+void IOCompletion::Wait() {
+    std::unique_lock<std::mutex> lock(latch_);
+    cv_.wait(lock, [this]() { return remaining_ == 0; });
+
+    if (failed_) {
+        throw std::runtime_error("I/O error when execute a batch of blocks");
+    }
+}
+
+bool IOCompletion::IsDone() {
+    std::lock_guard<std::mutex> lock(latch_);
+    return remaining_ == 0;
+}
+
+void IOCompletion::Complete(bool success) {
+    // count it before waking up the waiter, who may destroy the stats
+    if (latency_ != nullptr) {
+        latency_->Record(std::chrono::steady_clock::now() - submit_time_);
+        bytes_->Add(io_size_);
+    }
+
+    std::lock_guard<std::mutex> lock(latch_);
+    failed_ |= !success;
+    if (--remaining_ == 0) {
+        cv_.notify_all();
+    }
+}
+
+
+
+AsyncIO::AsyncIO(int queue_depth, int worker_num) {
+    if (SetupUring(queue_depth)) {
+        reaper_ = std::thread(&AsyncIO::ReapLoop, this);
+        return;
+    }
+
+    // io_uring is not available, fallback to thread pool
+    for (int i = 0;i < worker_num;i ++) {
+        workers_.emplace_back(&AsyncIO::WorkerLoop, this);
+    }
+}
+
+AsyncIO::~AsyncIO() {
+#ifdef SIMPLEDB_HAVE_IO_URING
+    if (ring_fd_ != -1) {
+        {
+            // wait for all ios in flight, then wakeup the reaper by a nop
+            std::unique_lock<std::mutex> lock(latch_);
+            cv_.wait(lock, [this]() { return in_flight_ == 0; });
+
+            stop_ = true;
+            unsigned tail = *sq_tail_;
+            unsigned index = tail & *sq_mask_;
+            auto *sqe = static_cast<struct io_uring_sqe*>(sqes_ptr_) + index;
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_NOP;
+            sqe->user_data = 0;
+            sq_array_[index] = index;
+            __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+            syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0);
+        }
+
+        reaper_.join();
+        munmap(sqes_ptr_, sqes_size_);
+        if (cq_ptr_ != sq_ptr_) {
+            munmap(cq_ptr_, cq_ring_size_);
+        }
+        munmap(sq_ptr_, sq_ring_size_);
+        close(ring_fd_);
+        return;
+    }
+#endif
+
+    {
+        std::lock_guard<std::mutex> lock(latch_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &t : workers_) {
+        t.join();
+    }
+}
+
+
+void AsyncIO::Submit(const std::vector<IOTask> &tasks,
+                     const std::shared_ptr<IOCompletion> &completion) {
+    if (ring_fd_ != -1) {
+        SubmitToUring(tasks, completion);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(latch_);
+        for (auto &task : tasks) {
+            queue_.emplace_back(task, completion);
+        }
+    }
+    cv_.notify_all();
+}
+
+
+bool AsyncIO::ExecuteTask(const IOTask &task) {
+    int count = 0;
+
+    while (count < task.size_) {
+        int res;
+        if (task.is_write_) {
+            res = pwrite(task.fd_, task.buf_ + count, task.size_ - count, task.offset_ + count);
+        } else {
+            res = pread(task.fd_, task.buf_ + count, task.size_ - count, task.offset_ + count);
+        }
+
+        if (res == -1 && errno == EINTR) {
+            continue;
+        }
+        if (res == -1) {
+            return false;
+        }
+        if (res == 0) {
+            if (task.is_write_) {
+                return false;
+            }
+            // read past end of file, set those to zero
+            memset(task.buf_ + count, 0, task.size_ - count);
+            break;
+        }
+        count += res;
+    }
+
+    return true;
+}
+
+
+void AsyncIO::WorkerLoop() {
+    while (true) {
+        std::unique_lock<std::mutex> lock(latch_);
+        cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+
+        // finish all ios before exit
+        if (queue_.empty()) {
+            return;
+        }
+
+        auto request = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+
+        request.second->Complete(ExecuteTask(request.first));
+    }
+}
+
+
+#ifdef SIMPLEDB_HAVE_IO_URING
+
+bool AsyncIO::SetupUring(int entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0) {
+        return false;
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        sq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+        cq_ring_size_ = sq_ring_size_;
+    }
+
+    sq_ptr_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        cq_ptr_ = sq_ptr_;
+    } else {
+        cq_ptr_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cq_ptr_ == MAP_FAILED) {
+            munmap(sq_ptr_, sq_ring_size_);
+            close(fd);
+            return false;
+        }
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes_ptr_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes_ptr_ == MAP_FAILED) {
+        if (cq_ptr_ != sq_ptr_) {
+            munmap(cq_ptr_, cq_ring_size_);
+        }
+        munmap(sq_ptr_, sq_ring_size_);
+        close(fd);
+        return false;
+    }
+
+    char *sq = static_cast<char*>(sq_ptr_);
+    char *cq = static_cast<char*>(cq_ptr_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ptr_ = cq + params.cq_off.cqes;
+    sq_entries_ = params.sq_entries;
+    ring_fd_ = fd;
+    return true;
+}
+
+
+void AsyncIO::SubmitToUring(const std::vector<IOTask> &tasks,
+                            const std::shared_ptr<IOCompletion> &completion) {
+    size_t next = 0;
+
+    while (next < tasks.size()) {
+        std::unique_lock<std::mutex> lock(latch_);
+        // only the ios which can be reaped are put into submission queue,
+        // so completion queue will never overflow
+        cv_.wait(lock, [this]() { return in_flight_ < sq_entries_ - 1; });
+
+        unsigned tail = *sq_tail_;
+        unsigned to_submit = 0;
+        while (next < tasks.size() && in_flight_ < sq_entries_ - 1) {
+            auto *request = new UringRequest{tasks[next], completion, {}};
+            request->iov_.iov_base = request->task_.buf_;
+            request->iov_.iov_len = request->task_.size_;
+
+            unsigned index = (tail + to_submit) & *sq_mask_;
+            auto *sqe = static_cast<struct io_uring_sqe*>(sqes_ptr_) + index;
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = request->task_.is_write_ ? IORING_OP_WRITEV : IORING_OP_READV;
+            sqe->fd = request->task_.fd_;
+            sqe->addr = reinterpret_cast<uint64_t>(&request->iov_);
+            sqe->len = 1;
+            sqe->off = request->task_.offset_;
+            sqe->user_data = reinterpret_cast<uint64_t>(request);
+            sq_array_[index] = index;
+
+            to_submit ++;
+            in_flight_ ++;
+            next ++;
+        }
+
+        // make sqes visible to kernel before updating tail
+        __atomic_store_n(sq_tail_, tail + to_submit, __ATOMIC_RELEASE);
+        while (to_submit > 0) {
+            int res = syscall(__NR_io_uring_enter, ring_fd_, to_submit, 0, 0, nullptr, 0);
+            if (res < 0) {
+                if (errno == EINTR || errno == EAGAIN) {
+                    continue;
+                }
+                throw std::runtime_error("I/O error when submit a batch of blocks");
+            }
+            to_submit -= res;
+        }
+    }
+}
+
+
+void AsyncIO::ReapLoop() {
+    while (true) {
+        unsigned head = *cq_head_;
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+
+        if (head == tail) {
+            // nothing to reap, wait for at least one completion
+            syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            continue;
+        }
+
+        auto *cqes = static_cast<struct io_uring_cqe*>(cqes_ptr_);
+        int reaped = 0;
+        bool exit = false;
+        while (head != tail) {
+            auto *cqe = cqes + (head & *cq_mask_);
+            auto *request = reinterpret_cast<UringRequest*>(cqe->user_data);
+            int res = cqe->res;
+            head ++;
+
+            if (request == nullptr) {
+                // nop which is submitted by destructor
+                exit = stop_;
+                continue;
+            }
+
+            bool success;
+            if (res == request->task_.size_) {
+                success = true;
+            } else if (res >= 0 || res == -EINTR || res == -EAGAIN) {
+                // short io, finish the rest synchronously
+                IOTask rest = request->task_;
+                int done = res > 0 ? res : 0;
+                rest.buf_ += done;
+                rest.size_ -= done;
+                rest.offset_ += done;
+                success = ExecuteTask(rest);
+            } else {
+                success = false;
+            }
+
+            request->completion_->Complete(success);
+            delete request;
+            reaped ++;
+        }
+
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+        {
+            std::lock_guard<std::mutex> lock(latch_);
+            in_flight_ -= reaped;
+        }
+        cv_.notify_all();
+
+        if (exit) {
+            return;
+        }
+    }
+}
+
+#else
+
+bool AsyncIO::SetupUring(int entries) {
+    return false;
+}
+
+void AsyncIO::SubmitToUring(const std::vector<IOTask> &tasks,
+                            const std::shared_ptr<IOCompletion> &completion) {}
+
+void AsyncIO::ReapLoop() {}
+
+#endif
+
+} // namespace SimpleDB
+
+#endif
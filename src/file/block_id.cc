@@ -7,7 +7,7 @@ namespace SimpleDB {
 
 bool operator == (const BlockId &lobj, const BlockId &robj) {
     return (lobj.block_num_ == robj.block_num_) &&
-           (lobj.file_name_ == robj.file_name_);
+           (lobj.file_id_ == robj.file_id_);
 }
 
 bool operator != (const BlockId &lobj, const BlockId &robj) {
@@ -19,17 +19,17 @@ bool operator != (const BlockId &lobj, const BlockId &robj) {
 }
 
 bool operator < (const BlockId &lobj, const BlockId &robj) {
-    if(lobj.file_name_ == robj.file_name_) {
+    if(lobj.file_id_ == robj.file_id_) {
         return lobj.block_num_ < robj.block_num_;
     }
-    return lobj.file_name_ < robj.file_name_;
+    return lobj.file_id_ < robj.file_id_;
 }
 
 bool operator > (const BlockId &lobj, const BlockId &robj) {
-    if(lobj.file_name_ == robj.file_name_) {
+    if(lobj.file_id_ == robj.file_id_) {
         return lobj.block_num_ > robj.block_num_;
     }        
-    return lobj.file_name_ > robj.file_name_;
+    return lobj.file_id_ > robj.file_id_;
 }
 
 bool operator <= (const BlockId &lobj, const BlockId &robj) {
@@ -48,29 +48,17 @@ bool operator >= (const BlockId &lobj, const BlockId &robj) {
     }
 }
 
-BlockId& BlockId::operator= (const BlockId &obj) {
-    if (this != &obj) {
-        block_num_ = obj.block_num_;
-        file_name_ = obj.file_name_;
-    }
-    return *this;
-}
-
-std::string BlockId::FileName() const {
-    return file_name_;    
-}
-
 int BlockId::BlockNum() const {
     return block_num_;
 }
 
 bool BlockId::equals(const BlockId &obj) const {
-    return obj.file_name_ == file_name_ &&
+    return obj.file_id_ == file_id_ &&
            obj.block_num_ == block_num_;
 }
 
 std::string BlockId::to_string() const {
-    std::string temp = "filename = " + file_name_ + ","
+    std::string temp = "filename = " + FileName() + ","
                        "blocknum = " + std::to_string(block_num_);
     return temp;
 }
@@ -2,19 +2,25 @@
 #define FILE_MANAGER_CC
 
 #include "file/file_manager.h"
+#include "config/config.h"
+#include "config/macro.h"
 
 #include <iostream>
 #include <sys/stat.h>
 #include <filesystem>
 #include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <algorithm>
 #include <cstring>
 #include <time.h>
 
 namespace SimpleDB {
 
 // if the directory is not exist, we should create new one
-FileManager::FileManager(const std::string &db_directory, int block_size) : 
-    directory_name_(db_directory),block_size_(block_size) {
+FileManager::FileManager(const std::string &db_directory, int block_size, bool direct_io) : 
+    directory_name_(db_directory),block_size_(block_size),
+    direct_io_(direct_io && block_size % SIMPLEDB_DIRECT_IO_ALIGNMENT == 0) {
     std::string cmd;
 
     // check if the file exist, if not we should create a new one
@@ -31,43 +37,38 @@ FileManager::FileManager(const std::string &db_directory, int block_size) :
 }
 
 
+FileManager::~FileManager() {
+    // wait for ios in flight before closing files
+    async_io_.reset();
+    for (auto &t : open_files_) {
+        close(t.second->fd_);
+    }
+}
+
 
 void FileManager::Read(const BlockId &block, Page *page) {
     // we should consider three things
-    // 1. read past end of file 
+    // 1. read past end of file
     // 2. io error
     // 3. read less than a block
+    // pread doesn't move the file offset, so no latch is needed here
 
+    auto *file = GetFile(block.FileName());
+    int offset = block.BlockNum() * block_size_;
+    auto start = std::chrono::steady_clock::now();
+    int read_count = PositionalRead(file, page->GetRawDataPtr(), block_size_, offset);
+    read_latency_.Record(std::chrono::steady_clock::now() - start);
+    read_bytes_.Add(read_count);
 
-    std::lock_guard<std::mutex> lock(latch_); /* mutex lock! */
-    std::string file_name = block.FileName();
-    int block_number = block.BlockNum();
-    int offset = block_number * block_size_;
-    auto file_io = GetFile(file_name);
-    int read_count;
-
-
-    // call the GetFileSize func everytime?
-    // TODO: we need to cache it
-    if(offset > GetFileSize(file_name)) {
+    if (read_count == 0) {
         std::cerr << "read past end of file" << std::endl;
-        memset(page->GetRawDataPtr(), 0, block_size_); 
+        memset(page->GetRawDataPtr(), 0, block_size_);
         return;
     }
 
-
-    // seek to the location you want to read, seekp and seekg work the same
-    file_io->seekp(offset);
-    file_io->read(page->GetRawDataPtr(), block_size_);
-    if(file_io->bad()) {
-        throw std::runtime_error("I/O error when read a block");
-    }
-
-    // if read less than a block    
-    read_count = file_io->gcount();
-    if(read_count < block_size_) {
+    // if read less than a block
+    if (read_count < block_size_) {
         std::cerr << "read less than a block" << std::endl;
-        file_io->clear();
         // set those to zero
         memset(page->GetRawDataPtr() + read_count, 0, block_size_ - read_count);
         return;
@@ -75,181 +76,275 @@ void FileManager::Read(const BlockId &block, Page *page) {
 }
 
 
-void FileManager::Write(const BlockId &block, Page *page) { 
-    // Write can extend the file, 
+void FileManager::Write(const BlockId &block, Page *page) {
+    // Write can extend the file,
     // so it can write past the end of file
-    std::lock_guard<std::mutex> lock(latch_); 
-    std::string file_name = block.FileName();
-    int block_number = block.BlockNum();
-    int offset = block_number * block_size_;
-    auto file_io = GetFile(file_name);
-
-    
-    file_io->seekp(offset, std::ios::beg);
-    file_io->write(page->GetRawDataPtr(), block_size_);
-    if(file_io->bad()) {
-        throw std::runtime_error("I/O error when write a block");
-    }
-    
+    auto *file = GetFile(block.FileName());
+    int offset = block.BlockNum() * block_size_;
+
+    // pwrite hands the data to os directly, there is no
+    // user-space buffer which should be flushed
+    auto start = std::chrono::steady_clock::now();
+    PositionalWrite(file, page->GetRawDataPtr(), block_size_, offset);
+    write_latency_.Record(std::chrono::steady_clock::now() - start);
+    write_bytes_.Add(block_size_);
+    ExtendBlockNum(file, block.BlockNum() + 1);
+    MarkWritten(file);
+}
+
+
+std::shared_ptr<IOCompletion> FileManager::SubmitRead(const std::vector<BlockId> &blocks,
+                                                      const std::vector<Page*> &pages) {
+    return SubmitBatch(blocks, pages, false);
+}
 
-    // write to disk immediately, we don't want data stored in buf of io_stream
-    file_io->flush();
+std::shared_ptr<IOCompletion> FileManager::SubmitWrite(const std::vector<BlockId> &blocks,
+                                                       const std::vector<Page*> &pages) {
+    return SubmitBatch(blocks, pages, true);
 }
 
+void FileManager::ReadBatch(const std::vector<BlockId> &blocks,
+                            const std::vector<Page*> &pages) {
+    SubmitRead(blocks, pages)->Wait();
+}
 
-void FileManager::ReadLog(const std::string &log_name, int offset, Page &page) {
-    std::lock_guard<std::mutex> lock(latch_);
-    auto log_io = GetLogFile(log_name);
-    int read_count;
+void FileManager::WriteBatch(const std::vector<BlockId> &blocks,
+                             const std::vector<Page*> &pages) {
+    SubmitWrite(blocks, pages)->Wait();
 
-    // check if read past  end of file
-    if(offset > GetFileSize(log_name)) {
-        std::cerr << "read past end of file" << std::endl;
-        memset(&((*page.content())[0]),0,block_size_); 
-        return;
+    if (write_through_) {
+        // sync once for the whole batch, the files have been marked dirty
+        for (auto &block : blocks) {
+            Sync(block.FileName());
+        }
     }
+}
 
+IOStatsSnapshot FileManager::GetIOStats() const {
+    IOStatsSnapshot stats;
+    stats.read_latency_ = read_latency_.GetSnapshot();
+    stats.write_latency_ = write_latency_.GetSnapshot();
+    stats.read_num_ = stats.read_latency_.count_;
+    stats.write_num_ = stats.write_latency_.count_;
+    stats.read_bytes_ = read_bytes_.Get();
+    stats.write_bytes_ = write_bytes_.Get();
+    return stats;
+}
+
+void FileManager::Sync(const std::string &file_name) {
+    SyncFile(GetFile(file_name));
+}
 
-    // seek to the location you want to read, seekp and seekg work the same
-    log_io->seekp(offset, std::ios::beg);
-    log_io->read(&((*page.content())[0]), block_size_);
-    if(log_io->bad()) {
-        throw std::runtime_error("I/O error when read a log");
+void FileManager::SyncAll() {
+    std::vector<FileHandle*> files;
+    {
+        ReaderGuard guard(latch_);
+        // a clean file may still be syncing the writes before, so
+        // SyncFile is called for every file to wait for it
+        for (auto &t : open_files_) {
+            files.push_back(t.second.get());
+        }
     }
-    
 
-    read_count = log_io->gcount();
-    if(read_count < block_size_) {
-        log_io->clear();
-        memset(&((*page.content())[0]) + read_count, 0, block_size_ - read_count);
-        return;
+    // don't hold the latch during syncing, so files can be opened concurrently
+    for (auto *file : files) {
+        SyncFile(file);
+    }
+}
+
+void FileManager::MarkWritten(FileHandle *file) {
+    file->dirty_ = true;
+    if (write_through_) {
+        SyncFile(file);
     }
 }
 
-void FileManager::WriteLog(const std::string &log_name, int size, Page &page) {
-    if (size == 0) {
+void FileManager::SyncFile(FileHandle *file) {
+    // clear the flag before syncing, the writes after that
+    // will set it again and be synced next time. the latch is held
+    // across syncing, otherwise a caller which sees the flag cleared
+    // by an unfinished sync would return before its writes are durable
+    std::lock_guard<std::mutex> sync_latch(file->sync_latch_);
+    if (!file->dirty_.exchange(false)) {
         return;
     }
 
-    std::lock_guard<std::mutex> lock(latch_); /* mutex lock! */
-    auto log_io = GetLogFile(log_name);
-    log_io->write(&((*page.content())[0]), size);
+    if (fdatasync(file->fd_) == -1) {
+        file->dirty_ = true;
+        throw std::runtime_error("I/O error when sync a file");
+    }
+}
+
+std::shared_ptr<IOCompletion> FileManager::SubmitBatch(const std::vector<BlockId> &blocks,
+                                                       const std::vector<Page*> &pages,
+                                                       bool is_write) {
+    SIMPLEDB_ASSERT(blocks.size() == pages.size(), "the number of blocks and pages should be same");
+
+    int io_count = static_cast<int> (blocks.size());
+    auto completion = std::make_shared<IOCompletion>(io_count);
+    if (io_count == 0) {
+        return completion;
+    }
+
+    if (is_write) {
+        completion->SetStats(&write_latency_, &write_bytes_, block_size_);
+    } else {
+        completion->SetStats(&read_latency_, &read_bytes_, block_size_);
+    }
+
+    std::vector<IOTask> tasks;
+    tasks.reserve(io_count);
+    for (int i = 0;i < io_count;i ++) {
+        auto *file = GetFile(blocks[i].FileName());
+        char *buf = pages[i]->GetRawDataPtr();
+        int offset = blocks[i].BlockNum() * block_size_;
+
+        if (NeedBounce(file, buf)) {
+            // execute it synchronously through an aligned page
+            bool success = true;
+            try {
+                if (is_write) {
+                    PositionalWrite(file, buf, block_size_, offset);
+                } else {
+                    int read_count = PositionalRead(file, buf, block_size_, offset);
+                    memset(buf + read_count, 0, block_size_ - read_count);
+                }
+            } catch (std::runtime_error &) {
+                success = false;
+            }
+
+            if (is_write) {
+                ExtendBlockNum(file, blocks[i].BlockNum() + 1);
+                file->dirty_ = true;
+            }
+            completion->Complete(success);
+            continue;
+        }
 
-    if(log_io->bad()) {
-        throw std::runtime_error("I/O error when write a log");
+        tasks.push_back({file->fd_, buf, block_size_, offset, is_write});
+        if (is_write) {
+            // the size is raised when submitting, so readers of the
+            // size should wait for completion before using these blocks
+            ExtendBlockNum(file, blocks[i].BlockNum() + 1);
+            file->dirty_ = true;
+        }
     }
 
+    if (!tasks.empty()) {
+        GetAsyncIO()->Submit(tasks, completion);
+    }
+    return completion;
+}
 
-    // write to disk immediately
-    log_io->flush();
+AsyncIO* FileManager::GetAsyncIO() {
+    std::call_once(async_io_flag_, [this]() {
+        async_io_ = std::make_unique<AsyncIO>(SIMPLEDB_IO_QUEUE_DEPTH, SIMPLEDB_IO_WORKER_NUM);
+    });
+    return async_io_.get();
 }
 
 
 BlockId FileManager::Append(const std::string &file_name) {
     // By writing to next logical block to file that not belonging to us
     // The OS will automatically complete the extension
-    
-    std::lock_guard<std::mutex> lock(latch_); /* mutex lock! */
-    auto file_io = GetFile(file_name);
+
+    auto *file = GetFile(file_name);
     std::vector<char> empty_array(block_size_, 0);
-    int next_block_num = GetFileBlockNum(file_name);
-    BlockId new_block_id(file_name, next_block_num);
-    int offset = next_block_num * block_size_;
 
+    // only the appenders of the same file should wait for each other
+    std::lock_guard<std::mutex> lock(file->latch_);
+    int next_block_num = file->block_num_;
+    BlockId new_block_id(file_name, next_block_num);
 
-    // write a blank_block to disk
-    file_io->seekp(offset, std::ios::beg);
-    file_io->write(&(empty_array[0]), block_size_);
-    if(file_io->bad()) {
-        throw std::runtime_error("I/O error when append a block");
-    }
-    
-    // write to disk immediately
-    file_io->flush();
+    // the space of new block is allocated by extent, writing
+    // a blank_block to disk only moves the high-water mark
+    Preallocate(file, next_block_num);
+    PositionalWrite(file, &empty_array[0], block_size_, next_block_num * block_size_);
+    ExtendBlockNum(file, next_block_num + 1);
+    MarkWritten(file);
     return new_block_id;
 }
 
 
-std::fstream* FileManager::GetFile(const std::string &file_name) {
-    // 1. first, check whether the file has been opened
-    // 2. if the file exists but has not opened, we need to open it
-    // 3. if the file is not exist, we also need to create it
-    // 4. remeber that put it in open_files_ for caching it
+void FileManager::ExtendBlockNum(FileHandle *file, int block_num) {
+    int old_num = file->block_num_;
+    while (old_num < block_num &&
+           !file->block_num_.compare_exchange_weak(old_num, block_num)) {}
+}
 
-    std::string file_path = directory_name_ + "/" + file_name;
-    
-    // search the hash-table
-    if(open_files_.find(file_name) != open_files_.end()) {
-        if(open_files_[file_name]->is_open()) { /* file is being opened */
-            return open_files_[file_name].get();
+
+void FileManager::Preallocate(FileHandle *file, int block_num) {
+    if (!file->can_preallocate_ || block_num < file->allocated_num_) {
+        return;
+    }
+
+    // keep the size of file, so that size of file is still the
+    // high-water mark after restarting
+    int extent_begin = std::max(block_num, file->allocated_num_);
+    int res = fallocate(file->fd_, FALLOC_FL_KEEP_SIZE,
+                        static_cast<off_t>(extent_begin) * block_size_,
+                        static_cast<off_t>(SIMPLEDB_EXTENT_BLOCK_NUM) * block_size_);
+    if (res == -1) {
+        // the file system doesn't support it, the file grows block by block
+        if (errno == EOPNOTSUPP || errno == ENOSYS) {
+            file->can_preallocate_ = false;
         }
+        return;
     }
 
-    auto file_io = std::make_unique<std::fstream>();
+    file->allocated_num_ = extent_begin + SIMPLEDB_EXTENT_BLOCK_NUM;
+}
 
-    // file is not opened
-    file_io->open(file_path, std::ios::binary | std::ios::in | std::ios::out);
-    if(!file_io->is_open()) {
-        // clear bad status
-        file_io->clear();
 
-        // create new file, use trunc to make sure to overwrite the original file content
-        file_io->open(file_path, std::ios::binary | std::ios::in | 
-                                 std::ios::out | std::ios::trunc);
+FileManager::FileHandle* FileManager::GetFile(const std::string &file_name) {
+    return OpenFile(file_name, direct_io_ ? O_DIRECT : 0);
+}
 
+FileManager::FileHandle* FileManager::OpenFile(const std::string &file_name, int flags) {
+    // 1. first, check whether the file has been opened
+    // 2. if the file exists but has not opened, we need to open it
+    // 3. if the file is not exist, we also need to create it
+    // 4. remeber that put it in open_files_ for caching it
 
-        // reopen the file with original mode
-        file_io->close();
-        file_io->open(file_path, std::ios::binary | std::ios::in | std::ios::out);
-        if(!file_io->is_open()) { 
-            throw std::runtime_error("can't open file " + file_name);
+    {
+        ReaderGuard guard(latch_);
+        auto iter = open_files_.find(file_name);
+        if (iter != open_files_.end()) {
+            return iter->second.get();
         }
     }
 
+    WriterGuard guard(latch_);
 
-    // put it in open_files_
-    open_files_[file_name] = std::move(file_io);
-    return open_files_[file_name].get();
-}
+    // double check, other thread may open it before we acquire x-latch
+    auto iter = open_files_.find(file_name);
+    if (iter != open_files_.end()) {
+        return iter->second.get();
+    }
 
-std::fstream* FileManager::GetLogFile(const std::string &log_name) {
-    std::string file_path = directory_name_ + "/" + log_name;
-    
-    // search the hash-table
-    if(open_files_.find(log_name) != open_files_.end()) {
-        // the file has been created
-        if(open_files_[log_name]->is_open()) {
-            return open_files_[log_name].get();
-        }
+    std::string file_path = directory_name_ + "/" + file_name;
+    int fd = open(file_path.c_str(), O_RDWR | O_CREAT | flags, 0666);
+    if (fd == -1 && errno == EINVAL && (flags & O_DIRECT)) {
+        // the file system doesn't support direct io, fallback to buffered io
+        flags &= ~O_DIRECT;
+        fd = open(file_path.c_str(), O_RDWR | O_CREAT | flags, 0666);
     }
-    
-    auto log_io = std::make_unique<std::fstream>();
-
-    // file is not opened
-    // we should open this file with app mode
-    log_io->open(file_path, std::ios::binary | std::ios::in | 
-                            std::ios::out | std::ios::app);
-    if(!log_io->is_open()) { /* the file is not created */
-        // clear bad statu to ensure that normally operation
-        log_io->clear();
-
-        // create new file, use trunc to make sure to overwrite the original file content
-        log_io->open(file_path, std::ios::binary | std::ios::in | 
-                                std::ios::out | std::ios::trunc);
-        
-        // reopen the file with app mode to ensure sequential write
-        log_io->close();
-        log_io->open(file_path, std::ios::binary | std::ios::in | 
-                                std::ios::out | std::ios::app);
-        
-        if(!log_io->is_open()) { 
-            throw std::runtime_error("can't open log " + log_name);
-        }
+    if (fd == -1) {
+        throw std::runtime_error("can't open file " + file_name);
+    }
+
+    // the high-water mark is the size of file
+    struct stat stat_buf;
+    if (fstat(fd, &stat_buf) == -1) {
+        close(fd);
+        throw std::runtime_error("can't stat file " + file_name);
     }
-    
+
     // put it in open_files_
-    open_files_[log_name] = std::move(log_io);
-    return open_files_[log_name].get();
+    auto *file = new FileHandle(fd, flags & O_DIRECT, 
+                                static_cast<int>(stat_buf.st_size / block_size_));
+    open_files_[file_name] = std::unique_ptr<FileHandle>(file);
+    return file;
 }
 
 
@@ -261,15 +356,82 @@ int FileManager::GetFileSize(const std::string &file_name) {
     return success == 0 ? static_cast<int> (stat_buf.st_size) : 0;
 }
 
+bool FileManager::IsFileExist(const std::string &file_name) const {
+    return access(GetFilePath(file_name).c_str(), F_OK) == 0;
+}
+
 void FileManager::SetFileSize(const std::string &file_name, int block_num) {
-    std::string file_path = directory_name_ + "/" + file_name;
-    int success = truncate(file_path.c_str(), block_num * block_size_);
+    auto *file = GetFile(file_name);
+    std::lock_guard<std::mutex> lock(file->latch_);
+    int success = ftruncate(file->fd_, block_num * block_size_);
 
     if (success == -1) {
         SIMPLEDB_ASSERT(false, "truncate file error");
     }
+
+    // the preallocated space past the new size is freed too
+    file->block_num_ = block_num;
+    file->allocated_num_ = block_num;
+    MarkWritten(file);
+}
+
+
+int FileManager::PositionalRead(FileHandle *file, char *buf, int size, int offset) {
+    if (NeedBounce(file, buf)) {
+        Page bounce(size, SIMPLEDB_DIRECT_IO_ALIGNMENT);
+        int read_count = PositionalRead(file, bounce.GetRawDataPtr(), size, offset);
+        memcpy(buf, bounce.GetRawDataPtr(), read_count);
+        return read_count;
+    }
+
+    int fd = file->fd_;
+    int read_count = 0;
+
+    while (read_count < size) {
+        int res = pread(fd, buf + read_count, size - read_count, offset + read_count);
+        if (res == -1 && errno == EINTR) {
+            continue;
+        }
+        if (res == -1) {
+            throw std::runtime_error("I/O error when read a block");
+        }
+        if (res == 0) { /* eof */
+            break;
+        }
+        read_count += res;
+    }
+
+    return read_count;
+}
+
+void FileManager::PositionalWrite(FileHandle *file, const char *buf, int size, int offset) {
+    if (NeedBounce(file, buf)) {
+        Page bounce(size, SIMPLEDB_DIRECT_IO_ALIGNMENT);
+        memcpy(bounce.GetRawDataPtr(), buf, size);
+        PositionalWrite(file, bounce.GetRawDataPtr(), size, offset);
+        return;
+    }
+
+    int fd = file->fd_;
+    int write_count = 0;
+
+    while (write_count < size) {
+        int res = pwrite(fd, buf + write_count, size - write_count, offset + write_count);
+        if (res == -1 && errno == EINTR) {
+            continue;
+        }
+        if (res <= 0) {
+            throw std::runtime_error("I/O error when write a block");
+        }
+        write_count += res;
+    }
+}
+
+bool FileManager::NeedBounce(FileHandle *file, const char *buf) {
+    return file->direct_ &&
+           reinterpret_cast<uintptr_t>(buf) % SIMPLEDB_DIRECT_IO_ALIGNMENT != 0;
 }
 
 } // namespace SimpleDB
 
-#endif
\ No newline at end of file
+#endif
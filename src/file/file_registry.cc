@@ -0,0 +1,84 @@
+#ifndef FILE_REGISTRY_CC
+#define FILE_REGISTRY_CC
+
+#include "file/file_registry.h"
+#include "config/macro.h"
+
+#include <mutex>
+
+namespace SimpleDB {
+
+FileRegistry& FileRegistry::GetInstance() {
+    // chunks are never freed, so the names outlive every static BlockId
+    static FileRegistry *registry = new FileRegistry();
+    return *registry;
+}
+
+
+FileRegistry::FileRegistry() {
+    for (auto &chunk : chunks_) {
+        chunk.store(nullptr, std::memory_order_relaxed);
+    }
+
+    // the default BlockId uses id 0, whose name is empty
+    GetFileId("");
+}
+
+
+uint32_t FileRegistry::GetFileId(const std::string &file_name) {
+    // most lookups ask for the same file again
+    thread_local std::string last_name;
+    thread_local uint32_t last_id = 0;
+    thread_local FileRegistry *last_registry = nullptr;
+    if (last_registry == this && last_name == file_name) {
+        return last_id;
+    }
+
+    uint32_t file_id = INVALID_FILE_ID;
+    {
+        std::shared_lock<std::shared_mutex> lock(latch_);
+        auto iter = file_ids_.find(file_name);
+        if (iter != file_ids_.end()) {
+            file_id = iter->second;
+        }
+    }
+
+    if (file_id == INVALID_FILE_ID) {
+        file_id = Register(file_name);
+    }
+
+    last_registry = this;
+    last_name = file_name;
+    last_id = file_id;
+    return file_id;
+}
+
+
+uint32_t FileRegistry::Register(const std::string &file_name) {
+    std::unique_lock<std::shared_mutex> lock(latch_);
+    
+    // someone may register it before we get the latch
+    auto iter = file_ids_.find(file_name);
+    if (iter != file_ids_.end()) {
+        return iter->second;
+    }
+
+    uint32_t file_id = next_id_;
+    uint32_t chunk_id = file_id >> CHUNK_BITS;
+    SIMPLEDB_ASSERT(chunk_id < MAX_CHUNK_NUM, "too many files");
+    auto *chunk = chunks_[chunk_id].load(std::memory_order_relaxed);
+    if (chunk == nullptr) {
+        chunk = new std::string[CHUNK_SIZE];
+        chunks_[chunk_id].store(chunk, std::memory_order_release);
+    }
+
+    // the name is written before the id is published
+    chunk[file_id & (CHUNK_SIZE - 1)] = file_name;
+    file_ids_[file_name] = file_id;
+    next_id_.store(file_id + 1, std::memory_order_release);
+    return file_id;
+}
+
+} // namespace SimpleDB
+
+#endif
@@ -4,6 +4,7 @@
 #include "file/page.h"
 
 #include <iostream>
+#include <cstdlib>
 #include <cstring>
 
 namespace SimpleDB {
@@ -12,12 +13,12 @@ char Page::GetByte(int offset) const {
     char* page_offset;
     int res;
     
-    if(offset + sizeof(char) > content_->size()) { 
+    if(offset + sizeof(char) > size_) { 
         // overflow
         throw std::runtime_error("Page overflow when GetBoolean");
     }
     // no overflow
-    page_offset = &(*content_)[offset];
+    page_offset = &data_[offset];
     res = *(reinterpret_cast<char *>(page_offset));
     return res;
 }
@@ -26,12 +27,12 @@ char Page::GetByte(int offset) const {
 void Page::SetByte(int offset, char n)  {
     char* page_offset;
     
-    if(offset + sizeof(char) > content_->size()) { 
+    if(offset + sizeof(char) > size_) { 
         // overflow
         throw std::runtime_error("Page overflow when SetBoolean");
     }
     // no overflow
-    page_offset = &(*content_)[offset];
+    page_offset = &data_[offset];
     *(reinterpret_cast<char *>(page_offset)) = n;
 }
 
@@ -41,12 +42,12 @@ int Page::GetInt(int offset) const {
     char* page_offset;
     int res;
     
-    if(offset + sizeof(int) > content_->size()) { 
+    if(offset + sizeof(int) > size_) { 
         // overflow
         throw std::runtime_error("Page overflow when GetInt");
     }
     // no overflow
-    page_offset = &(*content_)[offset];
+    page_offset = &data_[offset];
     res = *(reinterpret_cast<int *>(page_offset));
     return res;
 }
@@ -54,12 +55,12 @@ int Page::GetInt(int offset) const {
 void Page::SetInt(int offset,int n) {
     char* page_offset;
     
-    if(offset + sizeof(int) > content_->size()) { 
+    if(offset + sizeof(int) > size_) { 
         // overflow
         throw std::runtime_error("Page overflow when SetInt");
     }
     // no overflow
-    page_offset = &(*content_)[offset];
+    page_offset = &data_[offset];
     *(reinterpret_cast<int *>(page_offset)) = n;
 }
 
@@ -74,13 +75,13 @@ std::vector<char> Page::GetBytes(int offset) const {
     int blob_size = GetInt(offset);
     
     // the maximum of access address = sizeof(int) + blob_size + offset
-    if(blob_size + sizeof(int) + offset > content_->size()) {
+    if(blob_size + sizeof(int) + offset > size_) {
         throw std::runtime_error("Page overflow when GetBytes");
     }
 
 
     // no overflow
-    page_offset_begin = &(*content_)[offset + sizeof(int)];
+    page_offset_begin = &data_[offset + sizeof(int)];
     page_offset_end = page_offset_begin + blob_size;
     
     byte_array.insert(byte_array.end(), page_offset_begin, page_offset_end);
@@ -101,12 +102,12 @@ void Page::SetBytes(int offset, const std::vector<char> &byte_array) {
     // set the blob's header 
     SetInt(offset, blob_size);
     // check overflow
-    if(blob_size + sizeof(int) + offset > content_->size()) {
+    if(blob_size + sizeof(int) + offset > size_) {
         // overflow
         throw std::runtime_error("Page overflow when SetBytes");
     }
     // no overflow
-    page_offset = &(*content_)[offset + sizeof(int)];
+    page_offset = &data_[offset + sizeof(int)];
 
     std::memcpy(page_offset, &byte_array[0], blob_size);
 }
@@ -130,12 +131,12 @@ double Page::GetDec(int offset) const {
     char* page_offset;
     double res;
     
-    if(offset + sizeof(double) > content_->size()) { 
+    if(offset + sizeof(double) > size_) { 
         // overflow
         throw std::runtime_error("Page overflow when GetInt");
     }
     // no overflow
-    page_offset = &(*content_)[offset];
+    page_offset = &data_[offset];
     res = *(reinterpret_cast<double *>(page_offset));
     return res;
 }
@@ -143,12 +144,12 @@ double Page::GetDec(int offset) const {
 void Page::SetDec(int offset,double n) {
     char* page_offset;
     
-    if(offset + sizeof(int) > content_->size()) { 
+    if(offset + sizeof(int) > size_) { 
         // overflow
         throw std::runtime_error("Page overflow when SetInt");
     }
     // no overflow
-    page_offset = &(*content_)[offset];
+    page_offset = &data_[offset];
     *(reinterpret_cast<double *>(page_offset)) = n;
 }
 
@@ -178,7 +179,7 @@ void Page::SetValue(int offset, Value val) {
     }
 }
 
-Value Page::GetValue(int offset,TypeID type) {
+Value Page::GetValue(int offset,TypeID type) const {
     switch(type) {
     
     case TypeID::CHAR:
@@ -202,7 +203,23 @@ Value Page::GetValue(int offset,TypeID type) {
 }
 
 
+Page::Page(int block_size, int alignment) : size_(block_size) {
+    void *ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, block_size) != 0) {
+        throw std::bad_alloc();
+    }
+
+    memset(ptr, 0, block_size);
+    data_ = static_cast<char*>(ptr);
+    aligned_content_ = std::shared_ptr<char>(data_, free);
+}
+
+
 std::shared_ptr<std::vector<char>> Page::content() {
+    if (content_ == nullptr) {
+        // the memory is not stored in a vector, return a copy of it
+        return std::make_shared<std::vector<char>>(data_, data_ + size_);
+    }
     return content_;
 }
 
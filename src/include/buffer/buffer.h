@@ -2,9 +2,11 @@
 #define BUFFER_H
 
 #include "file/file_manager.h"
+#include "config/config.h"
 #include "config/rw_latch.h"
 #include "config/type.h"
 
+#include <atomic>
 #include <cstring>
 
 namespace SimpleDB {
@@ -28,16 +30,19 @@ friend class BufferManager;
 public:
 
 
-    explicit Buffer(FileManager *file_manager) {
-        data_ = std::make_unique<Page> (file_manager->BlockSize());         
-    }
+    /**
+    * @brief the buffer is a view of a frame, whose memory is owned by bufferpool
+    * @param frame the memory of frame
+    * @param frame_size usually it's the block size
+    */
+    Buffer(char *frame, int frame_size) : data_(frame, frame_size) {}
 
 
     /**
     * @brief return a data ptr which wrapped by page object
     */    
     inline Page* contents() { 
-        return data_.get(); 
+        return &data_; 
     }
 
 
@@ -46,8 +51,8 @@ public:
     */
     inline void SetPageLsn(lsn_t lsn) {
         if (lsn > INVALID_LSN) {
-            SIMPLEDB_ASSERT(lsn >= data_->GetLsn(), "lsn error");
-            data_->SetLsn(lsn);
+            SIMPLEDB_ASSERT(lsn >= data_.GetLsn(), "lsn error");
+            data_.SetLsn(lsn);
             is_dirty_ = true;
         }
     }
@@ -57,7 +62,7 @@ public:
     * @brief Get the PageLsn
     */
     inline lsn_t GetPageLsn() const { 
-        return data_->GetLsn(); 
+        return data_.GetLsn(); 
     }
 
 
@@ -65,7 +70,7 @@ public:
     * @brief init page type
     */
     inline void SetPageType(PageType type) {
-        data_->SetPageType(type);
+        data_.SetPageType(type);
     }
 
 
@@ -73,7 +78,7 @@ public:
     * @brief get page type
     */
     inline PageType GetPageType() const {
-        return data_->GetPageType();
+        return data_.GetPageType();
     }
 
 
@@ -89,8 +94,8 @@ public:
     * @brief always called by newblock method
     */
     void Init() {
-        int size = data_->GetSize();
-        memset(data_->GetRawDataPtr(), 0, size);
+        int size = data_.GetSize();
+        memset(data_.GetRawDataPtr(), 0, size);
     }
 
     
@@ -114,6 +119,10 @@ public:
         return is_dirty_; 
     }
 
+    inline frame_id_t GetFrameId() const {
+        return frame_id_;
+    }
+
     // avoid multiple transaction access at the same time
     inline void RLock() { latch.RLock(); }
     
@@ -123,17 +132,41 @@ public:
 
     inline void WUnlock() { latch.WUnlock(); }
 
+    // optimistic reads don't write the latch, the buffer should 
+    // be pinned so that it won't be evicted during reading
+    inline bool TryOptimisticRead(uint64_t *version) const { 
+        return latch.TryOptimisticRead(version); 
+    }
+
+    inline bool Validate(uint64_t version) const { 
+        return latch.Validate(version); 
+    }
+
 
 protected:
     
-    // buffer content
-    std::unique_ptr<Page> data_;
+    // buffer content, it's a view of the frame
+    Page data_;
  
     BlockId block_;
 
+    // the position of buffer in bufferpool, it never changes
+    frame_id_t frame_id_{-1};
+
     int pin_count_ = 0;
 
-    bool is_dirty_{false};
+    // set by unpinning under the shard latch, and cleared by the background
+    // writer under the read latch of buffer, so it's atomic
+    std::atomic<bool> is_dirty_{false};
+
+    // whether the background writer is writing this buffer, 
+    // it can't be evicted until the write completes.
+    // protected by the latch of its shard
+    bool io_in_progress_{false};
+
+    // the read which is loading a prefetched block into this buffer,
+    // null if the content is ready. protected by the latch of its shard
+    std::shared_ptr<IOCompletion> pending_read_;
     
     // read write latch
     // because we need different transaction isolation level
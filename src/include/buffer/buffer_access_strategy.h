@@ -0,0 +1,78 @@
+#ifndef BUFFER_ACCESS_STRATEGY_H
+#define BUFFER_ACCESS_STRATEGY_H
+
+#include "config/config.h"
+#include "config/type.h"
+#include "file/block_id.h"
+
+#include <string>
+#include <vector>
+
+namespace SimpleDB {
+
+/**
+* @brief BufferAccessStrategy is a hint of bulk reads.
+*
+* when a large sequential scan misses in bufferpool, it recycles a frame
+* of its ring instead of evicting a frame of the whole pool. so a scan
+* of a table bigger than bufferpool only consumes a few frames, and the
+* working set of concurrent point queries stays resident.
+*
+* if the scan pins blocks of a file in order, bufferpool reads the next
+* blocks ahead asynchronously, so the scan doesn't wait for one block at a time.
+*
+* a strategy serves one scan, it should not be shared between threads.
+*/
+class BufferAccessStrategy {
+
+    friend class BufferManager;
+
+public:
+
+    /**
+    * @param ring_size the maximum number of frames the scan can hold,
+    *  0 means the scan uses the whole pool
+    * @param read_ahead_num the number of blocks to read ahead, 0 means
+    *  no read-ahead. up to two windows can be ahead of the scan, so it
+    *  should be less than half of ring_size if ring is used
+    */
+    explicit BufferAccessStrategy(int ring_size = SIMPLEDB_SCAN_RING_SIZE,
+                                  int read_ahead_num = SIMPLEDB_READ_AHEAD_BLOCK_NUM)
+        : ring_(ring_size), read_ahead_num_(read_ahead_num) {}
+
+    int GetRingSize() const { return ring_.size(); }
+
+    int GetReadAheadNum() const { return read_ahead_num_; }
+
+private:
+
+    /**
+    * @brief a frame of ring and the block which the scan read into it.
+    * if the frame holds another block now, someone else has used it,
+    * so it can't be recycled by us
+    */
+    struct RingSlot {
+        frame_id_t frame_id_{INVALID_FRAME_ID};
+        BlockId block_;
+    };
+
+    std::vector<RingSlot> ring_;
+
+    // the slot which will be replaced when no frame can be recycled
+    int current_{0};
+
+    /********* read-ahead *********/
+
+    int read_ahead_num_;
+
+    // the last block pinned by the scan
+    std::string file_name_;
+    int last_block_{-1};
+
+    // blocks before it have been read or are being read
+    int prefetch_end_{0};
+};
+
+} // namespace SimpleDB
+
+#endif
@@ -1,14 +1,21 @@
 #ifndef BUFFER_MANAGER_H
 #define BUFFER_MANAGER_H
 
+#include <atomic>
 #include <list>
 #include <map>
 #include <chrono>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
 
 #include "file/file_manager.h"
 #include "log/log_manager.h"
-#include "buffer/lru_replace.h"
+#include "buffer/replacer.h"
 #include "buffer/buffer.h"
+#include "buffer/page_guard.h"
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/frame_arena.h"
 #include "config/rw_latch.h"
 
 namespace SimpleDB {
@@ -16,8 +23,55 @@ namespace SimpleDB {
 
 class RecoveryManager;
 
+
+/**
+* @brief pins of a file which find the block in bufferpool or read it
+*/
+struct FileAccessStats {
+
+    uint64_t hit_num_{0};
+
+    uint64_t miss_num_{0};
+};
+
+
+/**
+* @brief statistics of bufferpool since it's created
+*/
+struct BufferStatsSnapshot {
+
+    uint64_t hit_num_{0};
+
+    uint64_t miss_num_{0};
+
+    uint64_t clean_eviction_num_{0};
+
+    // evicting a dirty block writes it in the foreground
+    uint64_t dirty_eviction_num_{0};
+
+    uint64_t background_write_num_{0};
+
+    // the files which have been pinned, keyed by file name
+    std::map<std::string, FileAccessStats> file_stats_;
+
+    // the pins which waited for a free frame or a prefetching read
+    HistogramSnapshot pin_wait_;
+
+    // ios of filemanager, including the ones issued by others
+    IOStatsSnapshot io_;
+
+    double HitRatio() const {
+        uint64_t total = hit_num_ + miss_num_;
+        return total == 0 ? 0 : static_cast<double>(hit_num_) / total;
+    }
+};
+
 /**
  * @brief BufferPoolManager reads disk pages to and from its internal buffer pool.
+ *
+ * the buffer pool is partitioned into shards by the hash of BlockId, every shard
+ * has its own latch, page table, free list and replacer. so pins of blocks in
+ * different shards don't contend with each other.
  */
 class BufferManager {
 
@@ -28,43 +82,94 @@ public:
     * @brief 
     * Creates a buffer manager having the specified numbers of buffer slots.
     * Since we use the buffer class to encapsulate reads and writes.
+    * @param shard_num the number of partitions, every partition owns 
+    *  buffer_nums / shard_num buffers. more partitions scale better 
+    *  across cores, but a block can only use the buffers of its partition
+    * @param replacer_type the replacement policy of every partition
     */
-    explicit BufferManager(FileManager *fm, RecoveryManager *rm, int buffer_nums);
+    explicit BufferManager(FileManager *fm, RecoveryManager *rm, int buffer_nums, int shard_num = 1,
+                           ReplacerType replacer_type = ReplacerType::LRU);
+
+
+    /**
+    * @brief stop the background writer if it's running
+    */
+    ~BufferManager();
     
 
     /**
     * @return the number of avaiable (unused, unpinned) buffers.
     */
-    int available() {return available_num_;}
+    int available();
     
     
     /**
     * @brief pins a buffer to the specified block, potentially waiting until a buffer 
-    * becomes available.If no buffer becomes available within a fixed time period, 
-    * will throw a exception
+    * becomes available.If no buffer becomes available within the pin timeout, 
+    * will throw a exception. threads wait for free frames in arrival order,
+    * a freed frame is handed to the first of them
     * @param block a disk block
+    * @param strategy if not null, a miss recycles a frame of the strategy's
+    *  ring instead of evicting a frame of the whole pool
     * @return the buffer pinned to taht block 
     */
-    Buffer* PinBlock(const BlockId &block);
+    Buffer* PinBlock(const BlockId &block, BufferAccessStrategy *strategy = nullptr);
+
+
+    /**
+    * @brief like PinBlock, but never waits for a free frame
+    * @return null if the block is not in bufferpool and no frame can
+    *  be used now, or others are already waiting for frames
+    */
+    Buffer* TryPinBlock(const BlockId &block, BufferAccessStrategy *strategy = nullptr);
+
+
+    /**
+    * @brief how long PinBlock and NewBlock wait for a free frame
+    */
+    void SetPinTimeout(std::chrono::milliseconds timeout) { pin_timeout_ = timeout; }
 
 
     /**
     * @brief Unpins the specified data buffer. If its pin count
     * goes to zero, then notify any waiting threads.
     * 
-    * @param buffer the buffer to be unpinned
+    * @param buffer the buffer to be unpinned, the page table 
+    *  isn't looked up since the buffer is known
     */
-    bool UnpinBlock(Buffer *buffer);
+    bool UnpinBlock(Buffer *buffer, bool is_dirty = false);
 
 
     /**
     * @brief unpin a block
     */
     bool UnpinBlock(const BlockId &block, bool is_dirty = false);
+
+
+    /**
+    * @brief pin a block and return a guard which unpins it when destroyed
+    */
+    BasicPageGuard PinBlockGuarded(const BlockId &block, BufferAccessStrategy *strategy = nullptr);
+
+
+    /**
+    * @brief pin a block and acquire its reader latch, 
+    * the guard releases both of them
+    */
+    ReadPageGuard PinBlockRead(const BlockId &block, BufferAccessStrategy *strategy = nullptr);
+
+
+    /**
+    * @brief pin a block and acquire its writer latch,
+    * the guard releases both of them
+    */
+    WritePageGuard PinBlockWrite(const BlockId &block, BufferAccessStrategy *strategy = nullptr);
     
 
     /**
     * @brief Flush all dirty buffers which exists in bufferpool
+    * dirty buffers are written in one batch and stay in bufferpool,
+    * and they are durable after returning
     */
     void FlushAll();
     
@@ -76,6 +181,106 @@ public:
 
 
     Buffer* NewBlock(const std::string &file_name);
+
+
+    /**
+    * @brief acquire a new block and return a guard which unpins it
+    */
+    BasicPageGuard NewBlockGuarded(const std::string &file_name, int *block_num);
+
+
+    /**
+    * @return the number of buffers in bufferpool
+    */
+    int GetBufferNum() const { return buffer_num_; }
+
+
+    /**
+    * @brief change the number of buffers while others are using bufferpool.
+    * growing maps a new arena segment for the new buffers. shrinking evicts
+    * the buffers whose frame id is not less than buffer_nums, waits until 
+    * they are unpinned and returns their memory to os. other blocks stay
+    * in bufferpool, so the cache is still warm after resizing.
+    * @param buffer_nums it should not be less than the number of shards
+    * @return false if some buffers are still pinned after waiting a fixed 
+    *  time period, the bufferpool has been shrunk but their memory is held
+    *  until they are unpinned and next resize is called
+    */
+    bool Resize(int buffer_nums);
+
+
+    /**
+    * @brief start a background thread which writes dirty unpinned buffers
+    * ahead of demand, so that a victim is usually clean and pinblock 
+    * doesn't need to write someone else's page. log records are flushed 
+    * up to the page lsn before a page is written.
+    * @param clean_target the number of clean evictable buffers to keep
+    * @param interval how long the writer sleeps between two rounds
+    */
+    void StartBackgroundWriter(int clean_target = SIMPLEDB_BG_WRITER_CLEAN_TARGET,
+                               std::chrono::milliseconds interval = 
+                                   std::chrono::milliseconds(SIMPLEDB_BG_WRITER_INTERVAL_MS));
+
+
+    void StopBackgroundWriter();
+
+
+    /**
+    * @return the number of dirty victims written by pinblock itself
+    */
+    uint64_t GetForegroundWriteNum() const { return foreground_write_num_; }
+
+
+    /**
+    * @return the number of dirty buffers written by background writer
+    */
+    uint64_t GetBackgroundWriteNum() const { return background_write_num_; }
+
+
+    /**
+    * @brief counters are always on, they are updated while holding the 
+    * shard latch which is held anyway or on the stripe of the thread.
+    * taking a snapshot locks every shard for a short time
+    */
+    BufferStatsSnapshot GetStats();
+
+
+    /**
+    * @brief read blocks [start_block, end_block) of a file asynchronously 
+    * into unpinned frames, a later pin of them waits for the read instead 
+    * of issuing its own. blocks which are resident or past the end of file
+    * are skipped, and it never waits for a free frame
+    * @param strategy if not null, frames are taken from its ring
+    */
+    void Prefetch(const std::string &file_name, int start_block, int end_block,
+                  BufferAccessStrategy *strategy = nullptr);
+
+
+    /**
+    * @brief write the blocks in bufferpool to a file in db directory,
+    * the most recently used block comes first. 
+    */
+    void DumpResidentBlocks(const std::string &file_name = SIMPLEDB_BUFFER_DUMP_FILE_NAME);
+
+
+    /**
+    * @brief read the blocks dumped by DumpResidentBlocks back into bufferpool
+    * before serving queries. the hottest blocks which fit in bufferpool are
+    * read in sorted order and in batches, then it waits for all of them. 
+    * blocks which don't exist now are skipped
+    * @return the number of blocks submitted to read, 0 if no dump file
+    */
+    int LoadResidentBlocks(const std::string &file_name = SIMPLEDB_BUFFER_DUMP_FILE_NAME);
+
+
+    /**
+    * @brief dump the resident blocks periodically by background writer,
+    * and when bufferpool is destroyed. so the next startup can warm up
+    * with LoadResidentBlocks
+    */
+    void SetDumpFile(const std::string &file_name = SIMPLEDB_BUFFER_DUMP_FILE_NAME,
+                     std::chrono::milliseconds interval = 
+                         std::chrono::milliseconds(SIMPLEDB_BUFFER_DUMP_INTERVAL_MS));
     
     
     /********* for debugging purpose *********/
@@ -109,42 +314,244 @@ public:
 private: // some heapler functions
 
 
+    /**
+    * @brief a thread which waits for a free frame, it lives on the
+    * stack of that thread and is protected by the shard latch
+    */
+    struct PinWaiter {
+
+        std::condition_variable cv_;
+
+        // the frame handed off to this waiter. it has been evicted, 
+        // so it holds no block but it's still counted as available
+        frame_id_t frame_id_{INVALID_FRAME_ID};
+    };
+
+
+    /**
+    * @brief a partition of bufferpool
+    */
+    struct BufferShard {
+
+        // protect all members of this shard and the buffers it owns
+        std::mutex latch_;
+
+        // map blockid to frame_id, differ from page_table in os
+        std::unordered_map<BlockId, frame_id_t> page_table_;
+
+        // unused buffer
+        std::list<frame_id_t> free_list_;
+
+        // replacer algorithm
+        std::unique_ptr<Replacer> replacer_;
+
+        // unpined buffer or unused buffer
+        int available_num_{0};
+
+        // the threads waiting for a free frame, in arrival order
+        std::list<PinWaiter*> waiters_;
+
+        // the frames handed off to waiters which haven't woken up,
+        // they are counted in available_num_ 
+        int handing_num_{0};
+
+        // the number of buffers which background writer is writing
+        int writing_num_{0};
+
+        // for analyze
+        double pin_time_{0};
+
+        /********* statistics *********/
+
+        uint64_t hit_num_{0};
+
+        uint64_t miss_num_{0};
+
+        uint64_t clean_eviction_num_{0};
+
+        uint64_t dirty_eviction_num_{0};
+
+        // indexed by file id, which is dense
+        std::vector<FileAccessStats> file_stats_;
+
+        inline FileAccessStats& GetFileStats(const BlockId &block) {
+            auto file_id = block.FileId();
+            if (file_id >= file_stats_.size()) {
+                file_stats_.resize(file_id + 1);
+            }
+            return file_stats_[file_id];
+        }
+    };
+
+
+    /**
+    * @brief a segment of arena, frame i of it is the (begin_ + i) th frame
+    */
+    struct ArenaSegment {
+        frame_id_t begin_;
+        std::unique_ptr<FrameArena> arena_;
+    };
+
+
+    /**
+    * @brief create a replacer which can hold frame id less than num_pages
+    */
+    static std::unique_ptr<Replacer> CreateReplacer(ReplacerType replacer_type, int num_pages);
+
+
+    /**
+    * @brief lock all shards in the same order, so it can't deadlock
+    */
+    std::vector<std::unique_lock<std::mutex>> LockAllShards();
+
+
+    /**
+    * @brief create buffers whose frame id are [buffer_pool_.size(), buffer_nums),
+    * the memory of them comes from the last arena segment or a new segment
+    */
+    std::vector<std::unique_ptr<Buffer>> AllocateFrames(int buffer_nums);
+
+
+    /**
+    * @brief evict the retiring buffers which are unused now, it
+    * should be called while holding all shard latches
+    * @return the number of retiring buffers which are still used
+    */
+    int DropRetiringFrames();
+
+
+    /**
+    * @brief a buffer whose frame id is not less than buffer_num_ is being 
+    * removed by shrinking. it's not in free list or replacer and not counted
+    * in available_num_, but the block in it can still be pinned until evicted
+    */
+    inline bool IsRetiring(frame_id_t frame_id) const {
+        return frame_id >= buffer_num_;
+    }
+
+
+    /**
+    * @brief the shard which the block belongs to
+    */
+    inline BufferShard& GetShard(const BlockId &block) {
+        return *shards_[std::hash<BlockId>()(block) % shards_.size()];
+    }
+
+
     /**
     * @brief 
     * this function can help us find the victim frame quickly
     * @return the position of a available buffer in pool 
     */
-    frame_id_t VictimHelper();
+    frame_id_t VictimHelper(BufferShard &shard);
+
+
+    /**
+    * @brief select a victim frame for a scan which uses a ring,
+    * recycle a frame of ring if possible, otherwise take one from pool
+    * and put it into ring
+    */
+    frame_id_t StrategyVictimHelper(BufferShard &shard, BufferAccessStrategy *strategy, 
+                                    const BlockId &block);
+
+
+    /**
+    * @param wait whether to wait for a free frame
+    */
+    Buffer* PinBlockHelper(const BlockId &block, BufferAccessStrategy *strategy, bool wait);
+
+
+    /**
+    * @brief queue up until a frame is handed off to us
+    * @return the evicted frame, INVALID_FRAME_ID if timeout
+    */
+    frame_id_t WaitForFrame(std::unique_lock<std::mutex> &lock, BufferShard &shard,
+                            std::chrono::time_point<std::chrono::high_resolution_clock> start);
+
+
+    /**
+    * @brief while threads are waiting, evict victims and hand them off
+    * to the waiters in order. it's called whenever a frame may become 
+    * available, instead of waking up all waiters to race for it
+    */
+    void HandOffFrames(BufferShard &shard);
+
+
+    /**
+    * @brief read the block into a frame handed off to us. if someone 
+    * has read it meanwhile, give the frame to others and use his buffer
+    */
+    Buffer* InstallHandedFrame(BufferShard &shard, frame_id_t frame_id, const BlockId &block,
+                               BufferAccessStrategy *strategy);
+
+
+    /**
+    * @brief the frame will be reused, wait until the prefetching of it finishes
+    */
+    void WaitForPrefetch(Buffer *buffer);
+
+
+    /**
+    * @brief the block has been pinned, if it's being prefetched, 
+    * wait until its content is ready
+    */
+    void WaitForPinnedRead(std::unique_lock<std::mutex> &lock, Buffer *buffer);
+
+
+    /**
+    * @brief read blocks into unpinned frames asynchronously,
+    * the blocks should exist
+    */
+    void PrefetchBlocks(const std::vector<BlockId> &blocks, BufferAccessStrategy *strategy);
+
+
+    /**
+    * @brief if the scan pins blocks in order, keep reading ahead of it
+    */
+    void ReadAhead(const BlockId &block, BufferAccessStrategy *strategy);
     
 
     /**
     * @brief if a buffer is found, call this function help us matain data memember
     * this function assumes that we successfully find a victim buffer. 
     */
-    void PinHelper(frame_id_t frame_id, const BlockId &block, bool write_to_disk = true);
+    void PinHelper(BufferShard &shard, frame_id_t frame_id, const BlockId &block, bool write_to_disk = true);
 
     /**
     * @brief 
     */
-    void UnpinHelper(frame_id_t frame_id, const BlockId &block);
+    void UnpinHelper(BufferShard &shard, frame_id_t frame_id, const BlockId &block);
 
 
-    void FlushHelper(Buffer *buffer);
+    void FlushHelper(BufferShard &shard, Buffer *buffer);
     
     /**
     * @brief 
     * Tries to pin a buffer to the specified block. 
     * @return a pointet which point to avaiable buffer 
     */
-    Buffer* TryToPin(const BlockId &block);
+    Buffer* TryToPin(BufferShard &shard, const BlockId &block, BufferAccessStrategy *strategy);
 
 
-    Buffer* TryToAllocatePin(const BlockId &block);
+    Buffer* TryToAllocatePin(BufferShard &shard, const BlockId &block);
 
 
     bool WaitTooLong(std::chrono::time_point<std::chrono::high_resolution_clock>);
 
 
+    /**
+    * @brief main loop of background writer
+    */
+    void BackgroundWriterLoop(int clean_target, std::chrono::milliseconds interval);
+
+
+    /**
+    * @brief write dirty unpinned buffers of a shard until it has 
+    * clean_target clean evictable buffers
+    */
+    void CleanShard(int shard_id, int clean_target);
+
+
 
 
 
@@ -158,34 +565,52 @@ private:
     // shared recovery_manager
     RecoveryManager *recovery_manager_;
 
-    // starring role
+    // the memory of all frames, it should outlive buffer_pool_.
+    // it's only changed by resizing
+    std::vector<ArenaSegment> arenas_;
+
+    // starring role, it's only changed while holding all shard latches
     std::vector<std::unique_ptr<Buffer>> buffer_pool_;
 
-    // unused buffer
-    std::list<frame_id_t> free_list_;
-    
-    // unpined buffer or unused buffer
-    int available_num_;
-    
-    // map blockid to frame_id, differ from page_table in os
-    std::map<BlockId, frame_id_t> page_table_;
-    
-    // replacer algorithm
-    std::unique_ptr<LRUReplacer> replacer_;
-    
-    // big latch, currently it will protect whole buffer pool manager
-    std::mutex latch_;
-    
-    // be used to select a victim
-    std::condition_variable victim_cv_;
+    // the number of buffers which can be used, buffer_pool_ may have
+    // more buffers which are being removed. it's only changed while 
+    // holding all shard latches
+    std::atomic<int> buffer_num_{0};
+
+    // serialize resizing
+    std::mutex resize_latch_;
+
+    // partitions of bufferpool, frame i belongs to shard i % shard_num
+    std::vector<std::unique_ptr<BufferShard>> shards_;
     
     /* wait time can be setted by user */
-    std::chrono::milliseconds milliseconds{10000};
-    const int max_time_ = 10000;
+    std::chrono::milliseconds pin_timeout_{SIMPLEDB_PIN_TIMEOUT_MS};
 
-    double pin_time_{0};
     double unpin_time_{0};
 
+    /********* background writer *********/
+
+    std::unique_ptr<std::thread> writer_thread_;
+
+    std::mutex writer_latch_;
+
+    // wakeup writer when stopping it
+    std::condition_variable writer_cv_;
+
+    bool writer_stop_{false};
+
+    // where the resident blocks are dumped, empty if no dumping
+    std::string dump_file_name_;
+
+    std::chrono::milliseconds dump_interval_{SIMPLEDB_BUFFER_DUMP_INTERVAL_MS};
+
+    std::atomic<uint64_t> foreground_write_num_{0};
+
+    std::atomic<uint64_t> background_write_num_{0};
+
+    // the pins which had to wait
+    LatencyHistogram pin_wait_latency_;
+
 
 };  
 
@@ -0,0 +1,70 @@
+#ifndef CLOCK_REPLACER_H
+#define CLOCK_REPLACER_H
+
+#include "buffer/replacer.h"
+#include "config/type.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace SimpleDB {
+
+/**
+* @brief ClockReplacer implements the second-chance algorithm.
+* frames are organized into a circle, and every frame has a reference bit
+* which is set when the frame is unpinned. the clock hand sweeps the circle,
+* a frame whose reference bit is set gets a second chance and its bit is
+* cleared, otherwise it's evicted.
+*
+* Pin and Unpin only flip some flags atomically, only Evict
+* which moves the clock hand takes the latch.
+*/
+class ClockReplacer : public Replacer {
+
+public:
+
+    /**
+    * @param num_pages the maximum number of frames, frame id 
+    * should be less than it
+    */
+    explicit ClockReplacer(frame_id_t num_pages);
+
+    ~ClockReplacer() override = default;
+
+    bool Evict(frame_id_t *victim) override;
+
+    void Pin(frame_id_t frame_id) override;
+
+    void Unpin(frame_id_t frame_id) override;
+
+    int Size() override { return size_; }
+
+    void Resize(frame_id_t num_pages) override;
+
+    std::vector<frame_id_t> GetFramesByRecency() override;
+
+private:
+
+    // the number of frames in circle
+    frame_id_t capacity_;
+
+    // whether the frame can be evicted
+    std::unique_ptr<std::atomic<bool>[]> in_replacer_;
+
+    // whether the frame has been used recently
+    std::unique_ptr<std::atomic<bool>[]> ref_bits_;
+
+    // the number of frames which can be evicted
+    std::atomic<int> size_{0};
+
+    // the clock hand, protected by latch_
+    frame_id_t hand_{0};
+
+    // serialize the sweeping of clock hand
+    std::mutex latch_;
+};
+
+} // namespace SimpleDB
+
+#endif
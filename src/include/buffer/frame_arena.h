@@ -0,0 +1,73 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include "config/type.h"
+
+#include <cstddef>
+
+namespace SimpleDB {
+
+/**
+* @brief FrameArena is a contiguous memory which backs all frames of bufferpool,
+* instead of allocating every frame separately.
+*
+* the arena is page-aligned, so frames whose size is a multiple of os page
+* can be used by direct io. if huge pages are available, the arena is backed
+* by them to reduce tlb misses on the hot path.
+*/
+class FrameArena {
+
+public:
+
+    /**
+    * @brief map a zeroed arena which can hold frame_num frames
+    * @param frame_num
+    * @param frame_size usually it's the block size
+    */
+    FrameArena(int frame_num, int frame_size);
+
+    ~FrameArena();
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena& operator=(const FrameArena &) = delete;
+
+    /**
+    * @return the memory of the frame
+    */
+    inline char* GetFrame(frame_id_t frame_id) {
+        return data_ + static_cast<size_t>(frame_id) * frame_size_;
+    }
+
+    /**
+    * @return the number of frames which the arena can hold
+    */
+    int GetFrameNum() const { return frame_num_; }
+
+    /**
+    * @brief return the memory of frames [begin_frame, GetFrameNum()) to os,
+    * but keep the mapping. the memory is zero when it's touched again
+    */
+    void Discard(frame_id_t begin_frame);
+
+    /**
+    * @return whether the arena is backed by MAP_HUGETLB pages
+    */
+    bool IsHugePage() const { return huge_page_; }
+
+private:
+
+    // the first byte of arena
+    char *data_;
+    // the size of mapping
+    size_t size_;
+    // the size of every frame
+    int frame_size_;
+    // the number of frames
+    int frame_num_;
+    // whether it's backed by explicit huge pages
+    bool huge_page_{false};
+};
+
+} // namespace SimpleDB
+
+#endif
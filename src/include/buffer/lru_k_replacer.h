@@ -0,0 +1,79 @@
+#ifndef LRU_K_REPLACER_H
+#define LRU_K_REPLACER_H
+
+#include "buffer/replacer.h"
+#include "config/type.h"
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace SimpleDB {
+
+/**
+* @brief LRUKReplacer evicts the frame whose backward k-distance is the largest,
+* i.e. the frame whose k-th most recent access is the oldest.
+*
+* the frames which have been accessed less than k times have infinite
+* backward k-distance, they are evicted first and in the order of their
+* earliest access, just like a fifo queue in 2Q. so the blocks which are
+* only touched once by a large scan can't flush the hot blocks out of bufferpool.
+*/
+class LRUKReplacer : public Replacer {
+
+public:
+
+    /**
+    * @param num_pages the maximum number of frames, frame id 
+    * should be less than it
+    * @param k
+    */
+    explicit LRUKReplacer(frame_id_t num_pages, int k = 2);
+
+    ~LRUKReplacer() override = default;
+
+    bool Evict(frame_id_t *victim) override;
+
+    /**
+    * @brief record an access of the frame, and it can't be evicted
+    */
+    void Pin(frame_id_t frame_id) override;
+
+    void Unpin(frame_id_t frame_id) override;
+
+    int Size() override;
+
+    void Resize(frame_id_t num_pages) override;
+
+    std::vector<frame_id_t> GetFramesByRecency() override;
+
+private:
+
+    // (the earliest access in history, frame id)
+    using entry_t = std::pair<uint64_t, frame_id_t>;
+
+    int k_;
+
+    // logical timestamp
+    uint64_t current_timestamp_{0};
+
+    // the last k accesses of every frame
+    std::vector<std::deque<uint64_t>> history_;
+
+    // whether the frame can be evicted
+    std::vector<bool> evictable_;
+
+    // evictable frames which are accessed less than k times
+    std::set<entry_t> young_;
+
+    // evictable frames which are accessed k times
+    std::set<entry_t> old_;
+
+    std::mutex latch_;
+};
+
+} // namespace SimpleDB
+
+#endif
@@ -2,6 +2,7 @@
 #define LRU_REPLACE_H
 
 #include "config/type.h"
+#include "buffer/replacer.h"
 
 #include <unordered_map>
 #include <mutex>
@@ -16,7 +17,7 @@ namespace SimpleDB {
 In LRUReplacer, frames are organized into a queue, with the frame at the head of 
 the queue being poped  first.Each time a newly unpinned frame_id enters the tail of the queue
 */
-class LRUReplacer{
+class LRUReplacer : public Replacer {
 public:
     /**
      * @brief Construct a new LRUReplacer object
@@ -32,7 +33,7 @@ public:
     /**
      * @brief Destroy the LRUReplacer object
      */
-    ~LRUReplacer() = default;
+    ~LRUReplacer() override = default;
     
     /**
     * @brief Remove the victim frame.
@@ -41,27 +42,31 @@ public:
     * @param victim the frame of being victimed
     * @return whether success
     */
-    bool Evict(frame_id_t *victim);
+    bool Evict(frame_id_t *victim) override;
 
     /**
     * @brief this specified frame will not enter the queue 
     * 
     * @param frame_id 
     */
-    void Pin(frame_id_t frame_id);
+    void Pin(frame_id_t frame_id) override;
 
     /**
     * @brief this specified frame will enter the queue
     * 
     * @param frame_id
     */
-    void Unpin(frame_id_t frame_id);
+    void Unpin(frame_id_t frame_id) override;
 
     /**
     * @brief return the number of frame in the replacer 
     * that can be victim
     */
-    int Size();
+    int Size() override;
+
+    void Resize(frame_id_t num_pages) override;
+
+    std::vector<frame_id_t> GetFramesByRecency() override;
     
     // for debugging purpose
     void PrintLRU();
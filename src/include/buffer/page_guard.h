@@ -0,0 +1,187 @@
+#ifndef PAGE_GUARD_H
+#define PAGE_GUARD_H
+
+#include "buffer/buffer.h"
+
+namespace SimpleDB {
+
+class BufferManager;
+
+/**
+* @brief BasicPageGuard owns a pin of a buffer and unpins it when it's dropped
+* or destroyed. it remembers the buffer itself, so unpinning doesn't need to
+* look up page table again. it can be moved but not copied, every pin is
+* released exactly once.
+*/
+class BasicPageGuard {
+
+public:
+
+    BasicPageGuard() = default;
+
+    /**
+    * @param bpm the bufferpool which the buffer belongs to
+    * @param buffer a buffer which has been pinned for this guard
+    */
+    BasicPageGuard(BufferManager *bpm, Buffer *buffer)
+        : bpm_(bpm), buffer_(buffer) {}
+
+    BasicPageGuard(const BasicPageGuard &) = delete;
+    BasicPageGuard& operator=(const BasicPageGuard &) = delete;
+
+    BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+    /**
+    * @brief release the pin held by this guard first, then take over that
+    */
+    BasicPageGuard& operator=(BasicPageGuard &&that) noexcept;
+
+    ~BasicPageGuard() { Drop(); }
+
+    /**
+    * @brief unpin the buffer, the guard is empty after dropping
+    */
+    void Drop();
+
+    /**
+    * @brief give up the pin without unpinning it, the caller should 
+    * unpin the buffer later. the dirty flag is not kept
+    */
+    Buffer* Release();
+
+    /**
+    * @brief the buffer will be unpinned as dirty
+    */
+    inline void SetDirty() { is_dirty_ = true; }
+
+    inline bool IsValid() const { return buffer_ != nullptr; }
+
+    inline Buffer* GetBuffer() const { return buffer_; }
+
+    inline const BlockId& GetBlockID() const { return buffer_->GetBlockID(); }
+
+    inline int GetBlockNum() const { return buffer_->GetBlockID().BlockNum(); }
+
+    /**
+    * @brief view the buffer as a subclass of buffer, e.g. TablePage
+    */
+    template <class T>
+    inline T* As() const { return static_cast<T*>(buffer_); }
+
+    /**
+    * @brief view the content of buffer as a page layout, e.g. LeafPage
+    */
+    template <class T>
+    inline T* DataAs() const {
+        return reinterpret_cast<T*>(buffer_->contents()->GetRawDataPtr());
+    }
+
+private:
+
+    BufferManager *bpm_{nullptr};
+
+    Buffer *buffer_{nullptr};
+
+    bool is_dirty_{false};
+};
+
+
+
+/**
+* @brief ReadPageGuard holds a pin and the reader latch of a buffer,
+* the latch is released before the pin
+*/
+class ReadPageGuard {
+
+public:
+
+    ReadPageGuard() = default;
+
+    /**
+    * @param guard its buffer should be latched by reader latch already
+    */
+    explicit ReadPageGuard(BasicPageGuard &&guard) : guard_(std::move(guard)) {}
+
+    ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+    ReadPageGuard& operator=(ReadPageGuard &&that) noexcept;
+
+    ~ReadPageGuard() { Drop(); }
+
+    void Drop();
+
+    /**
+    * @brief give up the pin and the latch without releasing them,
+    * the caller should unlatch and unpin the buffer later
+    */
+    Buffer* Release();
+
+    inline bool IsValid() const { return guard_.IsValid(); }
+
+    inline Buffer* GetBuffer() const { return guard_.GetBuffer(); }
+
+    inline const BlockId& GetBlockID() const { return guard_.GetBlockID(); }
+
+    inline int GetBlockNum() const { return guard_.GetBlockNum(); }
+
+    // page methods are not const-qualified, the caller should only read it
+    template <class T>
+    inline T* As() const { return guard_.As<T>(); }
+
+    template <class T>
+    inline T* DataAs() const { return guard_.DataAs<T>(); }
+
+private:
+
+    BasicPageGuard guard_;
+};
+
+
+
+/**
+* @brief WritePageGuard holds a pin and the writer latch of a buffer,
+* the latch is released before the pin
+*/
+class WritePageGuard {
+
+public:
+
+    WritePageGuard() = default;
+
+    /**
+    * @param guard its buffer should be latched by writer latch already
+    */
+    explicit WritePageGuard(BasicPageGuard &&guard) : guard_(std::move(guard)) {}
+
+    WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+    WritePageGuard& operator=(WritePageGuard &&that) noexcept;
+
+    ~WritePageGuard() { Drop(); }
+
+    void Drop();
+
+    inline void SetDirty() { guard_.SetDirty(); }
+
+    inline bool IsValid() const { return guard_.IsValid(); }
+
+    inline Buffer* GetBuffer() const { return guard_.GetBuffer(); }
+
+    inline const BlockId& GetBlockID() const { return guard_.GetBlockID(); }
+
+    inline int GetBlockNum() const { return guard_.GetBlockNum(); }
+
+    template <class T>
+    inline T* As() const { return guard_.As<T>(); }
+
+    template <class T>
+    inline T* DataAs() const { return guard_.DataAs<T>(); }
+
+private:
+
+    BasicPageGuard guard_;
+};
+
+} // namespace SimpleDB
+
+#endif
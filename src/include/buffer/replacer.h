@@ -0,0 +1,80 @@
+#ifndef REPLACER_H
+#define REPLACER_H
+
+#include "config/type.h"
+
+#include <vector>
+
+namespace SimpleDB {
+
+/**
+* @brief the replacement policy which can be used by bufferpool
+*/
+enum class ReplacerType {
+    LRU,
+    CLOCK,
+    LRU_K,
+};
+
+/**
+* @brief Replacer tracks the frames which can be evicted from bufferpool,
+* and choose a victim frame when bufferpool has no unused frame.
+*
+* bufferpool calls Pin every time a frame is accessed and calls Unpin
+* when the frame is no longer used by anyone.
+*/
+class Replacer {
+
+public:
+
+    Replacer() = default;
+
+    virtual ~Replacer() = default;
+
+    /**
+    * @brief Remove the victim frame.
+    * 
+    * @param victim the frame of being victimed
+    * @return whether success
+    */
+    virtual bool Evict(frame_id_t *victim) = 0;
+
+    /**
+    * @brief the frame is accessed, it can't be evicted until unpinned
+    * 
+    * @param frame_id 
+    */
+    virtual void Pin(frame_id_t frame_id) = 0;
+
+    /**
+    * @brief the frame can be evicted
+    * 
+    * @param frame_id
+    */
+    virtual void Unpin(frame_id_t frame_id) = 0;
+
+    /**
+    * @brief return the number of frame in the replacer 
+    * that can be victim
+    */
+    virtual int Size() = 0;
+
+    /**
+    * @brief change the maximum number of frames, the frames whose id 
+    * is not less than num_pages are forgotten. it's called when bufferpool
+    * is resized and can't run concurrently with other methods
+    * 
+    * @param num_pages
+    */
+    virtual void Resize(frame_id_t num_pages) = 0;
+
+    /**
+    * @brief return the frames which can be victim, the frame which 
+    * will be evicted last comes first
+    */
+    virtual std::vector<frame_id_t> GetFramesByRecency() = 0;
+};
+
+} // namespace SimpleDB
+
+#endif
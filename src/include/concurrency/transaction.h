@@ -87,8 +87,8 @@ public:
         return false;
     }
 
-    Buffer *PinBlock(const BlockId &block) const {
-        return buffer_manager_->PinBlock(block);
+    Buffer *PinBlock(const BlockId &block, BufferAccessStrategy *strategy = nullptr) const {
+        return buffer_manager_->PinBlock(block, strategy);
     }
 
     void UnpinBlock(const BlockId &block) const {
@@ -124,6 +124,15 @@ public:
 
     inline IsoLationLevel GetIsolationLevel() const { return isolation_level_; }
 
+    /**
+    * @brief an async-commit txn doesn't wait for its commit log to be flushed,
+    * the commit may be lost by a crash within the log flush interval, 
+    * and the txn is rolled back by recovery then
+    */
+    inline void SetAsyncCommit(bool async_commit) { async_commit_ = async_commit; }
+
+    inline bool IsAsyncCommit() const { return async_commit_; }
+
     inline BufferManager* GetBufferManager() const { return buffer_manager_; }
 
     inline FileManager* GetFileManager() const { return file_manager_; }
@@ -166,6 +175,9 @@ private:
     // transactionstate
     TransactionState state_{TransactionState::RUNNING};
 
+    // whether commit returns before the commit log is durable
+    bool async_commit_{false};
+
 };
 
 } // namespace SimpleDB
@@ -30,13 +30,17 @@ public:
     * @brief create a new txn and return a transaction object
     * 
     * @param level default level is SERIALIZABLE which can't happen phantom read
+    * @param async_commit commit the txn without waiting for the commit log
+    * to be flushed, the log is flushed by log flush thread within its interval
     */
-    std::unique_ptr<Transaction> Begin(IsoLationLevel level = IsoLationLevel::SERIALIZABLE);
+    std::unique_ptr<Transaction> Begin(IsoLationLevel level = IsoLationLevel::SERIALIZABLE,
+                                       bool async_commit = false);
 
 
      /**
      * @brief 
-     * Commit a transaction and flush commit log immediately
+     * Commit a transaction and flush commit log immediately, 
+     * unless the txn is async-commit
      * @param txn 
      */
     void Commit(Transaction *txn);
@@ -14,6 +14,41 @@ static constexpr int SIMPLEDB_BUFFER_POOL_SIZE = 100;
 static const std::string SIMPLEDB_LOG_FILE_NAME = "simpledb.log";
 // store checkpoint_end_record's lsn
 static const std::string SIMPLEDB_CHKPT_FILE_NAME = "checkpoint.log";
+// the maximum number of block ios in flight when reading or writing a batch
+static constexpr int SIMPLEDB_IO_QUEUE_DEPTH = 64;
+// the number of io threads when io_uring is not supported by kernel
+static constexpr int SIMPLEDB_IO_WORKER_NUM = 4;
+// the alignment of memory, offset and size required by direct io
+static constexpr int SIMPLEDB_DIRECT_IO_ALIGNMENT = 4096;
+// the number of blocks which are preallocated when a file grows
+static constexpr int SIMPLEDB_EXTENT_BLOCK_NUM = 16;
+// whether bufferpool tries to use huge pages
+static constexpr bool SIMPLEDB_BUFFER_POOL_HUGE_PAGE = true;
+// the number of frames which a large sequential scan can recycle
+static constexpr int SIMPLEDB_SCAN_RING_SIZE = 32;
+// the number of blocks which a sequential scan reads ahead
+static constexpr int SIMPLEDB_READ_AHEAD_BLOCK_NUM = 8;
+// the number of clean evictable frames which background writer tries to keep
+static constexpr int SIMPLEDB_BG_WRITER_CLEAN_TARGET = 16;
+// how long background writer sleeps between two rounds
+static constexpr int SIMPLEDB_BG_WRITER_INTERVAL_MS = 20;
+// the file which stores the resident blocks of bufferpool for warming up
+static const std::string SIMPLEDB_BUFFER_DUMP_FILE_NAME = "buffer_pool.dump";
+// how often background writer dumps the resident blocks
+static constexpr int SIMPLEDB_BUFFER_DUMP_INTERVAL_MS = 60000;
+// how long a pin waits for a free frame before giving up
+static constexpr int SIMPLEDB_PIN_TIMEOUT_MS = 10000;
+// the number of log buffers, appenders don't wait for disk unless all are full
+static constexpr int SIMPLEDB_LOG_BUFFER_NUM = 4;
+// the size of a log buffer in blocks
+static constexpr int SIMPLEDB_LOG_BUFFER_BLOCK_NUM = 16;
+// the size of a log segment file
+static constexpr int SIMPLEDB_LOG_SEGMENT_SIZE = 4 * 1024 * 1024;
+// the number of preallocated log segments which are kept for future log,
+// the segments recycled beyond it are deleted
+static constexpr int SIMPLEDB_LOG_FREE_SEGMENT_NUM = 2;
+// how long log flush thread sleeps if no committer waits for it
+static constexpr int SIMPLEDB_LOG_FLUSH_INTERVAL_MS = 10;
 
 static const int DIRECTORY_ARRAY_SIZE = 512;
 
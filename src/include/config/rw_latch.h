@@ -1,6 +1,8 @@
 #ifndef RW_LATCH_H
 #define RW_LATCH_H
 
+#include <atomic>
+#include <cstdint>
 #include <mutex>  // NOLINT
 #include <condition_variable>
 #include <climits>
@@ -8,6 +10,15 @@
 
 namespace SimpleDB {
 
+/**
+* @brief a reader writer latch which also supports optimistic reads.
+*
+* every writer increases a version counter when it acquires and releases
+* the latch, so the version is odd while a writer holds it. an optimistic
+* reader records the version, reads without writing any shared memory, 
+* and validates that the version is unchanged at the end. if it changed, 
+* what the reader saw may be inconsistent and it should retry with RLock.
+*/
 class ReaderWriterLatch {
     const uint32_t MAX_READERS = UINT_MAX;
 
@@ -26,6 +37,9 @@ public:
     */
     void WLock() {
         mutex_.lock();
+        version_.fetch_add(1, std::memory_order_relaxed);
+        // the odd version should be visible before any modification
+        std::atomic_thread_fence(std::memory_order_release);
     }
 
     /**
@@ -33,6 +47,7 @@ public:
      * release writer latch
      */
     void WUnlock() {
+        version_.fetch_add(1, std::memory_order_release);
         mutex_.unlock();
     }
 
@@ -48,9 +63,32 @@ public:
         mutex_.unlock_shared();
     }
 
+    /**
+    * @brief start an optimistic read
+    * @param version return the current version
+    * @return false if a writer holds the latch now
+    */
+    bool TryOptimisticRead(uint64_t *version) const {
+        *version = version_.load(std::memory_order_acquire);
+        return (*version & 1) == 0;
+    }
+
+    /**
+    * @brief whether no writer has acquired the latch 
+    * since the optimistic read started
+    */
+    bool Validate(uint64_t version) const {
+        // the reads of data should not be reordered after checking version
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return version_.load(std::memory_order_relaxed) == version;
+    }
+
 private:
     
     std::shared_mutex mutex_;
+
+    // odd means a writer holds the latch
+    std::atomic<uint64_t> version_{0};
 };
 
 class ReaderGuard {
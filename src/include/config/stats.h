@@ -0,0 +1,150 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace SimpleDB {
+
+/**
+* @brief every thread updates its own stripe of a counter, so counting
+* on a hot path doesn't bounce a shared cache line between cores.
+* reading sums all stripes, it's only used by snapshots.
+*/
+class StatsStripe {
+
+public:
+
+    static constexpr int STRIPE_NUM = 16;
+
+    /**
+    * @brief the stripe of the calling thread
+    */
+    static inline int ThreadStripe() {
+        static std::atomic<int> next_stripe{0};
+        thread_local int stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) % STRIPE_NUM;
+        return stripe;
+    }
+};
+
+
+/**
+* @brief a counter which can be left on in production
+*/
+class StatsCounter {
+
+public:
+
+    inline void Add(uint64_t n = 1) {
+        stripes_[StatsStripe::ThreadStripe()].value_.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    inline uint64_t Get() const {
+        uint64_t sum = 0;
+        for (auto &stripe : stripes_) {
+            sum += stripe.value_.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+private:
+
+    struct alignas(64) Stripe {
+        std::atomic<uint64_t> value_{0};
+    };
+
+    Stripe stripes_[StatsStripe::STRIPE_NUM];
+};
+
+
+/**
+* @brief a snapshot of histogram, bucket i counts the samples
+* in [2^(i-1), 2^i) microseconds and bucket 0 counts samples less
+* than 1 microsecond
+*/
+struct HistogramSnapshot {
+
+    std::vector<uint64_t> buckets_;
+
+    uint64_t count_{0};
+
+    uint64_t sum_us_{0};
+
+    double Mean() const {
+        return count_ == 0 ? 0 : static_cast<double>(sum_us_) / count_;
+    }
+
+    /**
+    * @param ratio e.g. 0.99 for p99
+    * @return the upper bound of the bucket which contains the percentile,
+    *  in microseconds. it's exact up to a factor of 2
+    */
+    uint64_t Percentile(double ratio) const {
+        if (count_ == 0) {
+            return 0;
+        }
+
+        uint64_t rank = static_cast<uint64_t>(ratio * count_);
+        uint64_t seen = 0;
+        for (size_t i = 0;i < buckets_.size();i ++) {
+            seen += buckets_[i];
+            if (seen > rank) {
+                return 1ULL << i;
+            }
+        }
+        return 1ULL << (buckets_.size() - 1);
+    }
+};
+
+
+/**
+* @brief a latency histogram with power-of-2 buckets, recording
+* a sample is two relaxed additions on the stripe of the thread
+*/
+class LatencyHistogram {
+
+public:
+
+    static constexpr int BUCKET_NUM = 32;
+
+    inline void Record(std::chrono::nanoseconds latency) {
+        uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+        int bucket = us == 0 ? 0 : 64 - __builtin_clzll(us);
+        if (bucket >= BUCKET_NUM) {
+            bucket = BUCKET_NUM - 1;
+        }
+
+        auto &stripe = stripes_[StatsStripe::ThreadStripe()];
+        stripe.buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+        stripe.sum_us_.fetch_add(us, std::memory_order_relaxed);
+    }
+
+    HistogramSnapshot GetSnapshot() const {
+        HistogramSnapshot snapshot;
+        snapshot.buckets_.assign(BUCKET_NUM, 0);
+        for (auto &stripe : stripes_) {
+            for (int i = 0;i < BUCKET_NUM;i ++) {
+                uint64_t n = stripe.buckets_[i].load(std::memory_order_relaxed);
+                snapshot.buckets_[i] += n;
+                snapshot.count_ += n;
+            }
+            snapshot.sum_us_ += stripe.sum_us_.load(std::memory_order_relaxed);
+        }
+        return snapshot;
+    }
+
+private:
+
+    struct alignas(64) Stripe {
+        std::atomic<uint64_t> buckets_[BUCKET_NUM]{};
+        std::atomic<uint64_t> sum_us_{0};
+    };
+
+    Stripe stripes_[StatsStripe::STRIPE_NUM];
+};
+
+} // namespace SimpleDB
+
+#endif
@@ -1,11 +1,14 @@
 #ifndef TYPE_H
 #define TYPE_H
 
+#include <cstdint>
+
 namespace SimpleDB {
 
 using frame_id_t = int; /* bufferpool */ 
 using lsn_t = int;    /* log */
 using txn_id_t = int; /* transaction */
+using log_offset_t = int64_t; /* the logical offset of log */
 
 
 static constexpr int INVALID_FRAME_ID = -1;
@@ -0,0 +1,206 @@
+#ifndef ASYNC_IO_H
+#define ASYNC_IO_H
+
+#include "config/stats.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sys/uio.h>
+#include <thread>
+#include <vector>
+
+namespace SimpleDB {
+
+/**
+* @brief a block io which has been resolved to a file descriptor
+* and an offset by filemanager
+*/
+struct IOTask {
+    // raw file descriptor
+    int fd_;
+    // memory of page, it should be valid until the io completes
+    char *buf_;
+    // the size of io, usually it's the block size
+    int size_;
+    // the offset in file
+    int offset_;
+    // read or write
+    bool is_write_;
+};
+
+
+/**
+* @brief the completion of a batch of ios. submitter can wait on it
+* until all ios of the batch have completed.
+*/
+class IOCompletion {
+
+public:
+
+    explicit IOCompletion(int io_count) : remaining_(io_count) {}
+
+    /**
+    * @brief block until all ios of the batch complete
+    * if any io failed, throw a runtime_error
+    */
+    void Wait();
+
+    /**
+    * @return whether all ios of the batch have completed
+    */
+    bool IsDone();
+
+    /**
+    * @brief called by async io when one io of the batch completes
+    */
+    void Complete(bool success);
+
+    /**
+    * @brief count every io of the batch into stats when it completes,
+    * its latency is measured from now. it should be called before submitting
+    */
+    void SetStats(LatencyHistogram *latency, StatsCounter *bytes, int io_size) {
+        latency_ = latency;
+        bytes_ = bytes;
+        io_size_ = io_size;
+        submit_time_ = std::chrono::steady_clock::now();
+    }
+
+private:
+
+    std::mutex latch_;
+
+    std::condition_variable cv_;
+
+    // the number of ios which have not completed
+    int remaining_;
+
+    // whether an io failed
+    bool failed_{false};
+
+    // where the ios are counted, null if not counted
+    LatencyHistogram *latency_{nullptr};
+
+    StatsCounter *bytes_{nullptr};
+
+    int io_size_{0};
+
+    std::chrono::steady_clock::time_point submit_time_;
+};
+
+
+/**
+* @brief AsyncIO keeps many block ios in flight instead of a queue depth of one.
+*
+* if the kernel supports io_uring, ios are put into the submission queue
+* and a reaper thread takes them from the completion queue. otherwise, ios
+* are dispatched to a small pool of worker threads which call pread/pwrite.
+*/
+class AsyncIO {
+
+public:
+
+    /**
+    * @param queue_depth the maximum number of ios in flight
+    * @param worker_num the number of worker threads when io_uring is not available
+    */
+    AsyncIO(int queue_depth, int worker_num);
+
+    /**
+    * @brief wait for all submitted ios and stop background threads
+    */
+    ~AsyncIO();
+
+    /**
+    * @brief submit ios and return immediately. every io will call
+    * completion->Complete once.
+    */
+    void Submit(const std::vector<IOTask> &tasks,
+                const std::shared_ptr<IOCompletion> &completion);
+
+    /**
+    * @return whether the io_uring backend is used
+    */
+    bool IsUsingUring() const { return ring_fd_ != -1; }
+
+    /**
+    * @brief execute an io synchronously, short read past the end
+    * of file will be filled with zero.
+    * @return whether success
+    */
+    static bool ExecuteTask(const IOTask &task);
+
+private:
+
+    /**
+    * @brief an io which has been submitted to io_uring
+    */
+    struct UringRequest {
+        IOTask task_;
+        std::shared_ptr<IOCompletion> completion_;
+        struct iovec iov_;
+    };
+
+    bool SetupUring(int entries);
+
+    void SubmitToUring(const std::vector<IOTask> &tasks,
+                       const std::shared_ptr<IOCompletion> &completion);
+
+    void ReapLoop();
+
+    void WorkerLoop();
+
+private:
+
+    /********* io_uring backend *********/
+
+    int ring_fd_{-1};
+
+    // mmaped rings
+    void *sq_ptr_{nullptr};
+    void *cq_ptr_{nullptr};
+    void *sqes_ptr_{nullptr};
+    void *cqes_ptr_{nullptr};
+    size_t sq_ring_size_{0};
+    size_t cq_ring_size_{0};
+    size_t sqes_size_{0};
+
+    unsigned *sq_tail_{nullptr};
+    unsigned *sq_mask_{nullptr};
+    unsigned *sq_array_{nullptr};
+    unsigned *cq_head_{nullptr};
+    unsigned *cq_tail_{nullptr};
+    unsigned *cq_mask_{nullptr};
+    unsigned sq_entries_{0};
+
+    // the thread which reaps completion queue
+    std::thread reaper_;
+
+    // the number of ios which have been submitted but not reaped,
+    // it never exceeds sq_entries_ so completion queue can't overflow
+    unsigned in_flight_{0};
+
+    /********* thread pool backend *********/
+
+    std::vector<std::thread> workers_;
+
+    std::deque<std::pair<IOTask, std::shared_ptr<IOCompletion>>> queue_;
+
+    /********* shared *********/
+
+    // protect submission queue, in_flight_ and queue_
+    std::mutex latch_;
+
+    // wakeup submitters which wait for a free slot and workers which wait for ios
+    std::condition_variable cv_;
+
+    std::atomic<bool> stop_{false};
+};
+
+} // namespace SimpleDB
+
+#endif
@@ -1,7 +1,12 @@
 #ifndef BLOCK_ID_H
 #define BLOCK_ID_H
 
+#include "file/file_registry.h"
+
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <type_traits>
 
 namespace SimpleDB {
 
@@ -10,6 +15,10 @@ namespace SimpleDB {
 * a file consists of many disk-blocks that identified by a logical block number.
 * so, blockid consist of a filename and a logical block number
 * A disk-block can be uniquely identified by BlockId 
+*
+* the file name is interned by FileRegistry, so blockid only holds two 
+* integers. it's trivially copyable, and hashing or comparing it doesn't 
+* touch any string. the order of files is the order of their file ids.
 */
 class BlockId {
     
@@ -23,32 +32,36 @@ class BlockId {
 
 public:
 
-    BlockId& operator= (const BlockId &obj);
     /**
-    * @brief non-parameters constructor 
+    * @brief non-parameters constructor, the file name is empty 
     */
     BlockId() {}
     
-    /**
-    * @brief copy-constructor
-    */
-    BlockId(const BlockId &b) : 
-        file_name_(b.FileName()), block_num_(b.BlockNum()) {} 
     /**
     * @brief Construct a Blockid object
     * 
     * @param file_name the file corresponding to the block
     * @param block_num the block's logical number in file
     */
-    BlockId(std::string file_name, int block_num) : 
-        file_name_(file_name), block_num_(block_num) {}
+    BlockId(const std::string &file_name, int block_num) : 
+        file_id_(FileRegistry::GetInstance().GetFileId(file_name)), 
+        block_num_(block_num) {}
     
     /**
     * @brief
     *  
-    * @return file_name_
+    * @return the name of file, it's valid until the process exits
+    */
+    inline const std::string& FileName() const {
+        return FileRegistry::GetInstance().GetFileName(file_id_);
+    }
+
+    /**
+    * @return the id of file which is given by FileRegistry
     */
-    std::string FileName() const;
+    inline uint32_t FileId() const {
+        return file_id_;
+    }
 
     /**
     * @brief
@@ -72,17 +85,45 @@ public:
     * @return the information of the block
     */
     std::string to_string() const;
+
+    /**
+    * @brief hash value of the block, used by unordered containers
+    * and to choose a partition of bufferpool
+    */
+    size_t Hash() const {
+        // mix the bits, so both unordered containers and 
+        // partitions of bufferpool are balanced
+        uint64_t key = (static_cast<uint64_t>(file_id_) << 32) | 
+                       static_cast<uint32_t>(block_num_);
+        key *= 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>(key ^ (key >> 32));
+    }
     
     
 
 private:
-    // the block belong to which file
-    std::string file_name_;
+    // the block belong to which file, 0 is the empty name
+    uint32_t file_id_{0};
     // logical block number
-    int block_num_;
+    int block_num_{-1};
 };
+
+static_assert(std::is_trivially_copyable<BlockId>::value && sizeof(BlockId) == 8,
+              "blockid should be a cheap 64-bit value");
 }
 
 
+namespace std {
+
+template <>
+struct hash<SimpleDB::BlockId> {
+    size_t operator()(const SimpleDB::BlockId &block) const {
+        return block.Hash();
+    }
+};
+
+} // namespace std
+
+
 
 #endif
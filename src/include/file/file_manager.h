@@ -1,33 +1,85 @@
 #ifndef FILE_MANAGER_H
 #define FILE_MANAGER_H
 
-#include <fstream>
+#include <atomic>
+#include <chrono>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include "page.h"
 #include "block_id.h"
+#include "file/async_io.h"
+#include "config/rw_latch.h"
 
 
 namespace SimpleDB {
 
+/**
+* @brief io statistics of data blocks since filemanager is created
+*/
+struct IOStatsSnapshot {
+
+    uint64_t read_num_{0};
+
+    uint64_t write_num_{0};
+
+    uint64_t read_bytes_{0};
+
+    uint64_t write_bytes_{0};
+
+    // the latency of every block io, a batched io is measured
+    // from submitting to its completion
+    HistogramSnapshot read_latency_;
+
+    HistogramSnapshot write_latency_;
+};
+
+
 /**
 * @brief we use file-level to access disk and view a file as a raw disk
 *   through page-level to access the file  
 * FileManager implements write/read pages to/from disk-blocks
+*
+* every file is accessed by a raw file descriptor with positional
+* pread/pwrite, so reads and writes of different blocks, even in the same
+* file, don't share a seek pointer and can be issued in parallel.
+* only the operations which change the size of a file are serialized
+* by the latch of this file.
+*
+* by default, writes are only handed to os (write-back), durability is
+* guaranteed by calling Sync/SyncAll once for a batch of writes.
+* in write-through mode, every write is synced immediately.
+*
+* in direct io mode, data files are opened with O_DIRECT and bypass os
+* page cache, so blocks are not cached twice by os and bufferpool.
+* the pages which are not aligned are copied through an aligned page.
+*
+* files grow by extents of SIMPLEDB_EXTENT_BLOCK_NUM blocks, the logical
+* block number of every file is cached in memory. the size of file is
+* still the high-water mark, since extents are preallocated beyond it.
 */
 class FileManager {
     
     friend class LogManager;
-    friend class LogIterator;
 public:
     /**
     * @brief create a filemanager, only one object exist in Simpledb::client
     *   
     * @param db_directory direcotry path name (linux)
     * @param block_size
+    * @param direct_io whether data files bypass os page cache, it's ignored
+    *  if block_size is not a multiple of SIMPLEDB_DIRECT_IO_ALIGNMENT.
+    *  log files are always buffered by os
     */
-    FileManager(const std::string &db_directory, int block_size);
+    FileManager(const std::string &db_directory, int block_size, bool direct_io = false);
+
+    /**
+    * @brief close all opened files
+    */
+    ~FileManager();
 
     /**
     * @brief read a page from disk-block
@@ -39,7 +91,8 @@ public:
 
     /**
     * @brief write a page's content to disk-block
-    * every write operation must be written immediately to the disk. 
+    * in write-back mode, the content is handed to os and it's durable
+    * after calling Sync. in write-through mode, it's synced immediately.
     * write operation can also extend the file
     * 
     * @param block logical block number
@@ -48,27 +101,75 @@ public:
     void Write(const BlockId &block, Page *page);
 
     /**
-    * @brief read a page from log file
-    * usually be called by log ietrator 
-    * @param log_name log file name
-    * @param offset the offset in log file
-    * @param page the cache of block
+    * @brief submit reads of many blocks and return immediately,
+    * pages should be valid until the returned completion is done.
+    * reads past end of file get zero pages.
+    *
+    * @param blocks the blocks to be read
+    * @param pages pages[i] is the destination of blocks[i]
+    * @return the completion which can be waited on
+    */
+    std::shared_ptr<IOCompletion> SubmitRead(const std::vector<BlockId> &blocks,
+                                             const std::vector<Page*> &pages);
+
+    /**
+    * @brief submit writes of many blocks and return immediately,
+    * pages should not be modified until the returned completion is done.
+    *
+    * @param blocks the blocks to be written
+    * @param pages pages[i] is the source of blocks[i]
+    * @return the completion which can be waited on
+    */
+    std::shared_ptr<IOCompletion> SubmitWrite(const std::vector<BlockId> &blocks,
+                                              const std::vector<Page*> &pages);
+
+    /**
+    * @brief read many blocks with many ios in flight,
+    * and wait for all of them
+    */
+    void ReadBatch(const std::vector<BlockId> &blocks, const std::vector<Page*> &pages);
+
+    /**
+    * @brief write many blocks with many ios in flight,
+    * and wait for all of them
+    */
+    void WriteBatch(const std::vector<BlockId> &blocks, const std::vector<Page*> &pages);
+
+    /**
+    * @brief make all writes of the file durable, do nothing
+    * if the file has not been written since last sync
+    *
+    * @param file_name
+    */
+    void Sync(const std::string &file_name);
+
+    /**
+    * @brief make all writes of all opened files durable
+    */
+    void SyncAll();
+
+    /**
+    * @brief in write-through mode, every write is synced before returning
     */
-    void ReadLog(const std::string &log_name, int offset, Page &page);
+    void SetWriteThrough(bool write_through) { write_through_ = write_through; }
+
+    bool IsWriteThrough() { return write_through_; }
+
+    /**
+    * @brief it's cheap enough to be called while others are doing ios
+    */
+    IOStatsSnapshot GetIOStats() const;
 
     /**
-    * @brief write a page to log file
-    * usually be called by log manager
-    * @param log_name log file name
-    * @param size the size of log which be flushed
-    * @param page the cache of block
+    * @brief whether data files are opened with O_DIRECT, if so the pages
+    * written or read by ios should be aligned
     */
-    void WriteLog(const std::string &log_name, int size, Page &page);
+    bool IsDirectIO() { return direct_io_; }
 
     
     /**
-    * @brief seek to the end of the file and writes an empty array of bytes to it,
-    *  causes the OS to automatically extend the file
+    * @brief writes an empty array of bytes to the end of file, the space of it
+    *  is preallocated by extent, so the file is only extended logically
     * 
     * @param file_name
     */
@@ -91,30 +192,80 @@ public:
     *   Actually block 1 doesn't belong to us, OS will automatically extend the size of file
     *   we can extend the file in this-way
     * p.s The length of the file is always a multiple of 4kb
+    * it's cached in memory, so no syscall is needed
     */
     int GetFileBlockNum(const std::string &file_name) {
-        return GetFileSize(file_name) / block_size_;
+        return GetFile(file_name)->block_num_;
     }
 
     void SetFileSize(const std::string &file_name, int block_num);
 
+    /**
+    * @return the path of a file in db directory
+    */
+    std::string GetFilePath(const std::string &file_name) const {
+        return directory_name_ + "/" + file_name;
+    }
+
+    /**
+    * @brief unlike other methods, it doesn't create the file
+    */
+    bool IsFileExist(const std::string &file_name) const;
+
 private:
 
     /**
-    * @brief Get the corresponding file-stream by file name
-    * 
+    * @brief an opened file. the handle is never moved or freed
+    * until filemanager is destroyed, so it can be used without
+    * holding the latch of open_files_.
+    */
+    struct FileHandle {
+
+        FileHandle(int fd, bool direct, int block_num) 
+            : fd_(fd), direct_(direct), block_num_(block_num), 
+              allocated_num_(block_num) {}
+
+        // raw file descriptor
+        int fd_;
+
+        // whether the file is opened with O_DIRECT
+        bool direct_;
+
+        // serialize the operations which change the size of this file
+        std::mutex latch_;
+
+        // serialize the syncs of this file
+        std::mutex sync_latch_;
+
+        // whether the file has been written since last sync
+        std::atomic<bool> dirty_{false};
+
+        // the logical block number, i.e. high-water mark
+        std::atomic<int> block_num_;
+
+        // the number of blocks which space has been allocated,
+        // protected by latch_
+        int allocated_num_;
+
+        // whether file system supports preallocation
+        bool can_preallocate_{true};
+    };
+
+    /**
+    * @brief Get the corresponding file handle by file name
+    *
     * @param file_name
     */
-    std::fstream* GetFile(const std::string &file_name);
+    FileHandle* GetFile(const std::string &file_name);
 
     /**
-    * @brief Get the corresponding log-file-stream by log name
-    * 
-    * @param log_name
-    * @return the file-stream of log file
+    * @brief open the file if it has not been opened, create it if not exist
+    *
+    * @param file_name
+    * @param flags the flags which passed to open(2) besides O_RDWR | O_CREAT
     */
-    std::fstream* GetLogFile(const std::string &log_name);
-    
+    FileHandle* OpenFile(const std::string &file_name, int flags);
+
     /**
     * @brief Get the file'size by file name
     * 
@@ -122,21 +273,82 @@ private:
     */
     int GetFileSize(const std::string &file_name);
 
+    /**
+    * @brief read size bytes at offset, retry when interrupted or
+    * read less than size.
+    * @return the bytes actually read, it's less than size only at eof
+    */
+    int PositionalRead(FileHandle *file, char *buf, int size, int offset);
+
+    /**
+    * @brief write size bytes at offset, retry until all bytes are written
+    */
+    void PositionalWrite(FileHandle *file, const char *buf, int size, int offset);
+
+    /**
+    * @brief raise the logical block number if a write past the end of file
+    */
+    void ExtendBlockNum(FileHandle *file, int block_num);
+
+    /**
+    * @brief preallocate an extent if the next block has no space,
+    * the file latch should be held
+    */
+    void Preallocate(FileHandle *file, int block_num);
+
+    /**
+    * @brief direct io can't access the memory which is not aligned,
+    * it should be copied through an aligned page
+    */
+    bool NeedBounce(FileHandle *file, const char *buf);
+
+    /**
+    * @brief mark the file has been written, sync it immediately in write-through mode
+    */
+    void MarkWritten(FileHandle *file);
+
+    /**
+    * @brief fdatasync the file if it's dirty
+    */
+    void SyncFile(FileHandle *file);
+
+    /**
+    * @brief resolve blocks to ios and submit them to async io
+    */
+    std::shared_ptr<IOCompletion> SubmitBatch(const std::vector<BlockId> &blocks,
+                                              const std::vector<Page*> &pages,
+                                              bool is_write);
+
+    /**
+    * @brief create async io when it's used at the first time,
+    * so that filemanagers which never batch ios don't start any thread
+    */
+    AsyncIO* GetAsyncIO();
+
     // directory name
     std::string directory_name_;
     // disk block fix-size
     int block_size_;
     // is this db newly created?
     bool is_new_;
-    // map file_name to pointer which point to their fstream and cache it(optimization)
-    std::map<std::string, std::unique_ptr<std::fstream>> open_files_;
-    // mutex latch
-    std::mutex latch_;
+    // whether data files bypass os page cache
+    bool direct_io_;
+    // map file_name to opened file and cache it(optimization)
+    std::unordered_map<std::string, std::unique_ptr<FileHandle>> open_files_;
+    // only protect open_files_, read and write don't hold it during io
+    ReaderWriterLatch latch_;
+    // execute batched ios, created lazily
+    std::unique_ptr<AsyncIO> async_io_;
+    std::once_flag async_io_flag_;
+    // sync every write immediately
+    std::atomic<bool> write_through_{false};
     // may use  int next_page_id;
     
-    // for analyze
-    std::chrono::milliseconds data_write_time_{0};
-    std::chrono::milliseconds data_read_time_{0};
+    // io statistics of data blocks, logs are not counted
+    LatencyHistogram read_latency_;
+    LatencyHistogram write_latency_;
+    StatsCounter read_bytes_;
+    StatsCounter write_bytes_;
 };
 
 } // namespace SimpleDB
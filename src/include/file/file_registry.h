@@ -0,0 +1,76 @@
+#ifndef FILE_REGISTRY_H
+#define FILE_REGISTRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace SimpleDB {
+
+/**
+* @brief FileRegistry interns file names to 32-bit file ids, so a BlockId
+* only stores an integer and can be hashed, compared and copied cheaply.
+*
+* there is only one registry in a process, ids are not persistent and
+* they are never reused. the name of an id can be read without any latch.
+*/
+class FileRegistry {
+
+public:
+
+    static FileRegistry& GetInstance();
+
+    FileRegistry(const FileRegistry &) = delete;
+    FileRegistry& operator=(const FileRegistry &) = delete;
+
+    /**
+    * @brief return the id of file, register it if it's a new name
+    */
+    uint32_t GetFileId(const std::string &file_name);
+
+    /**
+    * @brief the file id should be returned by GetFileId before
+    * @return the name of file, it's valid until the process exits
+    */
+    inline const std::string& GetFileName(uint32_t file_id) const {
+        auto *chunk = chunks_[file_id >> CHUNK_BITS].load(std::memory_order_acquire);
+        return chunk[file_id & (CHUNK_SIZE - 1)];
+    }
+
+    /**
+    * @return the number of registered files
+    */
+    uint32_t GetFileNum() const { return next_id_; }
+
+private:
+
+    FileRegistry();
+
+    /**
+    * @brief give a new id to the file if nobody has done it
+    */
+    uint32_t Register(const std::string &file_name);
+
+    static constexpr uint32_t INVALID_FILE_ID = UINT32_MAX;
+
+    // names are stored in chunks which are never moved,
+    // so readers don't need the latch
+    static constexpr int CHUNK_BITS = 10;
+    static constexpr uint32_t CHUNK_SIZE = 1 << CHUNK_BITS;
+    static constexpr uint32_t MAX_CHUNK_NUM = 1 << 12;
+
+    // protect file_ids_ and registering
+    std::shared_mutex latch_;
+
+    std::unordered_map<std::string, uint32_t> file_ids_;
+
+    std::atomic<std::string*> chunks_[MAX_CHUNK_NUM];
+
+    std::atomic<uint32_t> next_id_{0};
+};
+
+} // namespace SimpleDB
+
+#endif
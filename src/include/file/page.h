@@ -5,6 +5,7 @@
 #include "config/type.h"
 #include "config/rw_latch.h"
 
+#include <cstring>
 #include <memory>
 #include <vector>
 
@@ -44,11 +45,31 @@ public:
     */
     Page(int block_size) {
         content_ = std::make_shared<std::vector<char>> (block_size);
+        data_ = content_->data();
+        size_ = content_->size();
     }
     
 
     Page(std::shared_ptr<std::vector<char>> &buffer_page)
-        :content_(buffer_page) {}
+        :content_(buffer_page), data_(content_->data()), size_(content_->size()) {}
+
+
+    /**
+    * @brief Constructor, the memory of page is aligned to alignment,
+    * so that it can be used by direct io. commonly used to buffer manager
+    * @param block_size
+    * @param alignment it should be a power of two
+    */
+    Page(int block_size, int alignment);
+
+
+    /**
+    * @brief Constructor, the page is only a view of memory which is
+    * owned by others, i.e. a frame of bufferpool
+    * @param data the first byte of memory
+    * @param size the size of memory
+    */
+    Page(char *data, int size) : data_(data), size_(size) {}
 
 
     /**
@@ -149,7 +170,7 @@ public:
     * @param offset
     * @param constant
     */
-    Value GetValue(int offset,TypeID type);
+    Value GetValue(int offset,TypeID type) const;
 
     /**
     * @brief calculates the maximum size of blobs
@@ -163,19 +184,19 @@ public:
 
     /**
     * @brief page's content,usually 4kb size. 
-    * 
+    * if the page is aligned, return a copy of it
     * @return shard_ptr, jusk lisk a vector<char>* 
     */
     std::shared_ptr<std::vector<char>> content();
 
     
-    int GetSize() { return content_->size(); }
+    int GetSize() const { return static_cast<int>(size_); }
 
     
-    char *GetRawDataPtr() { return &(*content_)[0]; }
+    char *GetRawDataPtr() { return data_; }
 
 
-    void ZeroPage() { content_ = std::make_shared<std::vector<char>>(content_->size(), 0); }
+    void ZeroPage() { memset(data_, 0, size_); }
 
 public: // for recovery manager, we can use lsn to get more information
 
@@ -184,22 +205,22 @@ public: // for recovery manager, we can use lsn to get more information
     static constexpr int PAGE_HEADER_SIZE = PAGE_TYPE_OFFSET + sizeof(int);
 
     inline void SetLsn(lsn_t lsn) {
-        SIMPLEDB_ASSERT(content_->size() >= PAGE_HEADER_SIZE, "error");
+        SIMPLEDB_ASSERT(size_ >= PAGE_HEADER_SIZE, "error");
         SetInt(LSN_OFFSET, lsn);
     }
 
     inline lsn_t GetLsn() const {
-        SIMPLEDB_ASSERT(content_->size() >= PAGE_HEADER_SIZE, "error");
+        SIMPLEDB_ASSERT(size_ >= PAGE_HEADER_SIZE, "error");
         return GetInt(LSN_OFFSET);
     }
 
     inline void SetPageType(PageType type) {
-        SIMPLEDB_ASSERT(content_->size() >= PAGE_HEADER_SIZE, "error");
+        SIMPLEDB_ASSERT(size_ >= PAGE_HEADER_SIZE, "error");
         SetInt(PAGE_TYPE_OFFSET, static_cast<int>(type));
     }
 
     inline PageType GetPageType() const {
-        SIMPLEDB_ASSERT(content_->size() >= PAGE_HEADER_SIZE, "error");
+        SIMPLEDB_ASSERT(size_ >= PAGE_HEADER_SIZE, "error");
         return static_cast<PageType>(GetInt(PAGE_TYPE_OFFSET));
     }
     
@@ -209,6 +230,12 @@ private:
 
     // Page's content, stored in heap
     std::shared_ptr<std::vector<char>> content_;
+    // or stored in aligned memory
+    std::shared_ptr<char> aligned_content_;
+    // point to the first byte of content
+    char *data_;
+    // the size of content
+    size_t size_;
 };
 }
 #endif
\ No newline at end of file
@@ -16,51 +16,85 @@ namespace SimpleDB {
 #define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator>
 
 
+/**
+* @brief the pages latched by an operation, from top to bottom. 
+* a query only holds reader latches and a modification only holds
+* writer latches, guards release the latch and pin of a page
+*/
 class BPlusTreeContext {
 
 public:
 
-    BPlusTreeContext(BufferManager *buf) : buffer_manager_(buf) {}
+    BPlusTreeContext() = default;
 
 
-    inline void AddToPageSet(Buffer *buffer) {
-        page_set_.emplace_back(buffer);
+    inline void AddToPageSet(ReadPageGuard &&guard) {
+        read_set_.emplace_back(std::move(guard));
     }
 
 
-    inline const std::vector<Buffer*>& GetPageSet() {
-        return page_set_;
+    inline void AddToPageSet(WritePageGuard &&guard) {
+        write_set_.emplace_back(std::move(guard));
     }
 
-    inline void ClearPageSetNotUnpin() {
-        page_set_.clear();
+
+    /**
+    * @brief the last latched page, it's the leaf after searchleaf
+    */
+    inline Buffer* Back() const {
+        return read_set_.empty() ? write_set_.back().GetBuffer() 
+                                 : read_set_.back().GetBuffer();
     }
 
-    inline void ClearPageSet(bool is_read_op) {
-        for (auto &t: page_set_) {
-            auto &block_id = t->GetBlockID();
-            
-            if (is_read_op) {
-                t->RUnlock();
-            }
-            else {
-                t->WUnlock();
+
+    /**
+    * @brief the last page will be unpinned as dirty
+    */
+    inline void SetBackDirty() {
+        write_set_.back().SetDirty();
+    }
+
+
+    /**
+    * @brief hand over the guard of the last page to caller
+    */
+    inline ReadPageGuard TakeBack() {
+        auto guard = std::move(read_set_.back());
+        read_set_.pop_back();
+        return guard;
+    }
+
+
+    /**
+    * @brief the last page is safe, release the pages above it
+    * @return whether the root page has been released
+    */
+    inline bool ReleaseAncestors(int root_block_num) {
+        bool release_root = false;
+        auto release = [&](auto &page_set) {
+            if (page_set.size() <= 1) {
+                return;
             }
+            release_root |= page_set.front().GetBlockNum() == root_block_num;
+            page_set.erase(page_set.begin(), page_set.end() - 1);
+        };
 
-            assert(buffer_manager_->UnpinBlock(block_id, false));    
-        }
-        page_set_.clear();
+        release(read_set_);
+        release(write_set_);
+        return release_root;
     }
 
-private:
 
-#ifdef DEBUG
-    std::unordered_map<Buffer *, int> dirty_map;
-#endif
+    inline void ClearPageSet() {
+        read_set_.clear();
+        write_set_.clear();
+    }
 
-    std::vector<Buffer *> page_set_;
+private:
 
-    BufferManager *buffer_manager_;
+    std::vector<ReadPageGuard> read_set_;
+
+    std::vector<WritePageGuard> write_set_;
 
 };
 
@@ -147,6 +181,19 @@ private:
                                         BPlusTreeOpearion operation,
                                         bool *root_is_locked) const;
 
+
+    /**
+    * @brief search the key without acquiring any latch, every page is 
+    * read optimistically and validated by the version of its latch.
+    * 
+    * @param found return true when key exists
+    * @return false if a concurrent writer is detected or the key is
+    * stored in bucket chain, caller should retry or fall back to latches
+    */
+    bool OptimisticGetValue(const KeyType &key, 
+                            std::vector<ValueType> *result,
+                            bool *found) const;
+
     
     void ReadFromBucketChain(int first_bucket_num, 
                              std::vector<ValueType> *result) const;
@@ -158,15 +205,22 @@ private:
                              bool *need_to_delete_chain);
 
 
-    template<typename N>
-    N* CreateBTreePage(PageType page_type_, int *new_block_num);
+    /**
+    * @brief create a btree page, a deleted page is reused first
+    * @return the guard of the new page, it will be unpinned as dirty
+    */
+    BasicPageGuard CreateBTreePage(PageType page_type);
 
 
     void DeleteBTreePage(BPlusTreePage* old_page);
 
 
+    /**
+    * @brief move the upper half of old page to a new page
+    * @return the guard of the new page
+    */
     template<class N>
-    N* Split(N* old_page);
+    BasicPageGuard Split(N* old_page);
 
 
     std::tuple<int, int> GetBrotherNodeBlockNum(int parent_block_num, 
@@ -223,6 +277,25 @@ private:
         }
     }
 
+    /**
+    * @brief pin and latch a page, and add it to the end of page set
+    */
+    inline BPlusTreePage* LatchToPageSet(int block_num, BPlusTreeContext *context, 
+                                         BPlusTreeOpearion op) const {
+        Buffer *buffer;
+        if (op == BPlusTreeOpearion::QUERY) {
+            auto guard = buffer_manager_->PinBlockRead({index_file_name_, block_num});
+            buffer = guard.GetBuffer();
+            context->AddToPageSet(std::move(guard));
+        }
+        else {
+            auto guard = buffer_manager_->PinBlockWrite({index_file_name_, block_num});
+            buffer = guard.GetBuffer();
+            context->AddToPageSet(std::move(guard));
+        }
+        return reinterpret_cast<BPlusTreePage*>(buffer->contents()->GetRawDataPtr());
+    }
+
 
     bool IsParentSafe(BPlusTreePage *page, BPlusTreeOpearion op) const;
 
@@ -253,6 +326,9 @@ private:
     // root latch to concurrency
     mutable ReaderWriterLatch root_latch_;
 
+    // how many times getvalue reads optimistically before acquiring latches
+    static constexpr int OPTIMISTIC_READ_RETRY = 3;
+
     // two variable in memory to debug
     // this is not necessary
     int max_dir_size_;
@@ -1,6 +1,7 @@
 #ifndef B_PLUS_TREE_ITERATOR_H
 #define B_PLUS_TREE_ITERATOR_H
 
+#include "buffer/page_guard.h"
 #include "index/btree/b_plus_tree_page.h"
 #include "index/btree/b_plus_tree_bucket_page.h"
 #include "index/btree/b_plus_tree_leaf_page.h"
@@ -22,10 +23,10 @@ class BPlusTreeIterator {
 
 public:
   
-    BPlusTreeIterator(int curr_slot, int curr_block_num, Buffer *buffer,
+    BPlusTreeIterator(int curr_slot, int curr_block_num, ReadPageGuard &&guard,
                       BPlusTree<KeyType, ValueType, KeyComparator> *btree);
     BPlusTreeIterator() = default;
-    ~BPlusTreeIterator();
+    ~BPlusTreeIterator() = default;
 
     bool IsEnd();
 
@@ -56,8 +57,8 @@ private:
 
     int curr_block_num_;
 
-    // to lock or unlock
-    Buffer *buffer_;
+    // r-latched and pinned current leaf, released with the iterator
+    ReadPageGuard guard_;
 
     // cache current leaf page
     LeafPage *leaf_page_{nullptr};
@@ -120,11 +120,11 @@ public: // used by extendible hash table
 
     
     void SetPageType(PageType type) {
-        data_->SetPageType(type);
+        data_.SetPageType(type);
     }
 
     PageType GetPageType() const {
-        return data_->GetPageType();
+        return data_.GetPageType();
     }
 
 
@@ -180,32 +180,32 @@ private:
     static constexpr int PAGE_HEADER_SIZE = TYPE_ID_OFFSET + sizeof(int);
     
     void SetPageLsn(lsn_t lsn) {
-        data_->SetLsn(lsn);
+        data_.SetLsn(lsn);
     }
 
     lsn_t GetPageLsn() const {
-        return data_->GetLsn();
+        return data_.GetLsn();
     }
 
 
     void SetDataArrayPtr(int n) {
-        data_->SetInt(DATA_ARRAY_PTR_OFFSET, n);
+        data_.SetInt(DATA_ARRAY_PTR_OFFSET, n);
     }
 
     int GetDataArrayPtr() const {
-        return data_->GetInt(DATA_ARRAY_PTR_OFFSET);
+        return data_.GetInt(DATA_ARRAY_PTR_OFFSET);
     }
 
     void SetTupleSize(int size) {
-        data_->SetInt(TUPLE_SIZE_OFFSET, size);
+        data_.SetInt(TUPLE_SIZE_OFFSET, size);
     }
 
     int GetTupleSize() const {
-        return data_->GetInt(TUPLE_SIZE_OFFSET);
+        return data_.GetInt(TUPLE_SIZE_OFFSET);
     }
 
     int GetMaxTupleCount() const {
-        int free_space = data_->GetSize() - PAGE_HEADER_SIZE;
+        int free_space = data_.GetSize() - PAGE_HEADER_SIZE;
         int tuple_size = GetTupleSize();
         return (4 * free_space / (4 * tuple_size + 1));
     }
@@ -215,11 +215,11 @@ private:
     }
 
     TypeID GetTypeID() const {
-        return static_cast<TypeID> (data_->GetInt(TYPE_ID_OFFSET));
+        return static_cast<TypeID> (data_.GetInt(TYPE_ID_OFFSET));
     }
 
     void SetTypeID(TypeID type) {
-        data_->SetInt(TYPE_ID_OFFSET, static_cast<int>(type));
+        data_.SetInt(TYPE_ID_OFFSET, static_cast<int>(type));
     }
 
 };
@@ -0,0 +1,160 @@
+#ifndef LOG_FILE_H
+#define LOG_FILE_H
+
+#include "file/file_manager.h"
+#include "config/config.h"
+#include "config/type.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace SimpleDB {
+
+/**
+* @brief LogFile stores the log as a sequence of fixed-size segment files,
+* named log_name.<segment id>. the offset of log is logical, segment i
+* holds the log in [i * segment_size, (i + 1) * segment_size).
+*
+* segments are preallocated and filled with zero before they are used,
+* so writing log never extends a file, and the end of log is the first
+* zero length after the last written record. log manager never lets a
+* record span two segments, the space at the end of a segment which is
+* too small for the next record is left as zero.
+*
+* the segments before the oldest needed log are recycled by renaming
+* them to future segments, so the disk usage of log is bounded. the offset
+* keeps growing across recycling, so it's 64-bit.
+*/
+class LogFile {
+
+public:
+
+    /**
+    * @brief open the segments of log and find the end of log
+    * @param log_name the prefix of segment files
+    * @param segment_size the size of a segment, it should be a multiple of block size
+    */
+    LogFile(FileManager *file_manager, const std::string &log_name,
+            int segment_size = SIMPLEDB_LOG_SEGMENT_SIZE);
+
+    ~LogFile();
+
+    LogFile(const LogFile &) = delete;
+    LogFile& operator=(const LogFile &) = delete;
+
+    /**
+    * @brief write the data at the end of log, only one thread should append at a time
+    */
+    void Append(const char *data, int size);
+
+    /**
+    * @brief read size bytes at offset, the bytes past the end
+    * or before the begin of log are zero
+    */
+    void Read(log_offset_t offset, char *buf, int size);
+
+    /**
+    * @brief make all the appended log durable
+    */
+    void Sync();
+
+    /**
+    * @brief recycle the segments whose log are all before offset,
+    * the log before the first remaining segment can't be read anymore
+    */
+    void Truncate(log_offset_t offset);
+
+    /**
+    * @brief the first offset which can be read
+    */
+    log_offset_t GetBeginOffset() const { return begin_segment_ * segment_size_; }
+
+    log_offset_t GetEndOffset() const { return end_offset_; }
+
+    int GetSegmentSize() const { return segment_size_; }
+
+    /**
+    * @brief the number of segment files, including the preallocated ones
+    */
+    int GetSegmentNum();
+
+private:
+
+    /**
+    * @brief an opened segment file. reading and syncing use it without
+    * holding the latch, so the fd is closed after the last of them
+    * drops its reference, not when the segment is truncated
+    */
+    struct Segment {
+
+        explicit Segment(int fd) : fd_(fd) {}
+
+        ~Segment();
+
+        Segment(const Segment &) = delete;
+        Segment& operator=(const Segment &) = delete;
+
+        int fd_;
+    };
+
+    std::string SegmentName(log_offset_t segment_id) const;
+
+    /**
+    * @brief get the segment, create and prepare it if not exist
+    */
+    std::shared_ptr<Segment> GetSegment(log_offset_t segment_id);
+
+    /**
+    * @brief make the creating, renaming and deleting of segments durable
+    */
+    void SyncDirectory();
+
+    /**
+    * @brief allocate the space of segment and fill it with zero
+    * @param recycled whether it contains the log of an old segment
+    */
+    void PrepareSegment(int fd, bool recycled);
+
+    /**
+    * @brief scan the last used segment to find the end of log
+    */
+    void FindEnd();
+
+    FileManager *file_manager_;
+
+    std::string log_name_;
+
+    // the directory which contains the segments
+    std::string directory_;
+
+    int segment_size_;
+
+    // protect segments_, dirty_segments_ and recycling_segments_
+    std::mutex latch_;
+
+    // segment id -> segment, including preallocated segments
+    std::map<log_offset_t, std::shared_ptr<Segment>> segments_;
+
+    // the segments which have been written since last sync
+    std::set<log_offset_t> dirty_segments_;
+
+    // the future segment ids reserved by truncating, their files are
+    // zeroed and renamed without holding the latch
+    std::set<log_offset_t> recycling_segments_;
+
+    // notified when the reserved segments are ready
+    std::condition_variable recycle_cv_;
+
+    std::atomic<log_offset_t> begin_segment_{0};
+
+    std::atomic<log_offset_t> end_offset_{0};
+};
+
+} // namespace SimpleDB
+
+#endif
@@ -1,9 +1,8 @@
 #ifndef LOGITERATOR_H
 #define LOGITERATOR_H
 
-#include "file/block_id.h"
 #include "file/page.h"
-#include "file/file_manager.h"
+#include "log/log_file.h"
 
 #include <memory>
 
@@ -11,7 +10,7 @@ namespace SimpleDB {
 
 /**
 * @brief a logiterator object, can be used to access the log file
-    which stored in disk.
+    which stored in disk. the zero space at the end of a segment is skipped.
 */
 class LogIterator {
     
@@ -20,7 +19,7 @@ public:
     /**
     * @brief 
     */
-    LogIterator(FileManager *file_manager, std::string file_name, int offset);
+    LogIterator(LogFile *log_file, int block_size, log_offset_t offset);
 
     /**
     * @brief whether has next record
@@ -45,31 +44,34 @@ public:
     /**
     * @brief move to the specified position 
     * 
-    * @param offset the offset of the log file
+    * @param offset the offset of the log file, it should be the start of a record
     * @return the byte-array of the specified log record
     */
-    std::vector<char> MoveToRecord(int offset);
+    std::vector<char> MoveToRecord(log_offset_t offset);
 
-    int GetLogOffset() {
+    log_offset_t GetLogOffset() {
         return file_offset_;
     }
     
 private:
 
-    // shared file_manager
-    FileManager* file_manager_;
-    // log file name
-    std::string log_name_;
+    /**
+    * @brief move to the next segment if the rest of current segment is not used
+    */
+    void SkipSegmentEnd();
+
+    // shared log file
+    LogFile *log_file_;
     // read buff
     std::unique_ptr<Page> read_buf_;
-    // read buffer size
+    // read buffer size, it grows for the records larger than a block
     int buffer_size_;
     // read count
     int buffer_offset_;
     // the position in log file
-    int file_offset_;
+    log_offset_t file_offset_;
     // the size of log file 
-    int log_file_size_;
+    log_offset_t log_file_size_;
 };
 
 } // namespace SimpleDB
@@ -7,12 +7,18 @@
 #include <thread>
 #include <atomic>
 #include <condition_variable>
+#include <deque>
+#include <vector>
+#include <chrono>
+#include <functional>
 
 #include "file/file_manager.h"
 #include "file/page.h"
 #include "file/block_id.h"
 #include "log/log_iterator.h"
+#include "log/log_file.h"
 #include "config/type.h"
+#include "config/config.h"
 #include "recovery/log_record.h"
 
 namespace SimpleDB {
@@ -39,18 +45,53 @@ public:
     * 
     * @param file_manager Accepts a pointer parameter
     * @param log_file_name    
+    * @param buffer_num the number of log buffers, appenders fill one of them
+    * while the full ones are being written
+    * @param buffer_block_num the size of a log buffer, in blocks
+    * @param segment_size the size of a log segment file
     */
-    LogManager(FileManager* file_manager, std::string log_file_name);
+    LogManager(FileManager* file_manager, std::string log_file_name,
+               int buffer_num = SIMPLEDB_LOG_BUFFER_NUM,
+               int buffer_block_num = SIMPLEDB_LOG_BUFFER_BLOCK_NUM,
+               int segment_size = SIMPLEDB_LOG_SEGMENT_SIZE);
     
     
-    ~LogManager() = default;
+    ~LogManager();
     
     /**
     * @brief be always used when dirty pages are to be writen back to disk
+    * and when a transaction commits. the log is durable up to lsn after returning.
+    * if flush thread is running, the caller waits for it instead of writing,
+    * so one write and sync covers all the committers arriving in the meantime
     * 
     * @param lsn the lastest lsn of dirty page
     */
     void Flush(lsn_t lsn);
+
+    /**
+    * @brief return without waiting, the log up to lsn is durable after 
+    * the next round of flush thread, i.e. within its interval plus the 
+    * time of a write and sync. the flush thread is started if it's not running
+    */
+    void FlushAsync(lsn_t lsn);
+
+    /**
+    * @brief the log up to the returned lsn is durable
+    */
+    lsn_t GetFlushedLsn() const { return last_flush_lsn_; }
+
+    /**
+    * @brief start a background thread which owns the writing of log file.
+    * appenders fill one buffer while it writes and syncs the other one
+    * @param interval how long the flusher sleeps if nobody waits for it
+    */
+    void StartFlushThread(std::chrono::milliseconds interval = 
+                              std::chrono::milliseconds(SIMPLEDB_LOG_FLUSH_INTERVAL_MS));
+
+    /**
+    * @brief stop the flush thread after it writes all the buffered logs
+    */
+    void StopFlushThread();
     
     
     lsn_t Append(const std::vector<char> &log_record);
@@ -64,12 +105,12 @@ public:
     * @param offset return the offset of log_record in log file 
     * @return the lsn of log
     */
-    lsn_t AppendLogWithOffset(LogRecord &log_record,int *offset);
+    lsn_t AppendLogWithOffset(LogRecord &log_record, log_offset_t *offset);
 
     /**
     * @brief use iterator to access log file
     * 
-    * @return the first log-record in log file
+    * @return the first log-record in log file which has not been truncated
     */
     LogIterator Iterator();
 
@@ -79,23 +120,108 @@ public:
     * @param offset the offset of the log file
     * @return the specified log-record in log file
     */
-    LogIterator Iterator(int offset);
+    LogIterator Iterator(log_offset_t offset);
 
     
-    void SetLastestLsn(lsn_t lsn) { lastest_lsn_.store(lsn); }
+    void SetLastestLsn(lsn_t lsn);
 
-    void SetMasterLsnOffset(int offset);
+    /**
+    * @brief the log before offset is not needed by recovery anymore,
+    * the segments which only contain such log are recycled
+    */
+    void Truncate(log_offset_t offset) { log_file_->Truncate(offset); }
 
-    int GetMasterLsnOffset();
+    void SetMasterLsnOffset(log_offset_t offset);
+
+    log_offset_t GetMasterLsnOffset();
 
 private:
-    
+
+    /**
+    * @brief a log buffer. appenders reserve space in the active one by a cas 
+    * on state_, then copy their records into it in parallel
+    */
+    struct LogBuffer {
+        std::unique_ptr<Page> page_;
+        // the lsn of the last reserved log in high 32 bits and 
+        // the reserved size in low 32 bits
+        std::atomic<uint64_t> state_;
+        // the size of logs which have been copied into page
+        std::atomic<int> filled_{0};
+        // the offset of page in log file
+        std::atomic<log_offset_t> file_offset_{0};
+        // the size of logs and the lsn of the last log, set when it's sealed
+        int count_{0};
+        lsn_t last_lsn_{INVALID_LSN};
+    };
+
+    /**
+    * @brief the space of a log record in a buffer
+    */
+    struct Reservation {
+        LogBuffer *buffer_;
+        int offset_;
+        int size_;
+        lsn_t lsn_;
+        // a full buffer was sealed by this appender, it should write 
+        // the buffer by WriteSealedBuffers after copying its record
+        bool sealed_;
+    };
+
+    // a sealed buffer has a reserved size larger than any buffer,
+    // so appenders can't reserve space in it
+    static constexpr uint64_t SEALED_OFFSET = 0x7fffffff;
+    static constexpr uint64_t OFFSET_MASK = 0xffffffff;
+    static constexpr int LSN_SHIFT = 32;
+
+    static inline uint64_t MakeState(lsn_t lsn, uint64_t offset) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(lsn)) << LSN_SHIFT) | offset;
+    }
+
+    static inline lsn_t StateLsn(uint64_t state) {
+        return static_cast<lsn_t>(static_cast<uint32_t>(state >> LSN_SHIFT));
+    }
+
+    /**
+    * @brief make all the buffered logs durable
+    */
+    void FlushAll();
+
+    /**
+    * @brief reserve space for a log record and give it a lsn, it doesn't
+    * take the latch unless the active buffer is full
+    * @param size_of the space needed by the record if it gets the lsn,
+    * the size of a varint-encoded record depends on its lsn
+    */
+    Reservation ReserveSpace(const std::function<int(lsn_t)> &size_of);
+
     /**
-    * @brief flush the current buffer to log file which stores in disk
-    * always be called when log_count_ past than buffer_size_
-    * and write some log immediately
+    * @brief reserve space for a log record and serialize it there, 
+    * the caller should call FinishAppend after that
     */
-    void Flush();
+    Reservation ReserveAndWrite(LogRecord &log_record);
+
+    /**
+    * @brief mark the record as copied, and write the buffer sealed by us
+    */
+    void FinishAppend(const Reservation &res);
+
+    /**
+    * @brief hand the current buffer over to writers and switch to a free one, 
+    * the caller should hold the latch and the buffer should not be empty
+    * @return false if there is no free buffer
+    */
+    bool SealBuffer();
+
+    /**
+    * @brief write the sealed buffers to log file in order,
+    * the caller should not hold the latch
+    * @param sync whether to sync log file after writing, and
+    * seal the current buffer first so that all logs are durable
+    */
+    void WriteSealedBuffers(bool sync);
+
+    void FlushThreadLoop(std::chrono::milliseconds interval);
     
 private:
     
@@ -104,36 +230,38 @@ private:
     FileManager * file_manager_;
     // file_name, is not a path
     std::string log_file_name_;
-    // write count and instructs the next location which be written
-    int log_count_;
-    // a page in memeory 
-    std::unique_ptr<Page> log_buffer_;
-    // lastest lsn 
-    std::atomic<lsn_t> lastest_lsn_{INVALID_LSN};
+    // the segments of log
+    std::unique_ptr<LogFile> log_file_;
+    // all log buffers
+    std::vector<std::unique_ptr<LogBuffer>> buffers_;
+    // the buffer which appenders are filling, only switched under latch_
+    std::atomic<LogBuffer*> active_buffer_;
+    // empty buffers
+    std::vector<LogBuffer*> free_buffers_;
+    // full buffers, in the order of lsn
+    std::deque<LogBuffer*> sealed_buffers_;
+    // the last lsn which has been written to log file, but may not be synced
+    lsn_t last_write_lsn_{INVALID_LSN};
+    // serialize writing and syncing of log file, it's acquired before latch_
+    std::mutex write_latch_;
     // last lsn which saved to disk
     std::atomic<lsn_t> last_flush_lsn_{INVALID_LSN};
-    // latch
+    // protect switching buffers
     std::mutex latch_;
-    // cache block_size
+    // the size of a log buffer
     int buffer_size_;
-    // file_size
-    int log_file_size_;
     
-    /********* advance log-manager *********/
-    // TODO ....
-    // a flush buff in memory
-    // std::unique_ptr<Page> flush_page_;
+    /********* group commit *********/
     // background thread for flushing 
-    // std::unique_ptr<std::thread> flush_thread_;
+    std::unique_ptr<std::thread> flush_thread_;
     // whether flush_thread working?
-    // std::atomic<bool> enable_flushing_;
+    std::atomic<bool> enable_flushing_{false};
+    // someone is waiting for the flush thread
+    bool need_flush_{false};
     // cv used to wakeup the background thread
-    // std::condition_variable flush_cv_;
-    // cv used to block normal operation
-    // std::condition_variable operation_cv_;
-    // sleep time
-    // std::chrono::milliseconds sleep_time_{300};
-    /****************************************/
+    std::condition_variable flush_cv_;
+    // cv used to block committers and appenders until a flush is done
+    std::condition_variable operation_cv_;
 };
 
 } // namespace SimpleDB
@@ -67,7 +67,13 @@ public:
     BlockId AppendBlock(Transaction *txn);
 
     
-    TableIterator Begin(Transaction *txn);
+    /**
+    * @brief return an iterator which points to the first tuple
+    * @param bulk_read whether it's a sequential scan. blocks are read ahead,
+    *  and if the table is large compared to bufferpool, the scan only recycles 
+    *  a small ring of frames, so it won't evict the working set of others
+    */
+    TableIterator Begin(Transaction *txn, bool bulk_read = false);
 
     TableIterator End();
 
@@ -32,15 +32,17 @@ public:
     * @param table_heap 
     * @param rid 
     */
-    TableIterator(Transaction *txn, TableHeap *table_heap, RID rid)
+    TableIterator(Transaction *txn, TableHeap *table_heap, RID rid,
+                  std::shared_ptr<BufferAccessStrategy> strategy = nullptr)
         : txn_(txn),
           table_heap_(table_heap),
           rid_(rid),
-          tuple_(Tuple()) {
+          tuple_(Tuple()),
+          strategy_(std::move(strategy)) {
 
             // cache a table page
             if (rid_.GetBlockNum() != -1) {
-                table_page_ = static_cast<TablePage*> (txn_->PinBlock(GetBlock()));
+                PinTablePage();
             }
           }
 
@@ -48,11 +50,12 @@ public:
         : txn_(other.txn_),
           table_heap_(other.table_heap_),
           rid_(other.rid_),
-          tuple_(other.tuple_) {
+          tuple_(other.tuple_),
+          strategy_(other.strategy_) {
             
             // we should pin this table page again
             if (rid_.GetBlockNum() != -1) {
-                table_page_ = static_cast<TablePage*> (txn_->PinBlock(GetBlock()));
+                PinTablePage();
             }
           }
 
@@ -65,14 +68,15 @@ public:
         std::swap(iter.rid_, rid_);
         std::swap(iter.table_heap_, table_heap_);
         std::swap(iter.tuple_, tuple_);
-        std::swap(iter.table_page_, table_page_);  
+        std::swap(iter.page_guard_, page_guard_);  
+        std::swap(iter.strategy_, strategy_);
     }
 
 
     inline bool operator==(const TableIterator &iter) const {
         return rid_ == iter.rid_ &&
                table_heap_ == iter.table_heap_ &&
-               table_page_ == iter.table_page_;
+               page_guard_.GetBuffer() == iter.page_guard_.GetBuffer();
     }
 
     inline bool operator!=(const TableIterator &iter) const {
@@ -126,6 +130,19 @@ private:
     void GetTuple();
 
 
+    /**
+    * @brief pin the block of rid_ and cache it
+    */
+    inline void PinTablePage() {
+        page_guard_ = txn_->GetBufferManager()->PinBlockGuarded(GetBlock(), strategy_.get());
+    }
+
+
+    inline TablePage* GetTablePage() const {
+        return page_guard_.As<TablePage>();
+    }
+
+
 private:
 
     // txn provides us with execution context
@@ -137,11 +154,16 @@ private:
     // current position
     RID rid_;
 
-    // cache table page to reduce system calls
-    TablePage* table_page_{nullptr};
+    // cache table page to reduce system calls, the pin 
+    // is released when iterator moves to next block
+    BasicPageGuard page_guard_;
 
     // cache tuple to reduce copy
     Tuple tuple_;
+
+    // the ring of frames used by a bulk scan, copies of
+    // the iterator share it. null means a normal scan
+    std::shared_ptr<BufferAccessStrategy> strategy_;
 };
 
 } // namespace SimpleDB
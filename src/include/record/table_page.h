@@ -68,6 +68,18 @@ public:
     bool GetTuple(const RID &rid, Tuple *tuple);
 
 
+    /**
+    * @brief read the specified tuple without the read latch. 
+    * the page is validated by its version after reading, so
+    * the page should be pinned but not latched by caller
+    * 
+    * @param exist return whether the tuple exists, same as GetTuple
+    * @return false if a concurrent writer is detected, then
+    *  caller should read it again with the read latch
+    */
+    bool OptimisticGetTuple(const RID &rid, Tuple *tuple, bool *exist);
+
+
     /**
     * @brief Without specifying a specific location, 
     * find an empty slot and insert it
@@ -135,7 +147,7 @@ public:
     BlockId GetBlock() const { return block_; }
 
 
-    Page* GetData() { return data_.get(); }
+    Page* GetData() { return &data_; }
 
 
     std::string ToString(const Schema &schema);
@@ -154,25 +166,25 @@ private:
 
 
     inline void SetTupleCount(int new_count) {
-        data_->SetInt(TUPLE_COUNT_OFFSET, new_count);
+        data_.SetInt(TUPLE_COUNT_OFFSET, new_count);
     }
 
     inline int GetTupleCount() {
-        int res = data_->GetInt(TUPLE_COUNT_OFFSET);
+        int res = data_.GetInt(TUPLE_COUNT_OFFSET);
         return res;
     }
 
     inline void SetFreeSpacePtr(int new_ptr) {
-        data_->SetInt(FREE_SPACE_PTR_OFFSET, new_ptr);
+        data_.SetInt(FREE_SPACE_PTR_OFFSET, new_ptr);
     }
 
     inline int GetFreeSpacePtr() {
-        return data_->GetInt(FREE_SPACE_PTR_OFFSET);
+        return data_.GetInt(FREE_SPACE_PTR_OFFSET);
     }
 
     inline int GetTupleSize(int slot) {
         int tuple_offset = GetTupleOffset(slot);
-        return data_->GetInt(tuple_offset);
+        return data_.GetInt(tuple_offset);
     }
 
     /**
@@ -181,7 +193,7 @@ private:
     void SetTupleOffset(int slot, int pos) {
         SIMPLEDB_ASSERT(slot < GetTupleCount(), "overflow");
         int slot_pos = SLOT_ARRAY_OFFSET + SLOT_SIZE * slot;
-        data_->SetInt(slot_pos, pos);
+        data_.SetInt(slot_pos, pos);
     }
 
     /**
@@ -190,7 +202,7 @@ private:
     int GetTupleOffset(int slot) {
         SIMPLEDB_ASSERT(slot < GetTupleCount(), "overflow");
         int slot_pos = SLOT_ARRAY_OFFSET + SLOT_SIZE * slot;
-        return data_->GetInt(slot_pos);
+        return data_.GetInt(slot_pos);
     }
 
     /**
@@ -0,0 +1,163 @@
+#ifndef LOG_CODEC_H
+#define LOG_CODEC_H
+
+#include "config/macro.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace SimpleDB {
+
+/**
+* @brief LogEncoder writes the fields of a log record into a byte array.
+* integers are written as varints, 7 bits per byte and the high bit means
+* more bytes follow, so small numbers such as txn id, slot and size only
+* take one or two bytes. signed numbers are zigzag encoded first, so a
+* small negative number (e.g. INVALID_LSN) is small too.
+*
+* the caller should calculate the size by the static size functions
+* and prepare enough space before writing.
+*/
+class LogEncoder {
+
+public:
+
+    explicit LogEncoder(char *buf) : buf_(buf) {}
+
+    static inline uint64_t ZigZag(int64_t n) {
+        return (static_cast<uint64_t>(n) << 1) ^ static_cast<uint64_t>(n >> 63);
+    }
+
+    static inline int VarintSize(uint64_t n) {
+        int size = 1;
+        while (n >= 0x80) {
+            n >>= 7;
+            size ++;
+        }
+        return size;
+    }
+
+    static inline int SignedVarintSize(int64_t n) {
+        return VarintSize(ZigZag(n));
+    }
+
+    /**
+    * @brief the size of a byte array with its length
+    */
+    static inline int BytesSize(int size) {
+        return VarintSize(size) + size;
+    }
+
+    inline void PutByte(uint8_t n) {
+        buf_[offset_ ++] = static_cast<char>(n);
+    }
+
+    inline void PutVarint(uint64_t n) {
+        while (n >= 0x80) {
+            buf_[offset_ ++] = static_cast<char>(n | 0x80);
+            n >>= 7;
+        }
+        buf_[offset_ ++] = static_cast<char>(n);
+    }
+
+    inline void PutSignedVarint(int64_t n) {
+        PutVarint(ZigZag(n));
+    }
+
+    /**
+    * @brief write the data without its length
+    */
+    inline void PutRaw(const char *data, int size) {
+        if (size > 0) {
+            memcpy(buf_ + offset_, data, size);
+        }
+        offset_ += size;
+    }
+
+    inline void PutBytes(const char *data, int size) {
+        PutVarint(size);
+        PutRaw(data, size);
+    }
+
+    inline void PutString(const std::string &str) {
+        PutBytes(str.data(), str.size());
+    }
+
+    inline int GetOffset() const { return offset_; }
+
+private:
+
+    char *buf_;
+
+    int offset_{0};
+};
+
+
+/**
+* @brief LogDecoder reads the fields written by LogEncoder in the same order
+*/
+class LogDecoder {
+
+public:
+
+    LogDecoder(const char *buf, int size) : buf_(buf), size_(size) {}
+
+    static inline int64_t UnZigZag(uint64_t n) {
+        return static_cast<int64_t>(n >> 1) ^ -static_cast<int64_t>(n & 1);
+    }
+
+    inline uint8_t GetByte() {
+        SIMPLEDB_ASSERT(offset_ < size_, "log record is truncated");
+        return static_cast<uint8_t>(buf_[offset_ ++]);
+    }
+
+    inline uint64_t GetVarint() {
+        uint64_t n = 0;
+        for (int shift = 0;;shift += 7) {
+            uint8_t byte = GetByte();
+            n |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return n;
+            }
+        }
+    }
+
+    inline int64_t GetSignedVarint() {
+        return UnZigZag(GetVarint());
+    }
+
+    /**
+    * @brief read size bytes which are written without length
+    */
+    inline std::vector<char> GetRaw(int size) {
+        SIMPLEDB_ASSERT(size >= 0 && offset_ + size <= size_, "log record is truncated");
+        std::vector<char> data(buf_ + offset_, buf_ + offset_ + size);
+        offset_ += size;
+        return data;
+    }
+
+    inline std::vector<char> GetBytes() {
+        return GetRaw(GetVarint());
+    }
+
+    inline std::string GetString() {
+        auto data = GetBytes();
+        return std::string(data.begin(), data.end());
+    }
+
+    inline int GetOffset() const { return offset_; }
+
+private:
+
+    const char *buf_;
+
+    int size_;
+
+    int offset_{0};
+};
+
+} // namespace SimpleDB
+
+#endif
@@ -6,6 +6,7 @@
 #include "config/type.h"
 #include "record/tuple.h"
 #include "file/page.h"
+#include "recovery/log_codec.h"
 
 #include <cstring>
 #include <sstream>
@@ -41,12 +42,20 @@ enum class LogRecordType {
 * several SetInt and SetString.
 *
 * LOG HEADER (record size will be automatically add by logmanager)
-* -------------------------------------------------------
-* | LSN | txn_ID | prevLSN | Logtype | IsCLR | UndoNext |
-* -------------------------------------------------------
+* ------------------------------------------------------------------
+* | Flags | LSN | txn_ID | LSN - prevLSN | LSN - UndoNext |
+* ------------------------------------------------------------------
 * the undo next is a lsn number, we only use it when undo phase
 * so, only clr log need this undonext flag.otherwise, this flag is usually INVALID 
 *
+* flags is a byte holding the log type, IsCLR, and whether prevLSN and
+* UndoNext exist. the other fields are varints (see LogEncoder), prevLSN
+* and UndoNext are stored as the distance to LSN, which is usually small.
+* so a header usually takes 6-8 bytes instead of 24 bytes. since the size
+* of header depends on LSN, RecordSize should be called after SetLsn.
+*
+* the ints in the body (rid, sizes, block number) are varints as well.
+*
 * For CheckPointBegin, InitPage, begin, commit, abort
 * ----------
 * | Header | 
@@ -59,17 +68,22 @@ enum class LogRecordType {
 * -----------------------------------------------------------------------
 * | Header | FileName.size() | FileName | RID | Tuple size | Tuple Data |
 * -----------------------------------------------------------------------
-* For update type log record
-* -----------------------------------------------------------------------------------------------------------------
-* | Header | FileName.size() | FileName | RID | Old Tuple size | Old Tuple Data | New Tuple size | New Tuple Data |
-* -----------------------------------------------------------------------------------------------------------------
+* For update type log record, only the changed byte ranges of tuple are stored
+* ----------------------------------------------------------------------------------------------
+* | Header | FileName.size() | FileName | RID | Old Tuple size | New Tuple size | Range count | 
+* ----------------------------------------------------------------------------------------------
+* every range is 
+* ---------------------------------------------------------------------
+* | Gap | Old Data size | Old Data | New Data size | New Data |
+* ---------------------------------------------------------------------
+* gap is the count of unchanged bytes since the end of last range
 * For init page type log record, we will change the size of table file in redo or undo phase
 * -----------------------------------------------------
 * | Header | FileName.size() | FileName | BlockNumber |
 * -----------------------------------------------------
 * For CheckPointEnd Log Record
 * --------------------------------------------------------------------------------------------------
-* | Header | txn map size | txn map data(char [] array) | dp map size | dp map data(char [] array) |
+* | Header | txn map count | txn map data(char [] array) | dp map count | dp map data(char [] array) |
 * --------------------------------------------------------------------------------------------------
 *
 * NOTE THAT, lsn、prev_lsn、undo_next_lsn will be automatically added by logmanager
@@ -147,12 +161,24 @@ public:
 
     virtual std::string ToString() = 0;
 
+    /**
+    * @brief write the logrecord into buf in place, the size of 
+    * buf should be at least RecordSize(). log manager reserves 
+    * RecordSize() bytes in log buffer and writes the record there, 
+    * so appending a record doesn't need a temporary byte array
+    */
+    virtual void WriteTo(char *buf) = 0;
+
     /**
     * @brief turn a logrecord object into the byte-sequence
     * 
     * @return byte-sequence
     */
-    virtual std::shared_ptr<std::vector<char>> Serializeto() = 0;
+    std::shared_ptr<std::vector<char>> Serializeto() {
+        auto array = std::make_shared<std::vector<char>> (RecordSize());
+        WriteTo(array->data());
+        return array;
+    }
 
     /**
     * @brief turn byte-sequence into a logrecord
@@ -165,25 +191,34 @@ public:
 public: 
 
     // helper variable
-    static constexpr uint32_t HEADER_SIZE = 
-         // ------------------------------------------------------------------------------------------------------
-         // | lsn           | txn_id_          | prev_lsn      | record_type           | is_clr      | undo_next |
-         // ------------------------------------------------------------------------------------------------------
-            sizeof(lsn_t) + sizeof(txn_id_t) + sizeof(lsn_t) + sizeof(LogRecordType) + sizeof(int) + sizeof(lsn_t);
+    // ---------------------------------------------
+    // | log type (4 bits) | clr | prev | undo_next |
+    // ---------------------------------------------
+    static constexpr uint8_t TYPE_MASK = 0x0f;
+    static constexpr uint8_t CLR_FLAG = 0x10;
+    static constexpr uint8_t PREV_LSN_FLAG = 0x20;
+    static constexpr uint8_t UNDO_NEXT_FLAG = 0x40;
 
 protected: 
 
     /**
-    * @brief helper function which build a page with log header
+    * @brief the size of log header, it depends on lsn
+    */
+    int HeaderSize();
+
+    /**
+    * @brief helper function which write log header
     * 
-    * @return a built page
+    * @param encoder it's after the header when return
     */
-    Page GetHeaderPage(int record_size);
+    void SerializeHeader(LogEncoder *encoder);
 
     /**
     * @brief helper function which get header information through page
+    * 
+    * @param decoder it's after the header when return
     */
-    void GetHeaderInfor(Page *p);
+    void DeserializeHeader(LogDecoder *decoder);
 
 protected: /* can be accessed by child class, can not be access by other class */
     
@@ -211,18 +246,19 @@ public:
     ChkptBeginRecord() : LogRecord() { type_ = LogRecordType::CHECKPOINTBEGIN; }
     
     ChkptBeginRecord(Page *p) { 
-        GetHeaderInfor(p);
+        LogDecoder decoder(p->GetRawDataPtr(), p->GetSize());
+        DeserializeHeader(&decoder);
         assert(type_ == LogRecordType::CHECKPOINTBEGIN);
     }
     
     int RecordSize() override {
-        return HEADER_SIZE;
+        return HeaderSize();
     }
 
 
     std::string ToString() override { return GetHeaderToString(); }
 
-    std::shared_ptr<std::vector<char>> Serializeto() override;
+    void WriteTo(char *buf) override;
 
     // for debugging purpose
     bool operator ==(const ChkptBeginRecord &obj) const {
@@ -313,7 +349,7 @@ public:
 
     std::string ToString() override;
 
-    std::shared_ptr<std::vector<char>> Serializeto() override;
+    void WriteTo(char *buf) override;
 
     // for debugging purpose
     bool operator ==(const ChkptEndRecord &obj) const {
@@ -368,18 +404,19 @@ public:
     }
     
     BeginRecord(Page *p) {
-        GetHeaderInfor(p);
+        LogDecoder decoder(p->GetRawDataPtr(), p->GetSize());
+        DeserializeHeader(&decoder);
         assert(type_ == LogRecordType::BEGIN);
     }
     
     int RecordSize() override {
-        return HEADER_SIZE;
+        return HeaderSize();
     }
 
 
     std::string ToString() override { return GetHeaderToString(); }
 
-    std::shared_ptr<std::vector<char>> Serializeto() override;
+    void WriteTo(char *buf) override;
 
     // for debugging purpose
     bool operator ==(const BeginRecord &obj) const {
@@ -406,7 +443,8 @@ public:
     CommitRecord() = default;
     
     CommitRecord(Page *p) { 
-        GetHeaderInfor(p); 
+        LogDecoder decoder(p->GetRawDataPtr(), p->GetSize());
+        DeserializeHeader(&decoder); 
         assert(type_ == LogRecordType::COMMIT);
     }
 
@@ -416,13 +454,13 @@ public:
     }
     
     int RecordSize() override {
-        return HEADER_SIZE;
+        return HeaderSize();
     }
 
 
     std::string ToString() override { return GetHeaderToString(); }
 
-    std::shared_ptr<std::vector<char>> Serializeto() override;
+    void WriteTo(char *buf) override;
 
     // for debugging purpose
     bool operator ==(const CommitRecord &obj) const {
@@ -455,18 +493,19 @@ public:
     }
     
     AbortRecord(Page *p) {
-        GetHeaderInfor(p);
+        LogDecoder decoder(p->GetRawDataPtr(), p->GetSize());
+        DeserializeHeader(&decoder);
         assert(type_ == LogRecordType::ABORT);
     }
     
     int RecordSize() override {
-        return HEADER_SIZE;
+        return HeaderSize();
     }
 
 
     std::string ToString() override { return GetHeaderToString(); }
 
-    std::shared_ptr<std::vector<char>> Serializeto() override;
+    void WriteTo(char *buf) override;
 
     // for debugging purpose
     bool operator ==(const AbortRecord &obj) const {
@@ -498,18 +537,19 @@ public:
     }
     
     TxnEndRecord(Page *p) {
-        GetHeaderInfor(p);
+        LogDecoder decoder(p->GetRawDataPtr(), p->GetSize());
+        DeserializeHeader(&decoder);
         assert(type_ == LogRecordType::TXNEND);
     }
     
     int RecordSize() override {
-        return HEADER_SIZE;
+        return HeaderSize();
     }
 
 
     std::string ToString() override { return GetHeaderToString(); }
 
-    std::shared_ptr<std::vector<char>> Serializeto() override;
+    void WriteTo(char *buf) override;
 
     // for debugging purpose
     bool operator ==(const TxnEndRecord &obj) const {
@@ -554,13 +594,13 @@ public:
                  const Tuple &tuple);
     
     int RecordSize() override {
-        return record_size_;
+        return HeaderSize() + body_size_;
     }
 
 
     std::string ToString() override;
 
-    std::shared_ptr<std::vector<char>> Serializeto() override;
+    void WriteTo(char *buf) override;
 
     inline std::string GetFileName() {
         return file_name_;
@@ -582,7 +622,7 @@ public:
                prev_lsn_ == obj.prev_lsn_ && 
                file_name_ == obj.file_name_ &&
                rid_ == obj.rid_ && 
-               record_size_ == obj.record_size_ && 
+               body_size_ == obj.body_size_ && 
                is_clr_ == obj.is_clr_ &&
                undo_next_ == obj.undo_next_  &&
                tuple_ == obj.tuple_;
@@ -600,7 +640,8 @@ private:
 
     Tuple tuple_;
 
-    int record_size_;
+    // the size of record except header
+    int body_size_;
 };
 
 
@@ -618,13 +659,13 @@ public:
                  const Tuple &tuple);
     
     int RecordSize() override {
-        return record_size_;
+        return HeaderSize() + body_size_;
     }
 
 
     std::string ToString() override;
 
-    std::shared_ptr<std::vector<char>> Serializeto() override;
+    void WriteTo(char *buf) override;
 
     inline std::string GetFileName() {
         return file_name_;
@@ -645,7 +686,7 @@ public:
                prev_lsn_ == obj.prev_lsn_ && 
                file_name_ == obj.file_name_ &&
                rid_ == obj.rid_ && 
-               record_size_ == obj.record_size_ && 
+               body_size_ == obj.body_size_ && 
                is_clr_ == obj.is_clr_ &&
                undo_next_ == obj.undo_next_  &&
                tuple_ == obj.tuple_;
@@ -663,7 +704,8 @@ private:
 
     Tuple tuple_;
 
-    int record_size_;
+    // the size of record except header
+    int body_size_;
 };
 
 
@@ -671,10 +713,29 @@ class UpdateRecord : public LogRecord {
 
 public:
 
+    /**
+    * @brief a changed byte range of tuple, gap is the count of 
+    * unchanged bytes between the last range and this range
+    */
+    struct Range {
+        int gap_;
+        std::vector<char> old_data_;
+        std::vector<char> new_data_;
+
+        bool operator ==(const Range &obj) const {
+            return gap_ == obj.gap_ && 
+                   old_data_ == obj.old_data_ && 
+                   new_data_ == obj.new_data_;
+        }
+    };
+
     UpdateRecord() = default;
     
     UpdateRecord(Page *p);
 
+    /**
+    * @brief only the bytes differ between old_tuple and new_tuple are kept
+    */
     UpdateRecord(txn_id_t txn, 
                  const std::string &file_name, 
                  const RID &rid,
@@ -682,13 +743,13 @@ public:
                  const Tuple &new_tuple);
     
     int RecordSize() override {
-        return record_size_;
+        return HeaderSize() + body_size_;
     }
 
 
     std::string ToString() override;
 
-    std::shared_ptr<std::vector<char>> Serializeto() override;
+    void WriteTo(char *buf) override;
 
 
     inline std::string GetFileName() {
@@ -699,13 +760,27 @@ public:
         return rid_;
     }
 
-    inline Tuple GetNewTuple() {
-        return new_tuple_;
-    }
+    /**
+    * @brief apply the changed ranges to old tuple, used by redo
+    * 
+    * @param old_tuple the tuple before updating
+    * @return the tuple after updating
+    */
+    Tuple GetNewTuple(const Tuple &old_tuple);
 
-    inline Tuple GetOldTuple() {
-        return old_tuple_;
-    }
+    /**
+    * @brief revert the changed ranges from new tuple, used by undo
+    * 
+    * @param new_tuple the tuple after updating
+    * @return the tuple before updating
+    */
+    Tuple GetOldTuple(const Tuple &new_tuple);
+
+    /**
+    * @brief build a record which updates the new tuple back to the old one, 
+    * it's used as the clr of this record. the header is not copied
+    */
+    std::shared_ptr<UpdateRecord> ReverseRecord(txn_id_t txn);
 
     // for debugging purpose
     bool operator ==(const UpdateRecord &obj) const {
@@ -714,11 +789,12 @@ public:
                prev_lsn_ == obj.prev_lsn_ && 
                file_name_ == obj.file_name_ &&
                rid_ == obj.rid_ && 
-               record_size_ == obj.record_size_ && 
+               body_size_ == obj.body_size_ && 
                is_clr_ == obj.is_clr_ &&
                undo_next_ == obj.undo_next_  &&
-               old_tuple_ == obj.old_tuple_ &&
-               new_tuple_ == obj.new_tuple_;
+               old_size_ == obj.old_size_ &&
+               new_size_ == obj.new_size_ &&
+               ranges_ == obj.ranges_;
     }
     
     bool operator !=(const UpdateRecord &obj) const {
@@ -727,15 +803,30 @@ public:
 
 private:
 
+    /**
+    * @brief calculate body_size_ by other fields
+    */
+    void CalcBodySize();
+
+    /**
+    * @brief copy the unchanged bytes from tuple and the changed bytes from ranges
+    * 
+    * @param redo whether to build new tuple from old tuple
+    */
+    Tuple ApplyRanges(const Tuple &tuple, bool redo);
+
     std::string file_name_;
 
     RID rid_;
 
-    Tuple old_tuple_;
+    int old_size_{0};
+
+    int new_size_{0};
 
-    Tuple new_tuple_;
+    std::vector<Range> ranges_;
 
-    int record_size_;
+    // the size of record except header
+    int body_size_{0};
 };
 
 class InitPageRecord : public LogRecord {
@@ -751,7 +842,7 @@ public:
                    int block_number);
     
     int RecordSize() override {
-        return record_size_;
+        return HeaderSize() + body_size_;
     }
 
     BlockId GetBlockID() {
@@ -761,7 +852,7 @@ public:
 
     std::string ToString() override;
 
-    std::shared_ptr<std::vector<char>> Serializeto() override;
+    void WriteTo(char *buf) override;
 
     // for debugging purpose
     bool operator ==(const InitPageRecord &obj) const {
@@ -769,7 +860,7 @@ public:
                txn_id_ == obj.txn_id_ && 
                prev_lsn_ == obj.prev_lsn_ && 
                file_name_ == obj.file_name_ &&
-               record_size_ == obj.record_size_ && 
+               body_size_ == obj.body_size_ && 
                is_clr_ == obj.is_clr_ &&
                undo_next_ == obj.undo_next_  &&
                block_number_ == obj.block_number_;
@@ -785,7 +876,8 @@ private:
 
     int block_number_;
 
-    int record_size_;
+    // the size of record except header
+    int body_size_;
 };
 
 
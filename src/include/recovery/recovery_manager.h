@@ -36,6 +36,8 @@ public:
     * now, we should flush 2 log_records when commit phase:
     * 1. flush commit log record
     * 2. txn-end log record written immediately after commit log record
+    * an async-commit txn doesn't wait for the flush, its commit log is 
+    * durable within the interval of log flush thread
     */
     void Commit(Transaction *txn);
 
@@ -88,8 +90,17 @@ public:
                          bool is_clr);
     
 
+    /**
+    * @brief WAL, make the log up to lsn durable before writing the block
+    */
     void FlushBlock(BlockId block, lsn_t lsn);
 
+    /**
+    * @brief the block has been written back, but the write may be not durable.
+    * its dirty page entry is kept until the next checkpoint syncs the files
+    */
+    void BlockCleaned(const BlockId &block);
+
 
     /**
     * @brief recover uncompleted transaction from the log
@@ -103,6 +114,20 @@ public:
     * 3. undo: undo any log record of uncommited transaction.
     */
     void Recover(Transaction *txn);
+
+    /**
+    * @brief the offset of the oldest log which recovery needs, that is
+    * the earliest lsn of dirty pages and the begin of active transactions
+    * @param chkpt_offset the offset of the lastest checkpoint
+    * @param tx_table the txn table written to the checkpoint
+    * @param dp_table the dirty page table written to the checkpoint
+    * @param begin_lsn the begin lsn of txns when the checkpoint is taken
+    * @return -1 if some of them is unknown
+    */
+    log_offset_t GetOldestNeededOffset(log_offset_t chkpt_offset, 
+                                       const std::map<txn_id_t, TxTableEntry> &tx_table,
+                                       const std::map<BlockId, lsn_t> &dp_table,
+                                       const std::map<txn_id_t, lsn_t> &begin_lsn);
     
 
 
@@ -195,6 +220,12 @@ private:
         if (dp_table_.find(block) == dp_table_.end()) {
             dp_table_[block] = lsn;
         }
+
+        // the block is dirty again after it was cleaned
+        auto iter = cleaned_blocks_.find(block);
+        if (iter != cleaned_blocks_.end() && iter->second == INVALID_LSN) {
+            iter->second = lsn;
+        }
     }
 
     inline void RemoveEarlistLsn(const BlockId &block) {
@@ -205,7 +236,7 @@ private:
 
 // these three functions are for manipulation lsn_map_    
 
-    inline void InsertLsnMap(lsn_t lsn, int offset) {
+    inline void InsertLsnMap(lsn_t lsn, log_offset_t offset) {
         std::lock_guard<std::mutex> latch(latch_);
         lsn_map_[lsn] = offset;
     }
@@ -215,7 +246,7 @@ private:
         lsn_map_.erase(lsn);
     }
 
-    inline int GetLsnMap(lsn_t lsn) {
+    inline log_offset_t GetLsnMap(lsn_t lsn) {
         std::lock_guard<std::mutex> latch(latch_);
         SIMPLEDB_ASSERT(lsn_map_.find(lsn) != lsn_map_.end(),
                         "log not exist");
@@ -239,9 +270,20 @@ private:
     // map lsn ---> (block_number, offset)
     // during the rollback, it just store the logs of one transaction
     // And during recovery, it store huge logs 
-    std::unordered_map<lsn_t, int> lsn_map_;
+    std::unordered_map<lsn_t, log_offset_t> lsn_map_;
+
+    // map txn_id --> the lsn of its begin log, only for the 
+    // transactions which begin after starting
+    std::map<txn_id_t, lsn_t> begin_lsn_;
+
+    // the blocks written back by background writer since last checkpoint
+    // map block --> the first lsn which dirties it again after writing
+    std::map<BlockId, lsn_t> cleaned_blocks_;
 
     std::mutex latch_;
+
+    // serialize checkpoints
+    std::mutex chkpt_latch_;
 };
 
 } // namespace SimpleDB
@@ -10,14 +10,14 @@ namespace SimpleDB {
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_ITERATOR_TYPE::BPlusTreeIterator
 (int curr_slot, int curr_block_num, 
-Buffer *buffer, BPlusTree<KeyType, ValueType, KeyComparator> *btree) 
+ReadPageGuard &&guard, BPlusTree<KeyType, ValueType, KeyComparator> *btree) 
     : curr_slot_(curr_slot), curr_block_num_(curr_block_num), 
-      buffer_(buffer), btree_(btree) {
+      guard_(std::move(guard)), btree_(btree) {
     
     // assume that we have received r-latch when begin function in btree
     if (!IsEnd()) {
         index_file_name_ = btree_->index_file_name_;
-        leaf_page_ = reinterpret_cast<LeafPage*>(buffer_->contents()->GetRawDataPtr());
+        leaf_page_ = guard_.DataAs<LeafPage>();
         buffer_manager_ = btree_->buffer_manager_;
         Get();
     }
@@ -25,15 +25,6 @@ Buffer *buffer, BPlusTree<KeyType, ValueType, KeyComparator> *btree)
 }
 
 
-INDEX_TEMPLATE_ARGUMENTS
-BPLUSTREE_ITERATOR_TYPE::~BPlusTreeIterator() {
-    if (!IsEnd()) {
-        buffer_->RUnlock();
-        buffer_manager_->UnpinBlock({index_file_name_, curr_block_num_}, false);
-    }
-}
-
-
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_ITERATOR_TYPE::IsEnd() {
     return curr_block_num_ == INVALID_BLOCK_NUM;
@@ -77,14 +68,11 @@ void BPLUSTREE_ITERATOR_TYPE::Advance()  {
     // otherwise, move to the next block
     if (leaf_page_->GetNextBlockNum() != INVALID_BLOCK_NUM) {
         int next_block_num = leaf_page_->GetNextBlockNum();
-        buffer_->RUnlock();
-        buffer_manager_->UnpinBlock({index_file_name_, curr_block_num_}, false);
+        guard_.Drop();
         
-        
-        // create new buffer and net leaf page
-        buffer_ = buffer_manager_->PinBlock({index_file_name_, next_block_num});
-        leaf_page_ = reinterpret_cast<LeafPage*>(buffer_->contents()->GetRawDataPtr());
-        buffer_->RLock();
+        // pin and r-latch the next leaf page
+        guard_ = buffer_manager_->PinBlockRead({index_file_name_, next_block_num});
+        leaf_page_ = guard_.DataAs<LeafPage>();
         curr_slot_ = 0;
         curr_block_num_ = next_block_num;
         
@@ -92,8 +80,8 @@ void BPLUSTREE_ITERATOR_TYPE::Advance()  {
     }
     else {
         int next_block_num = leaf_page_->GetNextBlockNum();
-        buffer_->RUnlock();
-        buffer_manager_->UnpinBlock({index_file_name_, curr_block_num_}, false);
+        guard_.Drop();
+        leaf_page_ = nullptr;
         curr_slot_ = -1;
         curr_block_num_ = next_block_num;
     }
@@ -112,19 +100,12 @@ bool BPLUSTREE_ITERATOR_TYPE::GetValue(std::vector<RID> *result)  {
     // exist a bucket chain, read data from this chain
     int bucket_num = item_.second.GetBlockNum();
     while (bucket_num != INVALID_BLOCK_NUM) {
-        Buffer *bucket_buffer = buffer_manager_->PinBlock({index_file_name_, bucket_num});
-        auto bucket_page = reinterpret_cast<BucketPage*>(bucket_buffer->contents()->GetRawDataPtr());
-        int next_bucket_num = INVALID_BLOCK_NUM;
+        auto bucket_guard = buffer_manager_->PinBlockRead({index_file_name_, bucket_num});
+        auto bucket_page = bucket_guard.DataAs<BucketPage>();
 
-        // read data
-        bucket_buffer->RLock();
+        // read data, the guard unpins it before moving to the next bucket
         bucket_page->GetValue(result);
-        next_bucket_num = bucket_page->GetNextBucketNum();
-        bucket_buffer->RUnlock();
-
-        // unpin and move to the next bucket
-        buffer_manager_->UnpinBlock({index_file_name_, bucket_num}, false);
-        bucket_num = next_bucket_num;
+        bucket_num = bucket_page->GetNextBucketNum();
     }
 
     return true;
@@ -37,15 +37,15 @@ BPLUSTREE_TYPE::BPlusTree(const std::string &index_file_name,
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::StartNewTree() {
     int new_block_num;
-    Buffer *new_page = buffer_manager_->NewBlock(index_file_name_, &new_block_num);
+    auto new_guard = buffer_manager_->NewBlockGuarded(index_file_name_, &new_block_num);
 
     // create a new leaf page to act as root
-    auto *leafPage = reinterpret_cast<LeafPage*>(new_page->contents()->GetRawDataPtr());
+    auto *leafPage = new_guard.DataAs<LeafPage>();
     leafPage->Init(new_block_num, max_leaf_size_);
     UpdateRootBlockNum(new_block_num);
 
-    // unpin to ensure persistent storage
-    buffer_manager_->UnpinBlock({index_file_name_, new_block_num}, true);
+    // unpin as dirty to ensure persistent storage
+    new_guard.SetDirty();
 }
 
 
@@ -61,18 +61,25 @@ void BPLUSTREE_TYPE::UpdateRootBlockNum(int new_block_num) {
 // ----------------------------------------------
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result) const {
+    // most reads don't conflict with writers, try it without latches first
+    for (int i = 0;i < OPTIMISTIC_READ_RETRY;i ++) {
+        bool found = false;
+        if (OptimisticGetValue(key, result, &found)) {
+            return found;
+        }
+    }
+
     root_latch_.RLock();
     
     // concurrency relative
-    BPlusTreeContext context(buffer_manager_);
+    BPlusTreeContext context;
     bool is_root_locked = true;
 
 
-    // create the leaf page, why we don't acquire reader lock here?
-    // since we're already locked inside the searchleaf
-    auto leaf_block_num = SearchLeaf(key, &context, BPlusTreeOpearion::QUERY, &is_root_locked);
-    auto *buffer = buffer_manager_->PinBlock({index_file_name_, leaf_block_num});
-    auto *leaf_page = reinterpret_cast<LeafPage*>(buffer->contents()->GetRawDataPtr());
+    // the leaf page has been pinned and latched by searchleaf,
+    // it's the last page of context
+    SearchLeaf(key, &context, BPlusTreeOpearion::QUERY, &is_root_locked);
+    auto *leaf_page = reinterpret_cast<LeafPage*>(context.Back()->contents()->GetRawDataPtr());
     
 
     // try to access this leaf page
@@ -95,8 +102,7 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
     }
 
 
-    buffer_manager_->UnpinBlock({index_file_name_, leaf_block_num}, false);
-    context.ClearPageSet(true);
+    context.ClearPageSet();
     if (is_root_locked) {
         root_latch_.RUnlock();
     }
@@ -107,6 +113,90 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
 
 
 
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::OptimisticGetValue(const KeyType &key, 
+                                        std::vector<ValueType> *result,
+                                        bool *found) const {
+    uint64_t root_version;
+    if (!root_latch_.TryOptimisticRead(&root_version)) {
+        return false;
+    }
+
+    auto curr_guard = buffer_manager_->PinBlockGuarded({index_file_name_, root_block_num_});
+    Buffer *curr_buffer = curr_guard.GetBuffer();
+    uint64_t curr_version;
+
+    // root_block_num_ may be changed by a split or a merge of root,
+    // the root page is valid only if root latch is not acquired by writer
+    if (!curr_buffer->TryOptimisticRead(&curr_version) || 
+        !root_latch_.Validate(root_version)) {
+        return false;
+    }
+
+
+    // optimistic lock coupling, the child is trustworthy only if 
+    // the parent is unchanged after we get the version of child
+    while (true) {
+        auto *curr_page = reinterpret_cast<BPlusTreePage*>
+                          (curr_buffer->contents()->GetRawDataPtr());
+        
+        // the page might be modified during reading, check the 
+        // header before using it so that we never access out of page
+        PageType page_type = curr_page->GetPageType();
+        int size = curr_page->GetSize();
+        bool sane = (page_type == PageType::BPLUS_TREE_LEAF_PAGE && 
+                     size >= 0 && size <= max_leaf_size_) ||
+                    (page_type == PageType::BPLUS_TREE_DIRECTORY_PAGE && 
+                     size >= 1 && size <= max_dir_size_);
+        if (!sane) {
+            return false;
+        }
+
+        if (page_type == PageType::BPLUS_TREE_LEAF_PAGE) {
+            break;
+        }
+
+        auto *dir_page = reinterpret_cast<DirectoryPage*>(curr_page);
+        int child_block_num = dir_page->Lookup(key, comparator_);
+        if (!curr_buffer->Validate(curr_version)) {
+            return false;
+        }
+
+        auto child_guard = buffer_manager_->PinBlockGuarded({index_file_name_, child_block_num});
+        uint64_t child_version;
+        bool valid = child_guard.GetBuffer()->TryOptimisticRead(&child_version) &&
+                     curr_buffer->Validate(curr_version);
+        if (!valid) {
+            return false;
+        }
+
+        // the parent is unpinned here
+        curr_guard = std::move(child_guard);
+        curr_buffer = curr_guard.GetBuffer();
+        curr_version = child_version;
+    }
+
+
+    auto *leaf_page = reinterpret_cast<LeafPage*>(curr_buffer->contents()->GetRawDataPtr());
+    ValueType tmp_value;
+    bool res = leaf_page->Lookup(key, &tmp_value, comparator_);
+    bool valid = curr_buffer->Validate(curr_version);
+    curr_guard.Drop();
+
+    // bucket chain is not versioned, read it with latches
+    if (!valid || (res && tmp_value.GetSlot() == -1)) {
+        return false;
+    }
+
+    if (res) {
+        result->emplace_back(tmp_value);
+    }
+    *found = res;
+    return true;
+}
+
+
+
 INDEX_TEMPLATE_ARGUMENTS
 int BPLUSTREE_TYPE::SearchLeaf(const KeyType &search_key, 
                                                     BPlusTreeContext *context, 
@@ -114,13 +204,10 @@ int BPLUSTREE_TYPE::SearchLeaf(const KeyType &search_key,
                                                     bool *root_is_locked) const {
     // in searchleaf function, due to the crab protocol, we also need to acquire 
     // x-lock and may grant it until finish operation.
-    Buffer *curr_buffer = buffer_manager_->PinBlock({index_file_name_, root_block_num_});
-    BPlusTreePage *curr_page = reinterpret_cast<BPlusTreePage*>(curr_buffer->contents()->GetRawDataPtr()); 
     int curr_block_num = root_block_num_;
 
     // lock and add it to pageset
-    AcquireLock(curr_buffer, operation);
-    context->AddToPageSet(curr_buffer);
+    BPlusTreePage *curr_page = LatchToPageSet(curr_block_num, context, operation);
 
     
     // search for a leaf page 
@@ -133,52 +220,30 @@ int BPLUSTREE_TYPE::SearchLeaf(const KeyType &search_key,
         
         // get child_page to check if we need grant the lock of curr_page
         // we need acquire lock before check if parent safe
-        // but not add it to pageset immediately
-        Buffer *child_buffer = buffer_manager_->PinBlock({index_file_name_, child_block_num});
-        auto child_page = reinterpret_cast<BPlusTreePage*>(child_buffer->contents()->GetRawDataPtr());
-        AcquireLock(child_buffer, operation);
+        auto child_page = LatchToPageSet(child_block_num, context, operation);
 
 
         // if parent(curr_page) is safe, unpin and unlock 
         // otherwise, grant wlock until opeartion finish.
-        if (IsParentSafe(child_page, operation)) {
-            for (auto &t:context->GetPageSet()) {
-                if (operation == BPlusTreeOpearion::QUERY) {
-                    t->RUnlock();
-                }
-                else {
-                    t->WUnlock();
-                }
-
-                auto &block_id = t->GetBlockID();
-                int block_num = block_id.BlockNum();
-                buffer_manager_->UnpinBlock(block_id, false); 
-
-                if (block_num == root_block_num_) {
-                    if (operation == BPlusTreeOpearion::QUERY) {
-                        root_latch_.RUnlock();
-                    }
-                    else {
-                        root_latch_.WUnlock();
-                    }
-                    *root_is_locked = false;
-                }
+        if (IsParentSafe(child_page, operation) && 
+            context->ReleaseAncestors(root_block_num_)) {
+            if (operation == BPlusTreeOpearion::QUERY) {
+                root_latch_.RUnlock();
             }
-
-            context->ClearPageSetNotUnpin();
+            else {
+                root_latch_.WUnlock();
+            }
+            *root_is_locked = false;
         }
 
 
-        // i don't unpin old curr_buff here since i want to store it in context
-        // step to next page, add child_buffer to page set
-        context->AddToPageSet(child_buffer);
-        curr_buffer = child_buffer;
+        // step to next page, the child is the last page of page set
         curr_page = child_page;
         curr_block_num = child_block_num;
     }
 
 
-    // we only return block num and store curr_buffer in context
+    // we only return block num and store the leaf in context
     return curr_block_num;
 }
 
@@ -221,14 +286,14 @@ void BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value) {
 
     // concurrency relative
     root_latch_.WLock();
-    BPlusTreeContext context(buffer_manager_);
+    BPlusTreeContext context;
     bool is_root_locked = true;
 
 
     // create the leaf page, we have received x-lock in searchleaf
     auto leaf_block_num = SearchLeaf(key, &context, BPlusTreeOpearion::INSERT, &is_root_locked);
-    auto *buffer = buffer_manager_->PinBlock({index_file_name_, leaf_block_num});
-    auto *leaf_page = reinterpret_cast<LeafPage*>(buffer->contents()->GetRawDataPtr());
+    auto *leaf_page = reinterpret_cast<LeafPage*>(context.Back()->contents()->GetRawDataPtr());
+    context.SetBackDirty();
     
 
     // try to read data from leaf page and check if has this value
@@ -249,16 +314,14 @@ void BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value) {
 
         // there is a rid, create a bucket chain 
         if (tmp_value.GetSlot() != -1) {
-            int new_block_num;
-            BucketPage* bucket = CreateBTreePage<BucketPage>
-                                 (PageType::BPLUS_TREE_BUCKET_PAGE, &new_block_num);
-            if (bucket->GetBlockNum() != new_block_num) {
-                assert(false);
-            }
+            BasicPageGuard bucket_guard = CreateBTreePage(PageType::BPLUS_TREE_BUCKET_PAGE);
+            auto *bucket = bucket_guard.DataAs<BucketPage>();
+            int new_block_num = bucket_guard.GetBlockNum();
 
             // insert into it
-            assert(bucket->Insert(tmp_value));
-            assert(bucket->Insert(value)); 
+            [[maybe_unused]] bool res = bucket->Insert(tmp_value);
+            res &= bucket->Insert(value);
+            SIMPLEDB_ASSERT(res, "a new bucket should have space");
 
 
             // modify value at piar_index
@@ -266,8 +329,7 @@ void BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value) {
             leaf_page->SetValueAt(key_index, RID(new_block_num, -1));
 
             
-            // release resource
-            buffer_manager_->UnpinBlock({index_file_name_, new_block_num}, true);
+            // the bucket is unpinned by its guard
         }
 
         // there is a bucket num, try to insert into it.
@@ -278,11 +340,10 @@ void BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value) {
 
 
         // release w-latch and buffer
-        context.ClearPageSet(false);
+        context.ClearPageSet();
         if (is_root_locked) {
             root_latch_.WUnlock();
         }
-        buffer_manager_->UnpinBlock({index_file_name_, leaf_block_num}, true);
         return;
     }
 
@@ -294,8 +355,9 @@ void BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value) {
     //    (2) the page is full, split and insert an entry into parent
     if (leaf_page->GetSize() == leaf_page->GetMaxSize()) {
         // Split and maintain a leaf linked list 
-        LeafPage *new_leaf_page= Split<LeafPage>(leaf_page);
-        int new_leaf_block_num = new_leaf_page->GetBlockNum();
+        BasicPageGuard new_leaf_guard = Split<LeafPage>(leaf_page);
+        auto *new_leaf_page = new_leaf_guard.DataAs<LeafPage>();
+        int new_leaf_block_num = new_leaf_guard.GetBlockNum();
         new_leaf_page->SetNextBlockNum(leaf_page->GetNextBlockNum());
         leaf_page->SetNextBlockNum(new_leaf_block_num);
 
@@ -306,7 +368,7 @@ void BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value) {
 
 
         // release new leaf, should we need to acquire w-lock of sibling node?
-        assert(buffer_manager_->UnpinBlock({index_file_name_, new_leaf_block_num}, true));
+        new_leaf_guard.Drop();
         
         // insert into parent directory
         InsertIntoParent(leaf_page_parent_block_num, middle_key,
@@ -315,36 +377,34 @@ void BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value) {
     
 
     // release w-latch and buffer
-    context.ClearPageSet(false);
+    context.ClearPageSet();
     if (is_root_locked) {
         root_latch_.WUnlock();
     }
-    buffer_manager_->UnpinBlock({index_file_name_, leaf_block_num}, true);
 }
 
 
 INDEX_TEMPLATE_ARGUMENTS
 template<class N>
-N* BPLUSTREE_TYPE::Split(N* old_page) {
-    int new_block_num;
+BasicPageGuard BPLUSTREE_TYPE::Split(N* old_page) {
 
     // handle leaf page
     if (old_page->GetPageType() == PageType::BPLUS_TREE_LEAF_PAGE) {
-        LeafPage *new_leaf_page = CreateBTreePage<LeafPage>
-                                  (PageType::BPLUS_TREE_LEAF_PAGE, &new_block_num);
+        BasicPageGuard new_guard = CreateBTreePage(PageType::BPLUS_TREE_LEAF_PAGE);
+        auto *new_leaf_page = new_guard.DataAs<LeafPage>();
         new_leaf_page->SetParentBlockNum(old_page->GetParentBlockNum());
     
         reinterpret_cast<LeafPage *>(old_page)->MoveHalfTo(new_leaf_page);
-        return reinterpret_cast<N*>(new_leaf_page);
+        return new_guard;
     }
 
 
-    DirectoryPage *new_dir_page = CreateBTreePage<DirectoryPage>
-                                  (PageType::BPLUS_TREE_DIRECTORY_PAGE, &new_block_num);
+    BasicPageGuard new_guard = CreateBTreePage(PageType::BPLUS_TREE_DIRECTORY_PAGE);
+    auto *new_dir_page = new_guard.DataAs<DirectoryPage>();
     new_dir_page->SetParentBlockNum(old_page->GetParentBlockNum());
     
     reinterpret_cast<DirectoryPage*>(old_page)->MoveHalfTo(new_dir_page);
-    return reinterpret_cast<N*>(new_dir_page);
+    return new_guard;
 }
 
 
@@ -357,26 +417,25 @@ void BPLUSTREE_TYPE::InsertIntoParent(int dir_block_num, const KeyType &key,
     
     // if left child is the root_page, we should create a new root_page to replace it 
     if (dir_block_num == INVALID_BLOCK_NUM) {
-        int new_root_block_num;
-        DirectoryPage *parent_dir_page = CreateBTreePage<DirectoryPage>
-                                         (PageType::BPLUS_TREE_DIRECTORY_PAGE, &new_root_block_num);
+        BasicPageGuard root_guard = CreateBTreePage(PageType::BPLUS_TREE_DIRECTORY_PAGE);
+        auto *parent_dir_page = root_guard.DataAs<DirectoryPage>();
         // std::cout << "new root "<<std::endl;
         
         // init new root of btree
-        UpdateRootBlockNum(new_root_block_num);
+        UpdateRootBlockNum(root_guard.GetBlockNum());
         parent_dir_page->PopulateNewRoot(left_block_num, key, right_block_num);
     
         // redistributed parent block of child
         ResetDirChildParent(parent_dir_page);
-        buffer_manager_->UnpinBlock({index_file_name_, new_root_block_num}, true);
         return;
     }
     
 
     // get parent block, Since this block already exists in the pageset, 
     // the pin again will not need disk IO , curr_pin_count: 1->2
-    Buffer *dir_buffer = buffer_manager_->PinBlock({index_file_name_, dir_block_num});
-    auto dir_page = reinterpret_cast<DirectoryPage*>(dir_buffer->contents()->GetRawDataPtr());
+    auto dir_guard = buffer_manager_->PinBlockGuarded({index_file_name_, dir_block_num});
+    auto *dir_page = dir_guard.DataAs<DirectoryPage>();
+    dir_guard.SetDirty();
 
 
     // insert into directory page
@@ -387,22 +446,18 @@ void BPLUSTREE_TYPE::InsertIntoParent(int dir_block_num, const KeyType &key,
     // it reaches maxsize, it needs to be checked before insertion
     if (dir_page->GetSize() > dir_page->GetMaxSize()) {
         assert(dir_page->GetSize() == dir_page->GetMaxSize() + 1);
-        DirectoryPage *sibling_dir_page = Split<DirectoryPage>(dir_page);
-        int sibling_dir_block_num = sibling_dir_page->GetBlockNum();
+        BasicPageGuard sibling_guard = Split<DirectoryPage>(dir_page);
+        auto *sibling_dir_page = sibling_guard.DataAs<DirectoryPage>();
+        int sibling_dir_block_num = sibling_guard.GetBlockNum();
         KeyType middle_key = sibling_dir_page->KeyAt(0);
         
 
         InsertIntoParent(dir_page->GetParentBlockNum(), middle_key, 
                          dir_block_num, sibling_dir_block_num, context);
         ResetDirChildParent(sibling_dir_page);
-
-
-        // only unpin sibling buffer
-        buffer_manager_->UnpinBlock({index_file_name_, sibling_dir_block_num}, true);
     }
     
-    // unpin dir_page here, curr_pin_count: 2->1
-    buffer_manager_->UnpinBlock({index_file_name_, dir_block_num}, true);
+    // the guards unpin sibling and dir_page here, curr_pin_count: 2->1
 }
 
 
@@ -418,14 +473,13 @@ bool BPLUSTREE_TYPE::Remove(const KeyType &key, const ValueType &value) {
 
     // concurrency relative
     root_latch_.WLock();
-    BPlusTreeContext context(buffer_manager_);
+    BPlusTreeContext context;
     bool root_is_locked = true;
 
     
     // create the leaf page
     auto leaf_block_num = SearchLeaf(key, &context, BPlusTreeOpearion::REMOVE, &root_is_locked);
-    auto *buffer = buffer_manager_->PinBlock({index_file_name_, leaf_block_num});
-    auto *leaf_page = reinterpret_cast<LeafPage*>(buffer->contents()->GetRawDataPtr());
+    auto *leaf_page = reinterpret_cast<LeafPage*>(context.Back()->contents()->GetRawDataPtr());
 
     
     // try to remove it
@@ -440,8 +494,7 @@ bool BPLUSTREE_TYPE::Remove(const KeyType &key, const ValueType &value) {
 
         // this pair is not exist in tree
         if (!is_exist) {
-            buffer_manager_->UnpinBlock({index_file_name_, leaf_block_num}, false);
-            context.ClearPageSet(false);
+            context.ClearPageSet();
             if (root_is_locked) {
                 root_latch_.WUnlock();
             }
@@ -476,8 +529,8 @@ bool BPLUSTREE_TYPE::Remove(const KeyType &key, const ValueType &value) {
 
 
         // release resource
-        buffer_manager_->UnpinBlock({index_file_name_, leaf_block_num}, true);
-        context.ClearPageSet(false);
+        context.SetBackDirty();
+        context.ClearPageSet();
         if (root_is_locked) {
             root_latch_.WUnlock();
         }
@@ -486,6 +539,7 @@ bool BPLUSTREE_TYPE::Remove(const KeyType &key, const ValueType &value) {
 
 
     // remove is successful, check if need to merge or borrow a key
+    context.SetBackDirty();
     int min_num = leaf_block_num == root_block_num_ ? 0 : leaf_page->GetMinSize();
     int leaf_page_size = leaf_page->GetSize();
 
@@ -548,8 +602,7 @@ bool BPLUSTREE_TYPE::Remove(const KeyType &key, const ValueType &value) {
     }
 
 
-    buffer_manager_->UnpinBlock({index_file_name_, leaf_block_num}, true);
-    context.ClearPageSet(false);
+    context.ClearPageSet();
     if (root_is_locked) {
         root_latch_.WUnlock();
     }
@@ -561,9 +614,9 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::RemoveFromParent(int block_num, 
                                       int be_removed_child, BPlusTreeContext *context) {
     // get parent_dir_page
-    Buffer *dir_buffer = buffer_manager_->PinBlock({index_file_name_, block_num});
-    DirectoryPage *dir_page = reinterpret_cast<DirectoryPage*>
-                              (dir_buffer->contents()->GetRawDataPtr());
+    auto dir_guard = buffer_manager_->PinBlockGuarded({index_file_name_, block_num});
+    auto *dir_page = dir_guard.DataAs<DirectoryPage>();
+    dir_guard.SetDirty();
 
 
     // remove this child
@@ -587,9 +640,6 @@ void BPLUSTREE_TYPE::RemoveFromParent(int block_num,
     if (block_num == root_block_num_ && curr_size < min_num) {
         root_block_num_ = old_first_child_num;
         DeleteBTreePage(dir_page);
-
-        // remeber unpin !!
-        buffer_manager_->UnpinBlock({index_file_name_, block_num}, true);
         return;
     }
 
@@ -644,9 +694,6 @@ void BPLUSTREE_TYPE::RemoveFromParent(int block_num,
             RemoveFromParent(parent_block_num, be_removed_value, context);
         }
     }
-
-
-    buffer_manager_->UnpinBlock({index_file_name_, block_num}, true);
 }
 
 
@@ -663,9 +710,8 @@ bool BPLUSTREE_TYPE::BorrowLeafKey(bool from_right,
     assert(sibling_block_num != INVALID_BLOCK_NUM);
 
     // get sibling_leaf_page, curr_pin_count: 1->2
-    Buffer *sibling_buffer = buffer_manager_->PinBlock({index_file_name_, sibling_block_num});
-    LeafPage *lender = reinterpret_cast<LeafPage*>
-                            (sibling_buffer->contents()->GetRawDataPtr());
+    auto sibling_guard = buffer_manager_->PinBlockGuarded({index_file_name_, sibling_block_num});
+    auto *lender = sibling_guard.DataAs<LeafPage>();
 
 
     // check if we can borrow key from this page
@@ -705,11 +751,10 @@ bool BPLUSTREE_TYPE::BorrowLeafKey(bool from_right,
             UpdateChildKeyInParent(parent_block_num, borrower_block_num, new_key, context);
         }
 
-        buffer_manager_->UnpinBlock({index_file_name_, sibling_block_num}, true);
+        sibling_guard.SetDirty();
         return true;
     }
 
-    buffer_manager_->UnpinBlock({index_file_name_, sibling_block_num}, false);
     return false;
 }
 
@@ -721,9 +766,8 @@ bool BPLUSTREE_TYPE::BorrowDirKey(bool from_right,
                                   BPlusTreeContext *context) {
     
     // get sibling_dir_page
-    Buffer *sibling_buffer = buffer_manager_->PinBlock({index_file_name_, sibling_block_num});
-    DirectoryPage *lender = reinterpret_cast<DirectoryPage*>
-                            (sibling_buffer->contents()->GetRawDataPtr());
+    auto sibling_guard = buffer_manager_->PinBlockGuarded({index_file_name_, sibling_block_num});
+    auto *lender = sibling_guard.DataAs<DirectoryPage>();
 
 
     // check if we can borrow key from this page
@@ -769,11 +813,10 @@ bool BPLUSTREE_TYPE::BorrowDirKey(bool from_right,
             ResetDirChildParentOne(borrower, new_child_block_num);
         }
 
-        buffer_manager_->UnpinBlock({index_file_name_, sibling_block_num}, true);
+        sibling_guard.SetDirty();
         return true;
     }
 
-    buffer_manager_->UnpinBlock({index_file_name_, sibling_block_num}, false);
     return false;
 }
 
@@ -790,9 +833,9 @@ void BPLUSTREE_TYPE::MergeLeafs(LeafPage *curr_leaf,
     
     // Get the sibling node
     // since we have get write latch in borrowkeys, don't need to acquire w-latch again.
-    Buffer *sibling_buffer = buffer_manager_->PinBlock({index_file_name_, sibling_block_num});
-    LeafPage *sibling_leaf = reinterpret_cast<LeafPage*>
-                             (sibling_buffer->contents()->GetRawDataPtr());
+    auto sibling_guard = buffer_manager_->PinBlockGuarded({index_file_name_, sibling_block_num});
+    auto *sibling_leaf = sibling_guard.DataAs<LeafPage>();
+    sibling_guard.SetDirty();
 
 
     if (with_right) { 
@@ -805,9 +848,6 @@ void BPLUSTREE_TYPE::MergeLeafs(LeafPage *curr_leaf,
         curr_leaf->MoveAllTo(sibling_leaf);
         DeleteBTreePage(curr_leaf);
     }
-    
-
-    buffer_manager_->UnpinBlock({index_file_name_, sibling_block_num}, true);
 }
 
 
@@ -818,9 +858,9 @@ void BPLUSTREE_TYPE::MergeKeys(DirectoryPage *curr_dir,
                                BPlusTreeContext *context) {
     
     // Get the sibling node
-    Buffer *sibling_buffer = buffer_manager_->PinBlock({index_file_name_, sibling_block_num});
-    DirectoryPage *sibling_dir = reinterpret_cast<DirectoryPage*>
-                                 (sibling_buffer->contents()->GetRawDataPtr());
+    auto sibling_guard = buffer_manager_->PinBlockGuarded({index_file_name_, sibling_block_num});
+    auto *sibling_dir = sibling_guard.DataAs<DirectoryPage>();
+    sibling_guard.SetDirty();
 
 
     if (with_right) { 
@@ -835,8 +875,6 @@ void BPLUSTREE_TYPE::MergeKeys(DirectoryPage *curr_dir,
         ResetDirChildParent(sibling_dir);
         DeleteBTreePage(curr_dir);
     }
-    
-    buffer_manager_->UnpinBlock({index_file_name_, sibling_block_num}, true);
 }
 
 
@@ -851,12 +889,11 @@ void BPLUSTREE_TYPE::UpdateChildKeyInParent(int parent_block_num,
 #endif
 
     // get a parent buffer again
-    Buffer *parent_buffer = buffer_manager_->PinBlock({index_file_name_, parent_block_num});
+    auto parent_guard = buffer_manager_->PinBlockGuarded({index_file_name_, parent_block_num});
 
 
     // create a parent page according to parent buffer.
-    DirectoryPage *parent_page = reinterpret_cast<DirectoryPage*>
-                  (parent_buffer->contents()->GetRawDataPtr());
+    auto *parent_page = parent_guard.DataAs<DirectoryPage>();
 
     // get the index of old_key
     int value_index = parent_page->ValueIndex(child_block_num);
@@ -872,8 +909,8 @@ void BPLUSTREE_TYPE::UpdateChildKeyInParent(int parent_block_num,
     parent_page->SetKeyAt(value_index, new_key);
 
 
-    // we need unpin parent here, curr_pin_count: 2->1
-    buffer_manager_->UnpinBlock({index_file_name_, parent_block_num}, true);
+    // the guard unpins parent here, curr_pin_count: 2->1
+    parent_guard.SetDirty();
 }
 
 
@@ -881,13 +918,12 @@ INDEX_TEMPLATE_ARGUMENTS
 std::tuple<int, int> BPLUSTREE_TYPE::GetBrotherNodeBlockNum(int parent_block_num, 
                                                             int child_block_num, 
                                                             BPlusTreeContext *context) {
-    // pin this parent again
-    Buffer *parent_buffer = buffer_manager_->PinBlock({index_file_name_, parent_block_num});
+    // pin this parent again, it has been latched by us
+    auto parent_guard = buffer_manager_->PinBlockGuarded({index_file_name_, parent_block_num});
 
 
     // create a parent directory page
-    DirectoryPage *parent_page = reinterpret_cast<DirectoryPage*>
-                                (parent_buffer->contents()->GetRawDataPtr());
+    auto *parent_page = parent_guard.DataAs<DirectoryPage>();
     int left_page_block_num = -1, right_page_block_num = -1;
 
 
@@ -900,19 +936,14 @@ std::tuple<int, int> BPLUSTREE_TYPE::GetBrotherNodeBlockNum(int parent_block_num
     // get brother page block num and add it to pageset
     if (!is_the_first_child) {
         left_page_block_num = parent_page->ValueAt(index - 1);
-        auto *left_buffer = buffer_manager_->PinBlock({index_file_name_, left_page_block_num});
-        left_buffer->WLock();
-        context->AddToPageSet(left_buffer);
+        context->AddToPageSet(buffer_manager_->PinBlockWrite({index_file_name_, left_page_block_num}));
     }
     if (!is_the_last_child) {
         right_page_block_num = parent_page->ValueAt(index + 1);
-        auto *right_buffer = buffer_manager_->PinBlock({index_file_name_, right_page_block_num});
-        right_buffer->WLock();
-        context->AddToPageSet(right_buffer);
+        context->AddToPageSet(buffer_manager_->PinBlockWrite({index_file_name_, right_page_block_num}));
     }
 
     
-    buffer_manager_->UnpinBlock({index_file_name_, parent_block_num}, false);
     return std::make_tuple(left_page_block_num, right_page_block_num);
 }
 
@@ -929,19 +960,14 @@ void BPLUSTREE_TYPE::ReadFromBucketChain(int first_bucket_num,
     while (next_bucket_num != INVALID_BLOCK_NUM) {
         
         // create bucket
-        auto *curr_page = buffer_manager_->PinBlock({index_file_name_, next_bucket_num});
-        auto *bucket = reinterpret_cast<BucketPage*>(curr_page->contents()->GetRawDataPtr());
+        auto bucket_guard = buffer_manager_->PinBlockGuarded({index_file_name_, next_bucket_num});
+        auto *bucket = bucket_guard.DataAs<BucketPage>();
         assert(bucket->GetPageType() == PageType::BPLUS_TREE_BUCKET_PAGE);
 
         
-        // read data
+        // read data, the guard releases the bucket
         bucket->GetValue(result);
-        int old_bucket_num = next_bucket_num;
         next_bucket_num = bucket->GetNextBucketNum();
-        
-
-        // release resource
-        buffer_manager_->UnpinBlock({index_file_name_, old_bucket_num}, false);
     }
     
 }
@@ -958,8 +984,8 @@ void BPLUSTREE_TYPE::InsertIntoBucketChain(int first_bucket_num, const ValueType
     while (next_bucket_num != INVALID_BLOCK_NUM) {
         
         // create bucket
-        auto *curr_page = buffer_manager_->PinBlock({index_file_name_, next_bucket_num});
-        auto *bucket = reinterpret_cast<BucketPage*>(curr_page->contents()->GetRawDataPtr());
+        auto bucket_guard = buffer_manager_->PinBlockGuarded({index_file_name_, next_bucket_num});
+        auto *bucket = bucket_guard.DataAs<BucketPage>();
         assert(bucket->GetPageType() == PageType::BPLUS_TREE_BUCKET_PAGE);
 
 
@@ -970,9 +996,8 @@ void BPLUSTREE_TYPE::InsertIntoBucketChain(int first_bucket_num, const ValueType
 
 
         // release resource
-        buffer_manager_->UnpinBlock({index_file_name_, old_bucket_num}, insert_is_successful);
-
         if (insert_is_successful) {
+            bucket_guard.SetDirty();
             break;
         }
     }
@@ -981,25 +1006,19 @@ void BPLUSTREE_TYPE::InsertIntoBucketChain(int first_bucket_num, const ValueType
     // can't insert, create a new bucket
     if (!insert_is_successful) {
         // create new bucket page
-        int free_block_num;
-        BucketPage *bucket = CreateBTreePage<BucketPage>
-                            (PageType::BPLUS_TREE_BUCKET_PAGE, &free_block_num);
+        BasicPageGuard new_guard = CreateBTreePage(PageType::BPLUS_TREE_BUCKET_PAGE);
+        auto *bucket = new_guard.DataAs<BucketPage>();
 
 
         // try to insert into it
         insert_is_successful = bucket->Insert(value);
-        assert(insert_is_successful);
+        SIMPLEDB_ASSERT(insert_is_successful, "a new bucket should have space");
 
 
         // fetch prev bucket page
-        auto *prev_page = buffer_manager_->PinBlock({index_file_name_, old_bucket_num});
-        auto *prev_bucket = reinterpret_cast<BucketPage*>(prev_page->contents()->GetRawDataPtr()); 
-        prev_bucket->SetNextBucketNum(free_block_num);
-
-
-        // release resource
-        buffer_manager_->UnpinBlock({index_file_name_, free_block_num}, true);
-        buffer_manager_->UnpinBlock({index_file_name_, old_bucket_num}, true);   
+        auto prev_guard = buffer_manager_->PinBlockGuarded({index_file_name_, old_bucket_num});
+        prev_guard.DataAs<BucketPage>()->SetNextBucketNum(new_guard.GetBlockNum());
+        prev_guard.SetDirty();
     }
 }
 
@@ -1020,19 +1039,16 @@ bool BPLUSTREE_TYPE::RemoveInBucketChain(int &first_bucket_num,
     std::function<void(int, BucketPage*)> prev_to_next = [&]
             (int prev_block_num, BucketPage *curr_bucket) {
         if (prev_block_num != INVALID_BLOCK_NUM) {
-            auto *prev_buffer = buffer_manager_->PinBlock({index_file_name_, prev_block_num});
-            BucketPage *prev_bucket = reinterpret_cast<BucketPage*>
-                                      (prev_buffer->contents()->GetRawDataPtr());
-            prev_bucket->SetNextBucketNum(curr_bucket->GetNextBucketNum());
-            buffer_manager_->UnpinBlock({index_file_name_, prev_block_num}, true);
+            auto prev_guard = buffer_manager_->PinBlockGuarded({index_file_name_, prev_block_num});
+            prev_guard.DataAs<BucketPage>()->SetNextBucketNum(curr_bucket->GetNextBucketNum());
+            prev_guard.SetDirty();
         }
     };
 
 
     while (curr_bucket_num != INVALID_BLOCK_NUM) {
-        auto *curr_buffer = buffer_manager_->PinBlock({index_file_name_, curr_bucket_num});
-        BucketPage *curr_bucket = reinterpret_cast<BucketPage*>
-                                  (curr_buffer->contents()->GetRawDataPtr());
+        auto curr_guard = buffer_manager_->PinBlockGuarded({index_file_name_, curr_bucket_num});
+        auto *curr_bucket = curr_guard.DataAs<BucketPage>();
         
         // try to remove it
         remove_is_successful |= curr_bucket->Remove(value);
@@ -1053,10 +1069,12 @@ bool BPLUSTREE_TYPE::RemoveInBucketChain(int &first_bucket_num,
 
         
         // release resource
-        bool is_dirty = remove_is_successful | (!curr_bucket_size);
+        if (remove_is_successful || curr_bucket_size == 0) {
+            curr_guard.SetDirty();
+        }
         prev_block_num = curr_bucket_num;
         curr_bucket_num = curr_bucket->GetNextBucketNum();
-        buffer_manager_->UnpinBlock({index_file_name_, prev_block_num}, is_dirty);
+        curr_guard.Drop();
     
 
         if (remove_is_successful) {
@@ -1081,49 +1099,37 @@ bool BPLUSTREE_TYPE::RemoveInBucketChain(int &first_bucket_num,
 // |           Insert relative Functions          |
 // ------------------------------------------------
 INDEX_TEMPLATE_ARGUMENTS
-template<typename N>
-N* BPLUSTREE_TYPE::CreateBTreePage(PageType page_type_, int *new_block_num) {
+BasicPageGuard BPLUSTREE_TYPE::CreateBTreePage(PageType page_type) {
     // prefer to create a btree page from the deleted page
-    Buffer *tmp_buffer = nullptr;
-    BPlusTreePage* tmp_page = nullptr;
+    BasicPageGuard guard;
+    int new_block_num;
 
     if (last_deleted_num_ == INVALID_BLOCK_NUM) {
-        tmp_buffer = buffer_manager_->NewBlock(index_file_name_, new_block_num);
-        tmp_page = reinterpret_cast<BPlusTreePage*>(tmp_buffer->contents()->GetRawDataPtr());
+        guard = buffer_manager_->NewBlockGuarded(index_file_name_, &new_block_num);
     }
     else {
-        tmp_buffer = buffer_manager_->PinBlock({index_file_name_, last_deleted_num_});
-        *new_block_num = last_deleted_num_;
-        tmp_page = reinterpret_cast<BPlusTreePage*>(tmp_buffer->contents()->GetRawDataPtr());
-        last_deleted_num_ = tmp_page->GetDeletedBlockNum();
+        new_block_num = last_deleted_num_;
+        guard = buffer_manager_->PinBlockGuarded({index_file_name_, new_block_num});
+        last_deleted_num_ = guard.DataAs<BPlusTreePage>()->GetDeletedBlockNum();
     }
+    guard.SetDirty();
     
 
 
     // reset infor
-    switch (page_type_)
+    switch (page_type)
     {
     case PageType::BPLUS_TREE_LEAF_PAGE:
-    {
-        LeafPage *new_page = reinterpret_cast<LeafPage*>(tmp_page);
-        new_page->Init(*new_block_num, max_leaf_size_);
-        return reinterpret_cast<N*>(new_page);
-    }
-
+        guard.DataAs<LeafPage>()->Init(new_block_num, max_leaf_size_);
+        break;
 
     case PageType::BPLUS_TREE_DIRECTORY_PAGE:
-    {
-        DirectoryPage *new_page = reinterpret_cast<DirectoryPage*>(tmp_page);
-        new_page->Init(*new_block_num, max_dir_size_);
-        return reinterpret_cast<N*>(new_page);
-    }
+        guard.DataAs<DirectoryPage>()->Init(new_block_num, max_dir_size_);
+        break;
 
     case PageType::BPLUS_TREE_BUCKET_PAGE:
-    {
-        BucketPage *new_page = reinterpret_cast<BucketPage*>(tmp_page);
-        new_page->Init(*new_block_num);
-        return reinterpret_cast<N*>(new_page);
-    }
+        guard.DataAs<BucketPage>()->Init(new_block_num);
+        break;
     
     default:
         assert(false);
@@ -1131,7 +1137,7 @@ N* BPLUSTREE_TYPE::CreateBTreePage(PageType page_type_, int *new_block_num) {
     }
 
 
-    return nullptr;
+    return guard;
 }
 
 
@@ -1163,16 +1169,14 @@ void BPLUSTREE_TYPE::ResetDirChildParentOne(DirectoryPage *dir_page,
                                             int child_block_num) {
 
     int parent_block_num = dir_page->GetBlockNum();
-    auto *child_buffer = buffer_manager_->PinBlock({index_file_name_, child_block_num});
-    auto *child_bplus_page = reinterpret_cast<BPlusTreePage*>
-                             (child_buffer->contents()->GetRawDataPtr());
+    auto child_guard = buffer_manager_->PinBlockGuarded({index_file_name_, child_block_num});
+    auto *child_bplus_page = child_guard.DataAs<BPlusTreePage>();
     PageType page_type = child_bplus_page->GetPageType();
     bool need_to_set = (child_bplus_page->GetParentBlockNum() != parent_block_num);
 
     
     // if we don't need to, just return immediately and don't need to flush to disk
     if (!need_to_set) {
-        buffer_manager_->UnpinBlock({index_file_name_, child_block_num}, false);
         return;
     }
 
@@ -1200,7 +1204,7 @@ void BPLUSTREE_TYPE::ResetDirChildParentOne(DirectoryPage *dir_page,
     }
 
 
-    buffer_manager_->UnpinBlock({index_file_name_, child_block_num}, true);
+    child_guard.SetDirty();
 }
 
 
@@ -1208,9 +1212,9 @@ INDEX_TEMPLATE_ARGUMENTS
 std::unique_ptr<BPLUSTREE_ITERATOR_TYPE> BPLUSTREE_TYPE::Begin() {
     // move to the first leaf node
     root_latch_.RLock();
-    Buffer *curr_buffer = buffer_manager_->PinBlock({index_file_name_, root_block_num_});
-    BPlusTreePage *curr_page = reinterpret_cast<BPlusTreePage*>(curr_buffer->contents()->GetRawDataPtr());  
-    curr_buffer->RLock();
+    bool is_root_locked = true;
+    auto curr_guard = buffer_manager_->PinBlockRead({index_file_name_, root_block_num_});
+    auto *curr_page = curr_guard.DataAs<BPlusTreePage>();
 
 
     // search for a leaf page 
@@ -1222,17 +1226,16 @@ std::unique_ptr<BPLUSTREE_ITERATOR_TYPE> BPLUSTREE_TYPE::Begin() {
 
 
         // unpin old curr_page
-        if (curr_buffer->GetBlockID().BlockNum() == root_block_num_) {
+        if (is_root_locked) {
             root_latch_.RUnlock();
+            is_root_locked = false;
         }
-        curr_buffer->RUnlock();
-        buffer_manager_->UnpinBlock({index_file_name_, dir_page->GetBlockNum()}, false);
+        curr_guard.Drop();
         
         
         // create new curr_page
-        curr_buffer = buffer_manager_->PinBlock({index_file_name_, child_block_num});
-        curr_page = reinterpret_cast<BPlusTreePage*>(curr_buffer->contents()->GetRawDataPtr());
-        curr_buffer->RLock();
+        curr_guard = buffer_manager_->PinBlockRead({index_file_name_, child_block_num});
+        curr_page = curr_guard.DataAs<BPlusTreePage>();
     }
 
 
@@ -1242,12 +1245,15 @@ std::unique_ptr<BPLUSTREE_ITERATOR_TYPE> BPLUSTREE_TYPE::Begin() {
     // check some special cases
     if (block_num == root_block_num_ && curr_page->GetSize() == 0) {
         block_num = INVALID_BLOCK_NUM;
-        curr_buffer->RUnlock();
-        buffer_manager_->UnpinBlock({index_file_name_, root_block_num_}, false);
-        curr_buffer = nullptr;
+        curr_guard.Drop();
+    }
+
+    // the root is a leaf
+    if (is_root_locked) {
+        root_latch_.RUnlock();
     }
     
-    return std::make_unique<BPLUSTREE_ITERATOR_TYPE>(0, block_num, curr_buffer, this);
+    return std::make_unique<BPLUSTREE_ITERATOR_TYPE>(0, block_num, std::move(curr_guard), this);
 }
 
 
@@ -1255,15 +1261,14 @@ INDEX_TEMPLATE_ARGUMENTS
 std::unique_ptr<BPLUSTREE_ITERATOR_TYPE> BPLUSTREE_TYPE::Begin(const KeyType &search_key) {
     // move to the first key which greater equal than search key
     root_latch_.RLock();
-    BPlusTreeContext context(buffer_manager_);
+    BPlusTreeContext context;
     bool is_root_locked = true;
     int curr_block_num = SearchLeaf(search_key, &context, BPlusTreeOpearion::QUERY, &is_root_locked);
-    int old_curr_block_num = curr_block_num;
 
 
-    // create curr page, don't need to acquire read lock since we have granted in search leaf
-    Buffer *curr_buffer = buffer_manager_->PinBlock({index_file_name_, curr_block_num});
-    auto *curr_leaf = reinterpret_cast<LeafPage*>(curr_buffer->contents()->GetRawDataPtr());
+    // take over the leaf from context, it has been pinned and latched in search leaf
+    auto curr_guard = context.TakeBack();
+    auto *curr_leaf = curr_guard.DataAs<LeafPage>();
     int curr_slot = curr_leaf->KeyIndexGreaterEqual(search_key, comparator_);
     
 
@@ -1280,14 +1285,13 @@ std::unique_ptr<BPLUSTREE_ITERATOR_TYPE> BPLUSTREE_TYPE::Begin(const KeyType &se
         curr_block_num = next_block_num;
 
         if (curr_block_num != INVALID_BLOCK_NUM) {
-            curr_buffer->RUnlock();
-            buffer_manager_->UnpinBlock({index_file_name_, old_curr_block_num}, false);
+            // release the leaf before latching its sibling, 
+            // writers latch siblings from left to right
+            curr_guard.Drop();
         
             // create new buffer and new leaf page
-            curr_buffer = buffer_manager_->PinBlock({index_file_name_, curr_block_num});
-            curr_leaf = reinterpret_cast<LeafPage*>(curr_buffer->contents()->GetRawDataPtr());
+            curr_guard = buffer_manager_->PinBlockRead({index_file_name_, curr_block_num});
             curr_slot = 0;
-            curr_buffer->RLock();
         }
     }
     
@@ -1297,15 +1301,10 @@ std::unique_ptr<BPLUSTREE_ITERATOR_TYPE> BPLUSTREE_TYPE::Begin(const KeyType &se
     }
 
     if (curr_block_num == INVALID_BLOCK_NUM) {
-        curr_buffer->RUnlock();
-        buffer_manager_->UnpinBlock({index_file_name_, old_curr_block_num}, false);
-        curr_buffer = nullptr;
+        curr_guard.Drop();
     }
 
-
-    // unpin once since we have pin block in searchkey, curr_pin_count: 2->1
-    buffer_manager_->UnpinBlock({index_file_name_, old_curr_block_num}, false);
-    return std::make_unique<BPLUSTREE_ITERATOR_TYPE>(curr_slot, curr_block_num, curr_buffer, this);
+    return std::make_unique<BPLUSTREE_ITERATOR_TYPE>(curr_slot, curr_block_num, std::move(curr_guard), this);
 }
 
 
@@ -1315,9 +1314,8 @@ std::unique_ptr<BPLUSTREE_ITERATOR_TYPE> BPLUSTREE_TYPE::Begin(const KeyType &se
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::PrintDir(int block_num) const {
     assert(block_num != INVALID_BLOCK_NUM);
-    auto *buffer = buffer_manager_->PinBlock({index_file_name_, block_num});
-    auto *bplus_page = reinterpret_cast<BPlusTreePage*>
-                             (buffer->contents()->GetRawDataPtr());
+    auto guard = buffer_manager_->PinBlockGuarded({index_file_name_, block_num});
+    auto *bplus_page = guard.DataAs<BPlusTreePage>();
     auto *dir_page = reinterpret_cast<DirectoryPage*>(bplus_page);
 
     // std::cout << "start  print  dir   " << std::endl; 
@@ -1325,9 +1323,8 @@ void BPLUSTREE_TYPE::PrintDir(int block_num) const {
     // dir_page->PrintDir();
     int size = dir_page->GetSize();
     for (int i = 0; i < size; i++) {
-        auto *child_buffer = buffer_manager_->PinBlock({index_file_name_, dir_page->ValueAt(i) });
-        auto *child_bplus_page = reinterpret_cast<BPlusTreePage*>
-                             (child_buffer->contents()->GetRawDataPtr());
+        auto child_guard = buffer_manager_->PinBlockGuarded({index_file_name_, dir_page->ValueAt(i) });
+        auto *child_bplus_page = child_guard.DataAs<BPlusTreePage>();
         // if (bplus_page->GetPageType() == PageType::BPLUS_TREE_DIRECTORY_PAGE) {
         //      auto *child_dir_page = reinterpret_cast<DirectoryPage*>(child_bplus_page);
         //      PrintDir(child_dir_page->GetBlockNum());
@@ -1336,22 +1333,17 @@ void BPLUSTREE_TYPE::PrintDir(int block_num) const {
             auto *child_dir_page = reinterpret_cast<LeafPage*>(child_bplus_page);
             child_dir_page->PrintLeaf();
         // }
-        buffer_manager_->UnpinBlock(child_buffer);
     }
-
-    buffer_manager_->UnpinBlock(buffer);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::PrintTree() const {
-    auto *buffer = buffer_manager_->PinBlock({index_file_name_, root_block_num_});
-    auto *bplus_page = reinterpret_cast<BPlusTreePage*>
-                             (buffer->contents()->GetRawDataPtr());
+    auto guard = buffer_manager_->PinBlockGuarded({index_file_name_, root_block_num_});
+    auto *bplus_page = guard.DataAs<BPlusTreePage>();
 
     if (bplus_page->GetPageType() == PageType::BPLUS_TREE_LEAF_PAGE) {
         auto *leaf_page = reinterpret_cast<LeafPage*>(bplus_page);
         leaf_page->PrintLeaf();
-        buffer_manager_->UnpinBlock(buffer);
         return;
     }
     std::cout << "\n\n" << std::endl;
@@ -1362,9 +1354,8 @@ void BPLUSTREE_TYPE::PrintTree() const {
     int size = dir_page->GetSize();
     for (int i = 0; i < size; i++) {
         std::cout << "\n\n" << std::endl;
-        auto *child_buffer = buffer_manager_->PinBlock({index_file_name_, dir_page->ValueAt(i) });
-        auto *child_bplus_page = reinterpret_cast<BPlusTreePage*>
-                                 (child_buffer->contents()->GetRawDataPtr());
+        auto child_guard = buffer_manager_->PinBlockGuarded({index_file_name_, dir_page->ValueAt(i) });
+        auto *child_bplus_page = child_guard.DataAs<BPlusTreePage>();
 
         if (child_bplus_page->GetPageType() == PageType::BPLUS_TREE_DIRECTORY_PAGE) {
             std::cout << " root's child " << i << " is a dir " << std::endl;
@@ -1375,12 +1366,7 @@ void BPLUSTREE_TYPE::PrintTree() const {
             auto *child_dir_page = reinterpret_cast<LeafPage*>(child_bplus_page);
             child_dir_page->PrintLeaf();
         }
-
-        
-        buffer_manager_->UnpinBlock(child_buffer);
     }
-
-    buffer_manager_->UnpinBlock(buffer);
 }
 
 #endif
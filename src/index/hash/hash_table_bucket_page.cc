@@ -9,9 +9,9 @@ namespace SimpleDB {
 
 void HashTableBucketPage::InitHashBucketPage(int tuple_size, TypeID type) {
     // clear all data
-    data_->ZeroPage();
+    data_.ZeroPage();
 
-    int block_size = data_->GetSize();
+    int block_size = data_.GetSize();
     int free_space = block_size - PAGE_HEADER_SIZE;
     int tuple_count = (4 * free_space / (4 * tuple_size + 1));
     int bit_map_size = (tuple_count - 1) / 8 + 1;
@@ -71,9 +71,9 @@ bool HashTableBucketPage::Insert(const Value &key, const RID &value) {
         SetReadable(i);
         SetOccupied(i);
         int offset = GetDataArrayPtr() + i * GetTupleSize();
-        data_->SetValue(offset, key); // key
-        data_->SetInt(offset + key_size, value.GetBlockNum()); // value
-        data_->SetInt(offset + key_size + sizeof(int), value.GetSlot());
+        data_.SetValue(offset, key); // key
+        data_.SetInt(offset + key_size, value.GetBlockNum()); // value
+        data_.SetInt(offset + key_size + sizeof(int), value.GetSlot());
         return true;
     }
 
@@ -115,7 +115,7 @@ Value HashTableBucketPage::KeyAt(uint32_t bucket_idx) const {
     assert(key_size > 0);
     int offset = GetDataArrayPtr() + bucket_idx * GetTupleSize();
 
-    return data_->GetValue(offset, GetTypeID());
+    return data_.GetValue(offset, GetTypeID());
 }
 
 
@@ -126,7 +126,7 @@ RID HashTableBucketPage::ValueAt(uint32_t bucket_idx) const {
     int block_offset = offset + key_size;
     int slot_offset = block_offset + sizeof(int);
 
-    return RID(data_->GetInt(block_offset), data_->GetInt(slot_offset));
+    return RID(data_.GetInt(block_offset), data_.GetInt(slot_offset));
 }
 
 
@@ -210,7 +210,7 @@ bool HashTableBucketPage::IsReadable(uint32_t bucket_idx) {
     int char_index = bucket_idx % 8;
     int bit_map_offset = PAGE_HEADER_SIZE + bit_map_index;
     
-    return (data_->GetByte(bit_map_offset) >> char_index) & 1;
+    return (data_.GetByte(bit_map_offset) >> char_index) & 1;
 }
 
 
@@ -218,10 +218,10 @@ void HashTableBucketPage::SetReadable(uint32_t bucket_idx) {
     int bit_map_index = bucket_idx / 8;
     int char_index = bucket_idx % 8;
     int bit_offset = PAGE_HEADER_SIZE + bit_map_index;
-    auto c =  (data_->GetByte(bit_offset));
+    auto c =  (data_.GetByte(bit_offset));
     
     c |= (1 << char_index);
-    data_->SetByte(bit_offset, c);
+    data_.SetByte(bit_offset, c);
 }
 
 
@@ -229,10 +229,10 @@ void HashTableBucketPage::SetUnReadable(uint32_t bucket_idx) {
     int bit_map_index = bucket_idx / 8;
     int char_index = bucket_idx % 8;
     int bit_map_offset = PAGE_HEADER_SIZE + bit_map_index;
-    auto c =  (data_->GetByte(bit_map_offset));
+    auto c =  (data_.GetByte(bit_map_offset));
     char bit = (-1) ^ (1 << char_index);
 
-    data_->SetByte(bit_map_offset, c & bit);
+    data_.SetByte(bit_map_offset, c & bit);
 }
 
 
@@ -243,7 +243,7 @@ bool HashTableBucketPage::IsOccupied(uint32_t bucket_idx) {
     int bit_map_offset = PAGE_HEADER_SIZE + bit_map_index + GetBitMapSize();
 
 
-    return (data_->GetByte(bit_map_offset) >> char_index) & 1; 
+    return (data_.GetByte(bit_map_offset) >> char_index) & 1; 
 }
 
 
@@ -252,11 +252,11 @@ void HashTableBucketPage::SetOccupied(uint32_t bucket_idx) {
     int bit_map_index = bucket_idx / 8;
     int char_index = bucket_idx % 8;
     int bit_offset = PAGE_HEADER_SIZE + bit_map_index + GetBitMapSize();
-    auto c =  (data_->GetByte(bit_offset));
+    auto c =  (data_.GetByte(bit_offset));
 
 
     c |= (1 << char_index);
-    data_->SetByte(bit_offset, c);  
+    data_.SetByte(bit_offset, c);  
 }
 
 
@@ -0,0 +1,337 @@
+#ifndef LOG_FILE_CC
+#define LOG_FILE_CC
+
+#include "log/log_file.h"
+#include "config/macro.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <stdexcept>
+#include <unistd.h>
+#include <vector>
+
+namespace SimpleDB {
+
+LogFile::LogFile(FileManager *file_manager, const std::string &log_name, int segment_size)
+    : file_manager_(file_manager), log_name_(log_name), segment_size_(segment_size) {
+    SIMPLEDB_ASSERT(segment_size_ % file_manager_->BlockSize() == 0,
+                    "segment size should be a multiple of block size");
+
+    // open all the segments of log
+    std::string prefix = log_name_ + ".";
+    directory_ = std::filesystem::path(file_manager_->GetFilePath(log_name_)).parent_path().string();
+    for (auto &entry : std::filesystem::directory_iterator(directory_)) {
+        std::string file_name = entry.path().filename().string();
+        if (file_name.size() <= prefix.size() ||
+            file_name.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        std::string suffix = file_name.substr(prefix.size());
+        if (suffix.find_first_not_of("0123456789") != std::string::npos) {
+            continue;
+        }
+
+        int fd = open(entry.path().c_str(), O_RDWR);
+        if (fd == -1) {
+            throw std::runtime_error("can't open log segment " + file_name);
+        }
+        segments_[std::stoll(suffix)] = std::make_shared<Segment>(fd);
+    }
+
+    if (segments_.empty()) {
+        GetSegment(0);
+    }
+    begin_segment_ = segments_.begin()->first;
+    FindEnd();
+
+    // the next segment is ready before log reaches it
+    GetSegment(end_offset_ / segment_size_ + 1);
+}
+
+
+LogFile::~LogFile() {}
+
+
+LogFile::Segment::~Segment() {
+    close(fd_);
+}
+
+
+void LogFile::Append(const char *data, int size) {
+    int write_count = 0;
+    while (write_count < size) {
+        log_offset_t offset = end_offset_;
+        log_offset_t segment_id = offset / segment_size_;
+        int segment_offset = offset % segment_size_;
+        int count = std::min(size - write_count, segment_size_ - segment_offset);
+        auto segment = GetSegment(segment_id);
+        if (segment_offset == 0) {
+            GetSegment(segment_id + 1);
+        }
+
+        int done = 0;
+        while (done < count) {
+            int res = pwrite(segment->fd_, data + write_count + done, count - done, segment_offset + done);
+            if (res == -1 && errno == EINTR) {
+                continue;
+            }
+            if (res <= 0) {
+                throw std::runtime_error("I/O error when write a log");
+            }
+            done += res;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(latch_);
+            dirty_segments_.insert(segment_id);
+        }
+        end_offset_ += count;
+        write_count += count;
+    }
+}
+
+
+void LogFile::Read(log_offset_t offset, char *buf, int size) {
+    int read_count = 0;
+    while (read_count < size) {
+        log_offset_t segment_id = (offset + read_count) / segment_size_;
+        int segment_offset = (offset + read_count) % segment_size_;
+        int count = std::min(size - read_count, segment_size_ - segment_offset);
+
+        // the reference keeps fd open even if the segment is truncated
+        std::shared_ptr<Segment> segment;
+        if (segment_id >= begin_segment_) {
+            std::lock_guard<std::mutex> lock(latch_);
+            auto iter = segments_.find(segment_id);
+            if (iter != segments_.end()) {
+                segment = iter->second;
+            }
+        }
+
+        int done = 0;
+        while (segment != nullptr && done < count) {
+            int res = pread(segment->fd_, buf + read_count + done, count - done, segment_offset + done);
+            if (res == -1 && errno == EINTR) {
+                continue;
+            }
+            if (res == -1) {
+                throw std::runtime_error("I/O error when read a log");
+            }
+            if (res == 0) {
+                break;
+            }
+            done += res;
+        }
+
+        // the log which not exists is zero
+        memset(buf + read_count + done, 0, count - done);
+        read_count += count;
+    }
+}
+
+
+void LogFile::Sync() {
+    std::vector<std::shared_ptr<Segment>> segments;
+    {
+        std::lock_guard<std::mutex> lock(latch_);
+        for (auto segment_id : dirty_segments_) {
+            segments.push_back(segments_[segment_id]);
+        }
+        dirty_segments_.clear();
+    }
+
+    for (auto &segment : segments) {
+        if (fdatasync(segment->fd_) == -1) {
+            throw std::runtime_error("I/O error when sync a log");
+        }
+    }
+}
+
+
+void LogFile::Truncate(log_offset_t offset) {
+    std::vector<std::pair<log_offset_t, std::shared_ptr<Segment>>> old_segments;
+    // the id which each old segment is recycled as, or -1 if it's deleted
+    std::vector<log_offset_t> new_ids;
+    log_offset_t truncate_segment;
+
+    // only pick the segments under the latch, so appending and syncing
+    // log are not blocked by the I/O of recycling
+    {
+        std::lock_guard<std::mutex> lock(latch_);
+        log_offset_t end_segment = end_offset_ / segment_size_;
+        truncate_segment = std::min(offset / segment_size_, end_segment);
+        log_offset_t max_segment = segments_.rbegin()->first;
+        if (!recycling_segments_.empty()) {
+            max_segment = std::max(max_segment, *recycling_segments_.rbegin());
+        }
+
+        while (segments_.begin()->first < truncate_segment) {
+            log_offset_t segment_id = segments_.begin()->first;
+            old_segments.emplace_back(segment_id, segments_.begin()->second);
+            segments_.erase(segments_.begin());
+            dirty_segments_.erase(segment_id);
+
+            if (max_segment - end_segment >= SIMPLEDB_LOG_FREE_SEGMENT_NUM) {
+                // there are enough segments for future log
+                new_ids.push_back(-1);
+                continue;
+            }
+
+            // reserve the id, appending to it waits until it's ready
+            max_segment ++;
+            recycling_segments_.insert(max_segment);
+            new_ids.push_back(max_segment);
+        }
+        begin_segment_ = std::max(begin_segment_.load(), truncate_segment);
+    }
+
+    if (old_segments.empty()) {
+        return;
+    }
+
+    try {
+        for (size_t i = 0;i < old_segments.size();i ++) {
+            // fd is closed when the readers and syncers using it are done
+            auto &segment = old_segments[i].second;
+            auto old_path = file_manager_->GetFilePath(SegmentName(old_segments[i].first));
+            if (new_ids[i] == -1) {
+                unlink(old_path.c_str());
+                continue;
+            }
+
+            // the old log must be zero on disk before the segment gets a
+            // future name, otherwise a crash may leave it at the end of log
+            // and recovery would read the old log as the newest one
+            PrepareSegment(segment->fd_, true);
+            auto new_path = file_manager_->GetFilePath(SegmentName(new_ids[i]));
+            if (rename(old_path.c_str(), new_path.c_str()) == -1) {
+                throw std::runtime_error("can't rename log segment " + old_path);
+            }
+        }
+
+        // otherwise a crash may bring back a truncated segment under its old name
+        SyncDirectory();
+    } catch (...) {
+        // let appending create the reserved segments by itself
+        std::lock_guard<std::mutex> lock(latch_);
+        for (auto id : new_ids) {
+            recycling_segments_.erase(id);
+        }
+        recycle_cv_.notify_all();
+        throw;
+    }
+
+    std::lock_guard<std::mutex> lock(latch_);
+    for (size_t i = 0;i < old_segments.size();i ++) {
+        if (new_ids[i] != -1) {
+            segments_[new_ids[i]] = old_segments[i].second;
+            recycling_segments_.erase(new_ids[i]);
+        }
+    }
+    recycle_cv_.notify_all();
+}
+
+
+int LogFile::GetSegmentNum() {
+    std::lock_guard<std::mutex> lock(latch_);
+    return segments_.size();
+}
+
+
+std::string LogFile::SegmentName(log_offset_t segment_id) const {
+    std::string id = std::to_string(segment_id);
+    return log_name_ + "." + std::string(std::max(0, 8 - static_cast<int>(id.size())), '0') + id;
+}
+
+
+std::shared_ptr<LogFile::Segment> LogFile::GetSegment(log_offset_t segment_id) {
+    std::unique_lock<std::mutex> lock(latch_);
+    // a truncated segment is being recycled as this one
+    recycle_cv_.wait(lock, [&]() {
+        return recycling_segments_.count(segment_id) == 0;
+    });
+    auto iter = segments_.find(segment_id);
+    if (iter != segments_.end()) {
+        return iter->second;
+    }
+
+    auto path = file_manager_->GetFilePath(SegmentName(segment_id));
+    int fd = open(path.c_str(), O_RDWR | O_CREAT, 0666);
+    if (fd == -1) {
+        throw std::runtime_error("can't open log segment " + path);
+    }
+    auto segment = std::make_shared<Segment>(fd);
+    PrepareSegment(fd, false);
+    // syncing log doesn't sync the directory, the new segment
+    // should be found after a crash
+    SyncDirectory();
+    segments_[segment_id] = segment;
+    return segment;
+}
+
+
+void LogFile::SyncDirectory() {
+    int fd = open(directory_.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd == -1) {
+        throw std::runtime_error("can't open log directory " + directory_);
+    }
+    int res = fsync(fd);
+    close(fd);
+    if (res == -1) {
+        throw std::runtime_error("I/O error when sync log directory " + directory_);
+    }
+}
+
+
+void LogFile::PrepareSegment(int fd, bool recycled) {
+    int mode = recycled ? FALLOC_FL_ZERO_RANGE : 0;
+    if (fallocate(fd, mode, 0, segment_size_) == -1) {
+        // the file system doesn't support it, write zero by ourselves
+        int block_size = file_manager_->BlockSize();
+        std::vector<char> zero(block_size, 0);
+        for (int offset = 0;offset < segment_size_;offset += block_size) {
+            if (pwrite(fd, zero.data(), block_size, offset) != block_size) {
+                throw std::runtime_error("I/O error when prepare a log segment");
+            }
+        }
+    }
+
+    // the size and space of segment are durable before any log is written,
+    // so syncing log doesn't need to update the metadata of file
+    if (fdatasync(fd) == -1) {
+        throw std::runtime_error("I/O error when sync a log segment");
+    }
+}
+
+
+void LogFile::FindEnd() {
+    std::vector<char> buf(segment_size_);
+
+    // the last segment whose first record is not empty
+    for (auto iter = segments_.rbegin();iter != segments_.rend();iter ++) {
+        Read(iter->first * segment_size_, buf.data(), segment_size_);
+        int offset = 0;
+        while (offset + static_cast<int>(sizeof(int)) <= segment_size_) {
+            int length;
+            memcpy(&length, buf.data() + offset, sizeof(int));
+            if (length == 0) {
+                break;
+            }
+            offset += sizeof(int) + length;
+        }
+
+        if (offset > 0) {
+            end_offset_ = iter->first * segment_size_ + std::min(offset, segment_size_);
+            return;
+        }
+    }
+
+    end_offset_ = begin_segment_ * segment_size_;
+}
+
+} // namespace SimpleDB
+
+#endif
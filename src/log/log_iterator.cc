@@ -4,19 +4,20 @@
 #include "log/log_iterator.h"
 #include "config/macro.h"
 
+#include <algorithm>
 #include <iostream>
 
 namespace SimpleDB {
 
-LogIterator::LogIterator(FileManager *file_manager, std::string file_name, int offset)
-            : file_manager_(file_manager), log_name_(file_name), file_offset_(offset) {
+LogIterator::LogIterator(LogFile *log_file, int block_size, log_offset_t offset)
+            : log_file_(log_file), file_offset_(offset) {
     std::shared_ptr<std::vector<char>> array = 
-            std::make_shared<std::vector<char>>(file_manager->BlockSize());
+            std::make_shared<std::vector<char>>(block_size);
     read_buf_ = std::make_unique<Page> (array);
     buffer_offset_ = 0;
-    buffer_size_ = file_manager_->BlockSize();
+    buffer_size_ = block_size;
+    log_file_size_ = log_file_->GetEndOffset();
     MoveToRecord(file_offset_);
-    log_file_size_ = file_manager_->GetFileSize(log_name_);
 }
 
 bool LogIterator::HasNextRecord() {
@@ -25,7 +26,7 @@ bool LogIterator::HasNextRecord() {
         return true;
     }
     // cache to reduce io cost
-    log_file_size_ = file_manager_->GetFileSize(log_name_);
+    log_file_size_ = log_file_->GetEndOffset();
     if (file_offset_ < log_file_size_) 
         return true;
     return false;
@@ -46,17 +47,55 @@ void LogIterator::NextRecord() {
 
     file_offset_ += add_len;
     buffer_offset_ += add_len;    
+    SkipSegmentEnd();
 }
 
-std::vector<char> LogIterator::MoveToRecord(int offset) {
-    file_manager_->ReadLog(log_name_, offset, *read_buf_);
+std::vector<char> LogIterator::MoveToRecord(log_offset_t offset) {
+    log_file_->Read(offset, read_buf_->GetRawDataPtr(), buffer_size_);
     buffer_offset_ = 0;
     file_offset_ = offset;
+    SkipSegmentEnd();
+
+    // a record may be larger than a block but never spans two segments,
+    // grow the buffer to read it as a whole
+    int need_size = read_buf_->GetInt(buffer_offset_) + sizeof(int);
+    if (need_size > buffer_size_) {
+        buffer_size_ = std::min(need_size, log_file_->GetSegmentSize());
+        std::shared_ptr<std::vector<char>> array = 
+                std::make_shared<std::vector<char>>(buffer_size_);
+        read_buf_ = std::make_unique<Page>(array);
+        log_file_->Read(file_offset_, read_buf_->GetRawDataPtr(), buffer_size_);
+        buffer_offset_ = 0;
+    }
     
     auto log_record_vector = read_buf_->GetBytes(buffer_offset_);
     return log_record_vector;
 }
 
+void LogIterator::SkipSegmentEnd() {
+    if (!HasNextRecord()) {
+        return;
+    }
+
+    // a record never spans two segments, a zero length 
+    // means the rest of segment is not used
+    int segment_size = log_file_->GetSegmentSize();
+    int segment_rest = segment_size - static_cast<int>(file_offset_ % segment_size);
+    if (segment_rest >= static_cast<int>(sizeof(int))) {
+        if (buffer_offset_ + static_cast<int>(sizeof(int)) > buffer_size_) {
+            log_file_->Read(file_offset_, read_buf_->GetRawDataPtr(), buffer_size_);
+            buffer_offset_ = 0;
+        }
+        if (read_buf_->GetInt(buffer_offset_) != 0) {
+            return;
+        }
+    }
+
+    file_offset_ += segment_rest;
+    log_file_->Read(file_offset_, read_buf_->GetRawDataPtr(), buffer_size_);
+    buffer_offset_ = 0;
+}
+
 std::vector<char> LogIterator::CurrentRecord() {
     int record_size;
     int need_size;
@@ -4,167 +4,379 @@
 #include "log/log_manager.h"
 #include "unistd.h"
 
+#include <cstring>
 #include <vector>
 #include <iostream>
 
 namespace SimpleDB {
 
-LogManager::LogManager(FileManager* file_manager, std::string log_file_name) :
-    file_manager_(file_manager), log_file_name_(log_file_name) , buffer_size_(file_manager_->BlockSize() * 10){
+LogManager::LogManager(FileManager* file_manager, std::string log_file_name,
+                       int buffer_num, int buffer_block_num, int segment_size) :
+    file_manager_(file_manager), log_file_name_(log_file_name), 
+    log_file_(std::make_unique<LogFile>(file_manager, log_file_name, segment_size)),
+    buffer_size_(file_manager_->BlockSize() * buffer_block_num) {
 
-    std::shared_ptr<std::vector<char>> 
-        array = std::make_shared<std::vector<char>>(buffer_size_, 0);
+    // one buffer is filled while the others are written
+    SIMPLEDB_ASSERT(buffer_num >= 2, "log manager needs at least two buffers");
+    for (int i = 0;i < buffer_num;i ++) {
+        auto buffer = std::make_unique<LogBuffer>();
+        buffer->page_ = std::make_unique<Page>(buffer_size_);
+        buffer->state_.store(MakeState(INVALID_LSN, SEALED_OFFSET));
+        free_buffers_.push_back(buffer.get());
+        buffers_.push_back(std::move(buffer));
+    }
 
-    // the logical block number of log file
-    log_buffer_ = std::make_unique<Page>(array); 
-    // the size of log in the current memory
-    log_count_ = 0;
-    log_file_size_ = file_manager_->GetFileSize(log_file_name_);
+    // new logs are appended to the end of log file
+    auto *active = free_buffers_.back();
+    free_buffers_.pop_back();
+    active->file_offset_ = log_file_->GetEndOffset();
+    active->state_.store(MakeState(INVALID_LSN, 0));
+    active_buffer_.store(active);
 }
 
-void LogManager::Flush() {
-    
-    // for(auto t : *(*log_buffer_).content()) {
-    //     // std::cout << t << std::flush;
-    // }
-    
-    file_manager_->WriteLog(log_file_name_, log_count_, *log_buffer_);
-    // clear log_count_ after writelog
-    log_count_ = 0;
-    last_flush_lsn_.store(lastest_lsn_); 
+LogManager::~LogManager() {
+    StopFlushThread();
+}
+
+void LogManager::SetLastestLsn(lsn_t lsn) {
+    std::lock_guard<std::mutex> lock(latch_);
+    auto *active = active_buffer_.load();
+    uint64_t state = active->state_.load();
+    while (!active->state_.compare_exchange_weak(state, MakeState(lsn, state & OFFSET_MASK))) {}
+}
+
+void LogManager::FlushAll() {
+    Flush(StateLsn(active_buffer_.load()->state_.load()));
+}
+
+bool LogManager::SealBuffer() {
+    if (free_buffers_.empty()) {
+        return false;
+    }
+
+    // close the buffer, appenders which reserved space before 
+    // are still copying their records
+    auto *buffer = active_buffer_.load();
+    uint64_t state = buffer->state_.load();
+    while (!buffer->state_.compare_exchange_weak(state, MakeState(StateLsn(state), SEALED_OFFSET))) {}
+    buffer->count_ = state & OFFSET_MASK;
+    buffer->last_lsn_ = StateLsn(state);
+    sealed_buffers_.push_back(buffer);
+
+    auto *next = free_buffers_.back();
+    free_buffers_.pop_back();
+    next->file_offset_ = buffer->file_offset_ + buffer->count_;
+    next->filled_.store(0);
+    next->state_.store(MakeState(buffer->last_lsn_, 0));
+    active_buffer_.store(next);
+    return true;
+}
+
+void LogManager::WriteSealedBuffers(bool sync) {
+    // buffers are popped and written under write latch, so they 
+    // are appended to log file in order
+    std::lock_guard<std::mutex> write_lock(write_latch_);
+    std::unique_lock<std::mutex> lock(latch_);
+
+    while (true) {
+        if (sealed_buffers_.empty()) {
+            if (!sync || (active_buffer_.load()->state_.load() & OFFSET_MASK) == 0) {
+                break;
+            }
+            // all the other buffers are free now, since we are the only writer
+            [[maybe_unused]] bool res = SealBuffer();
+            SIMPLEDB_ASSERT(res, "no free log buffer");
+            continue;
+        }
+
+        auto *buffer = sealed_buffers_.front();
+        sealed_buffers_.pop_front();
+        lock.unlock();
+
+        // only write the buffer after every record in it has been copied,
+        // copying doesn't take any latch, so it won't be long
+        while (buffer->filled_.load() < buffer->count_) {
+            std::this_thread::yield();
+        }
+        // appenders go on with the other buffers during writing
+        log_file_->Append(buffer->page_->GetRawDataPtr(), buffer->count_);
+        lock.lock();
+
+        last_write_lsn_ = buffer->last_lsn_;
+        free_buffers_.push_back(buffer);
+        operation_cv_.notify_all();
+    }
+
+    uint64_t state = active_buffer_.load()->state_.load();
+    if ((state & OFFSET_MASK) == 0 && sealed_buffers_.empty()) {
+        // every appended log has been written
+        last_write_lsn_ = StateLsn(state);
+    }
+
+    if (!sync) {
+        return;
+    }
+
+    lsn_t write_lsn = last_write_lsn_;
+    lock.unlock();
+    log_file_->Sync();
+    lock.lock();
+
+    last_flush_lsn_.store(write_lsn);
+    operation_cv_.notify_all();
 }
 
 void LogManager::Flush(int lsn) {
-    if(lsn >= last_flush_lsn_ ) {
-        Flush();
+    if (lsn <= last_flush_lsn_) {
+        return;
+    }
+
+    // background writer may flush log concurrently with appending
+    std::unique_lock<std::mutex> lock(latch_);
+    if (enable_flushing_) {
+        // only flush thread writes log file, so logs are appended in order.
+        // the committers arriving during a flush are covered by the next one
+        need_flush_ = true;
+        flush_cv_.notify_one();
+        operation_cv_.wait(lock, [&]() { return last_flush_lsn_ >= lsn; });
+        return;
     }
+
+    lock.unlock();
+    WriteSealedBuffers(true);
 }
 
-// note that the size of a log record which stores in disk is equal
-// to (log_record_length + sizeof(int))
-lsn_t LogManager::Append(const std::vector<char> &log_record) {
-    std::lock_guard<std::mutex> lock(latch_);
-    int record_length = log_record.size(); 
-    // The starting location where the page is stored
-    int start_address = log_count_;
-    // the size of log record  + sizeof(int)
-    int need_size = Page::MaxLength(record_length); 
+LogManager::Reservation LogManager::ReserveSpace(const std::function<int(lsn_t)> &size_of) {
+    bool sealed = false;
+
+    while (true) {
+        // reserve lsn and space together, so that the order 
+        // of records in log file is the order of lsn
+        auto *buffer = active_buffer_.load();
+        uint64_t state = buffer->state_.load();
+        uint64_t offset = state & OFFSET_MASK;
+        int need_size = size_of(StateLsn(state) + 1);
+        SIMPLEDB_ASSERT(need_size <= buffer_size_, "log record is larger than log buffer");
+        SIMPLEDB_ASSERT(need_size <= log_file_->GetSegmentSize(), "log record is larger than log segment");
+        // a record never spans two segments, the rest of segment
+        // is reserved and left as zero if the record doesn't fit
+        int segment_size = log_file_->GetSegmentSize();
+        uint64_t segment_rest = segment_size - (buffer->file_offset_ + offset) % segment_size;
+        if (static_cast<uint64_t>(need_size) > segment_rest &&
+            offset + segment_rest <= static_cast<uint64_t>(buffer_size_)) {
+            if (buffer->state_.compare_exchange_weak(state, state + segment_rest)) {
+                memset(buffer->page_->GetRawDataPtr() + offset, 0, segment_rest);
+                buffer->filled_.fetch_add(segment_rest);
+            }
+            continue;
+        }
+
+        if (offset + need_size <= static_cast<uint64_t>(buffer_size_)) {
+            uint64_t new_state = MakeState(StateLsn(state) + 1, offset + need_size);
+            if (buffer->state_.compare_exchange_weak(state, new_state)) {
+                return {buffer, static_cast<int>(offset), need_size, StateLsn(new_state), sealed};
+            }
+            continue;
+        }
+
+        // the buffer is full or sealed, switch to another one
+        std::unique_lock<std::mutex> lock(latch_);
+        if (active_buffer_.load() != buffer) {
+            continue;
+        }
+        if ((buffer->state_.load() & OFFSET_MASK) + need_size <= static_cast<uint64_t>(buffer_size_)) {
+            continue;
+        }
+
+        if (SealBuffer()) {
+            // flush thread writes it, or we do it after appending
+            if (enable_flushing_) {
+                need_flush_ = true;
+                flush_cv_.notify_one();
+            } else {
+                sealed = true;
+            }
+            continue;
+        }
 
-    if (start_address + need_size > buffer_size_) { // past than a buffer
-        // sizeof(int) means the size of the page-header
-        Flush();
-        start_address = 0;
+        // all buffers are full, wait for flush thread to return one,
+        // or write them by ourselves
+        if (enable_flushing_) {
+            need_flush_ = true;
+            flush_cv_.notify_one();
+            operation_cv_.wait(lock);
+        } else {
+            lock.unlock();
+            WriteSealedBuffers(false);
+        }
     }
-    
-    log_buffer_->SetBytes(start_address, log_record);
-    // now, the lastestlsn corresponds to the current log
-    lastest_lsn_ ++;
-    // update log file size and log_count_
-    log_file_size_ += need_size;
-    log_count_ += need_size;
+}
+
+void LogManager::FinishAppend(const Reservation &res) {
+    res.buffer_->filled_.fetch_add(res.size_);
 
-    return lastest_lsn_.load(); 
+    // write the full buffer without blocking other appenders
+    if (res.sealed_) {
+        WriteSealedBuffers(false);
+    }
 }
 
-lsn_t LogManager::AppendLogRecord(LogRecord &log_record) {
+void LogManager::FlushAsync(lsn_t lsn) {
+    // the flush thread syncs the log every interval, 
+    // nothing to do if it's running
+    if (lsn <= last_flush_lsn_ || enable_flushing_) {
+        return;
+    }
+    StartFlushThread();
+}
+
+void LogManager::StartFlushThread(std::chrono::milliseconds interval) {
     std::lock_guard<std::mutex> lock(latch_);
-    int record_length = log_record.RecordSize(); 
-    int start_address = log_count_; 
-    int need_size = Page::MaxLength(record_length); 
-    
-    if (start_address + need_size > buffer_size_) {
-        // sizeof(int) means the size of the page-header
-        Flush();
-        start_address = 0;
+    if (flush_thread_ != nullptr) {
+        return;
     }
-    
-    lastest_lsn_ ++; 
-    
-    // now, The lastestlsn corresponds to the current log
-    log_record.SetLsn(lastest_lsn_); 
-    auto log_record_vector = log_record.Serializeto();
-    log_buffer_->SetBytes(start_address, *log_record_vector);
 
-    // update log file size and log_count_
-    log_file_size_ += need_size;
-    log_count_ += need_size;
+    enable_flushing_ = true;
+    flush_thread_ = std::make_unique<std::thread>(
+        &LogManager::FlushThreadLoop, this, interval);
+}
+
+void LogManager::StopFlushThread() {
+    {
+        std::lock_guard<std::mutex> lock(latch_);
+        if (flush_thread_ == nullptr) {
+            return;
+        }
+        enable_flushing_ = false;
+    }
 
-    return lastest_lsn_.load(); /* return the lsn of current log */
+    flush_cv_.notify_one();
+    flush_thread_->join();
+    flush_thread_.reset();
 }
 
-lsn_t LogManager::AppendLogWithOffset(LogRecord &log_record,int *offset) {
-    std::lock_guard<std::mutex> lock(latch_);
-    int record_length = log_record.RecordSize(); 
-    int start_address = log_count_; 
-    int need_size = Page::MaxLength(record_length); 
+void LogManager::FlushThreadLoop(std::chrono::milliseconds interval) {
+    std::unique_lock<std::mutex> lock(latch_);
+    while (true) {
+        flush_cv_.wait_for(lock, interval, [this]() { 
+            return need_flush_ || !enable_flushing_; 
+        });
+        need_flush_ = false;
+        bool stop = !enable_flushing_;
 
-    if(start_address + need_size > buffer_size_) {
-        // sizeof(int) means the size of the page-header
-        Flush();
-        start_address = 0;
+        // one write and sync covers all the committers waiting now
+        lock.unlock();
+        WriteSealedBuffers(true);
+        lock.lock();
+
+        if (stop && sealed_buffers_.empty() &&
+            (active_buffer_.load()->state_.load() & OFFSET_MASK) == 0) {
+            break;
+        }
     }
+}
+
+
+
+// note that the size of a log record which stores in disk is equal
+// to (log_record_length + sizeof(int))
+lsn_t LogManager::Append(const std::vector<char> &log_record) {
+    int record_length = log_record.size(); 
+    // a zero length means the rest of segment is not used
+    SIMPLEDB_ASSERT(record_length > 0, "log record should not be empty");
+    // the size of log record  + sizeof(int)
+    int need_size = Page::MaxLength(record_length); 
+    auto res = ReserveSpace([need_size](lsn_t) { return need_size; });
     
-    lastest_lsn_ ++; 
+    // records are copied in parallel, since their spaces are disjoint
+    res.buffer_->page_->SetBytes(res.offset_, log_record);
+    FinishAppend(res);
+    return res.lsn_; 
+}
+
+LogManager::Reservation LogManager::ReserveAndWrite(LogRecord &log_record) {
+    auto res = ReserveSpace([&log_record](lsn_t lsn) {
+        log_record.SetLsn(lsn);
+        return Page::MaxLength(log_record.RecordSize());
+    });
     
     // now, The lastestlsn corresponds to the current log
-    log_record.SetLsn(lastest_lsn_);
-    auto log_record_vector = log_record.Serializeto();
-    log_buffer_->SetBytes(start_address, *log_record_vector);
-    
-    // update offset 
-    *offset = log_file_size_;
-    if (log_record.GetRecordType() == LogRecordType::CHECKPOINTEND) {
-        SetMasterLsnOffset(*offset);
-    }
+    log_record.SetLsn(res.lsn_); 
 
-    // update log file size and log_count_
-    log_file_size_ += need_size;
-    log_count_ += need_size;
+    // serialize the record in the reserved space directly, 
+    // the size of log record + the log record
+    int record_length = res.size_ - sizeof(int);
+    res.buffer_->page_->SetInt(res.offset_, record_length);
+    log_record.WriteTo(res.buffer_->page_->GetRawDataPtr() + res.offset_ + sizeof(int));
+    return res;
+}
 
-    return lastest_lsn_.load(); /* return the lsn of current log */
+lsn_t LogManager::AppendLogRecord(LogRecord &log_record) {
+    auto res = ReserveAndWrite(log_record);
+    FinishAppend(res);
+    return res.lsn_; /* return the lsn of current log */
+}
+
+lsn_t LogManager::AppendLogWithOffset(LogRecord &log_record, log_offset_t *offset) {
+    auto res = ReserveAndWrite(log_record);
+    
+    // update offset, the buffer can't be written before we finish
+    *offset = res.buffer_->file_offset_ + res.offset_;
+    FinishAppend(res);
+    return res.lsn_; /* return the lsn of current log */
 }
 
 
 
 LogIterator LogManager::Iterator() {
-    Flush(); /* because we will access the log file 
+    FlushAll(); /* because we will access the log file 
             which stored in disk, so should flush it */
 
     // return the first log stores in log file
-    return LogIterator(file_manager_, log_file_name_, 0);
+    return LogIterator(log_file_.get(), file_manager_->BlockSize(), log_file_->GetBeginOffset());
 }
 
 
-LogIterator LogManager::Iterator(int offset) {
-    Flush();
+LogIterator LogManager::Iterator(log_offset_t offset) {
+    FlushAll();
     
     // return the specifed log stores in log file
-    return LogIterator(file_manager_, log_file_name_, offset);
+    return LogIterator(log_file_.get(), file_manager_->BlockSize(), offset);
 }
 
-void LogManager::SetMasterLsnOffset(int offset) {
+void LogManager::SetMasterLsnOffset(log_offset_t offset) {
     auto byte_array = std::make_shared<std::vector<char>> (file_manager_->BlockSize());
     Page chkpt_page(byte_array);
-    chkpt_page.SetInt(0, offset);
+    // the low 32 bits first, so an old master record reads the same
+    chkpt_page.SetInt(0, static_cast<int>(offset & 0xffffffff));
+    chkpt_page.SetInt(sizeof(int), static_cast<int>(offset >> 32));
 
     
+    // the data pages and logs written before checkpoint should be durable
+    // before master record points to the new checkpoint
+    file_manager_->SyncAll();
     file_manager_->Write(BlockId(SIMPLEDB_CHKPT_FILE_NAME, 0), &chkpt_page);
+    file_manager_->Sync(SIMPLEDB_CHKPT_FILE_NAME);
     // debug purpose
     file_manager_->Read(BlockId(SIMPLEDB_CHKPT_FILE_NAME, 0), &chkpt_page);
-    SIMPLEDB_ASSERT(chkpt_page.GetInt(0) == offset, "write chkpt log error");
+    SIMPLEDB_ASSERT(chkpt_page.GetInt(0) == static_cast<int>(offset & 0xffffffff), 
+                    "write chkpt log error");
 }
 
-int LogManager::GetMasterLsnOffset() {
+log_offset_t LogManager::GetMasterLsnOffset() {
 
     if (file_manager_->GetFileSize(SIMPLEDB_CHKPT_FILE_NAME) == 0) {
         // file not exist, means have not written a checkpoint
         return -1;
     }
 
-    auto byte_array = std::make_shared<std::vector<char>> (4);
+    // filemanager always reads a whole block
+    auto byte_array = std::make_shared<std::vector<char>> (file_manager_->BlockSize());
     Page chkpt_page(byte_array);
     file_manager_->Read(BlockId(SIMPLEDB_CHKPT_FILE_NAME, 0), &chkpt_page);
-    return chkpt_page.GetInt(0);
+    auto low = static_cast<uint32_t>(chkpt_page.GetInt(0));
+    auto high = static_cast<log_offset_t>(chkpt_page.GetInt(sizeof(int)));
+    return (high << 32) | low;
 }
 
 } // namespace SimpleDB
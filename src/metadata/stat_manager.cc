@@ -42,7 +42,7 @@ void StatManager::RefreshStatistics(Transaction *txn) {
     std::unique_lock<std::recursive_mutex> latch(latch_);
     auto table_info = table_mgr_->GetTable(TABLE_CATCH, txn);
     Schema schema = table_info->schema_;
-    auto table_iterator = table_info->table_heap_->Begin(txn);
+    auto table_iterator = table_info->table_heap_->Begin(txn, true);
     
     // because during this period, We may drop some tables 
     map_stat_.clear();
@@ -73,7 +73,7 @@ StatInfo StatManager::CalculateStat(const std::string &table_name,
     int block_nums = 0;
     int tuple_nums = 0;
     auto table_info = table_mgr_->GetTable(table_name, txn);
-    auto table_iterator = table_info->table_heap_->Begin(txn);
+    auto table_iterator = table_info->table_heap_->Begin(txn, true);
 
     // a stupid way to caculate the number of distinct values
     // map column_name to a value-set
@@ -29,10 +29,6 @@ void TableHeap::Insert(Transaction *txn, const Tuple &tuple, RID *rid) {
     }
 
 
-    Buffer *buffer = buffer_pool_manager_->PinBlock(GetBlock(curr_rid));
-    auto table_page = static_cast<TablePage*> (buffer);
-
-
     // why we need this function?
     // for insertion in tablepage, It is very possible that this page cannot be inserted
     // then x-lock for these page requests which cannot be inserted will bring a performance 
@@ -48,14 +44,13 @@ void TableHeap::Insert(Transaction *txn, const Tuple &tuple, RID *rid) {
 
     // because different txns can read/write buffer 
     // at the same time, so we should use this latch to protect content
-    table_page->WLock();
+    auto guard = buffer_pool_manager_->PinBlockWrite(GetBlock(curr_rid));
 
     
-    while (!table_page->Insert(&curr_rid, tuple, upgrade, txn, recovery_manager_)) {
+    while (!guard.As<TablePage>()->Insert(&curr_rid, tuple, upgrade, txn, recovery_manager_)) {
         
         // if we insert fail, try to move to the next block
-        table_page->WUnlock();
-        buffer_pool_manager_->UnpinBlock(GetBlock(curr_rid));
+        guard.Drop();
         
         // should remember that read committed txn should release
         // s-lock after read operation finish
@@ -66,9 +61,7 @@ void TableHeap::Insert(Transaction *txn, const Tuple &tuple, RID *rid) {
             
             // since we have granted x-lock in this new block
             // in "MoveToNewBlock", don't need to acquire any lock again
-            buffer = buffer_pool_manager_->PinBlock(GetBlock(curr_rid));
-            table_page = static_cast<TablePage*> (buffer);
-            table_page->WLock();
+            guard = buffer_pool_manager_->PinBlockWrite(GetBlock(curr_rid));
         }
         else {
             MoveToBlock(curr_rid, curr_rid.GetBlockNum() + 1);
@@ -79,16 +72,13 @@ void TableHeap::Insert(Transaction *txn, const Tuple &tuple, RID *rid) {
                 SIMPLEDB_ASSERT(false, "acquire s-lock error");    
             }
 
-            buffer = buffer_pool_manager_->PinBlock(GetBlock(curr_rid));
-            table_page = static_cast<TablePage*> (buffer);
-            table_page->WLock();
+            guard = buffer_pool_manager_->PinBlockWrite(GetBlock(curr_rid));
         }
     }
 
     
 
-    table_page->WUnlock();
-    buffer_pool_manager_->UnpinBlock(GetBlock(curr_rid));
+    guard.Drop();
     txn->UnLockWhenRUC(GetBlock(curr_rid));
 
     if (rid != nullptr) {
@@ -101,20 +91,20 @@ bool TableHeap::GetTuple(Transaction *txn, const RID &rid, Tuple *tuple) {
 
     // get    
     txn->LockShared(GetBlock(rid));
-    Buffer *buffer = buffer_pool_manager_->PinBlock(GetBlock(rid));
-    auto table_page = static_cast<TablePage*> (buffer);
-    table_page->RLock();
-
-    // execute
-    bool res = true;
-    if (!table_page->GetTuple(rid, tuple)) {
-        res = false;
+    auto guard = buffer_pool_manager_->PinBlockGuarded(GetBlock(rid));
+    auto *table_page = guard.As<TablePage>();
+
+    // execute, try to read it without latch first
+    bool res;
+    if (!table_page->OptimisticGetTuple(rid, tuple, &res)) {
+        table_page->RLock();
+        res = table_page->GetTuple(rid, tuple);
+        table_page->RUnlock();
     }
 
 
     // release
-    table_page->RUnlock();
-    buffer_pool_manager_->UnpinBlock(GetBlock(rid));
+    guard.Drop();
     txn->UnLockWhenRUC(GetBlock(rid));
     
     return res;
@@ -125,21 +115,18 @@ bool TableHeap::InsertWithRid(Transaction *txn,
     
     // get
     txn->LockExclusive(GetBlock(rid));
-    Buffer *buffer = buffer_pool_manager_->PinBlock(GetBlock(rid));
-    auto *table_page = static_cast<TablePage*> (buffer);
-    table_page->WLock();
+    auto guard = buffer_pool_manager_->PinBlockWrite(GetBlock(rid));
     
     // execute
     bool res = true;
-    if (!table_page->InsertWithRID(rid, tuple, txn, recovery_manager_)) {
+    if (!guard.As<TablePage>()->InsertWithRID(rid, tuple, txn, recovery_manager_)) {
         res = false;
     }
     
 
     // why we must unpin here instead of more early?
     // release
-    table_page->WUnlock();
-    buffer_pool_manager_->UnpinBlock(GetBlock(rid));
+    guard.Drop();
 
     return res;    
 }
@@ -149,19 +136,15 @@ void TableHeap::Delete(Transaction *txn, const RID& rid) {
     // get
     txn->LockExclusive(GetBlock(rid));
     Tuple tuple;
-    Buffer *buffer = buffer_pool_manager_->PinBlock(GetBlock(rid));
-    auto *table_page = static_cast<TablePage*> (buffer);
-    table_page->WLock();
+    auto guard = buffer_pool_manager_->PinBlockWrite(GetBlock(rid));
 
     // since we have received s-lock in this block when Next method
     // other txns can't delete this tuple
-    if (!table_page->Delete(rid, &tuple, txn, recovery_manager_)) {
+    if (!guard.As<TablePage>()->Delete(rid, &tuple, txn, recovery_manager_)) {
         SIMPLEDB_ASSERT(false, "concurrency error");
     }
 
-    // release
-    table_page->WUnlock();
-    buffer_pool_manager_->UnpinBlock(GetBlock(rid));
+    // release when guard is destroyed
 }
 
 
@@ -170,20 +153,17 @@ bool TableHeap::Update(Transaction *txn, const RID& rid, const Tuple &new_tuple)
     // get
     txn->LockExclusive(GetBlock(rid));
     Tuple old_tuple;
-    Buffer *buffer = buffer_pool_manager_->PinBlock(GetBlock(rid));
-    auto *table_page = static_cast<TablePage*> (buffer);
-    table_page->WLock();
+    auto guard = buffer_pool_manager_->PinBlockWrite(GetBlock(rid));
 
     // execute
     bool res = true;
-    if (!table_page->Update(rid, &old_tuple, new_tuple, txn, recovery_manager_)) {
+    if (!guard.As<TablePage>()->Update(rid, &old_tuple, new_tuple, txn, recovery_manager_)) {
         // update may be fail, if update fail, we should abort this txn
         res = false;
     }
 
     // release
-    table_page->WUnlock();
-    buffer_pool_manager_->UnpinBlock(GetBlock(rid));
+    guard.Drop();
     return res;
 }
 
@@ -236,38 +216,40 @@ BlockId TableHeap::AppendBlock(Transaction *txn) {
     BlockId block = file_manager_->Append(file_name_);
     assert(txn->LockExclusive(block));
 
-    auto *table_page = static_cast<TablePage*>(buffer_pool_manager_->PinBlock(block));
-    
     // since newblock is a tabelpage, it's necessary to init it
-    table_page->WLock();
-    table_page->InitPage(txn, recovery_manager_);
-    table_page->WUnlock();
+    auto guard = buffer_pool_manager_->PinBlockWrite(block);
+    guard.As<TablePage>()->InitPage(txn, recovery_manager_);
+    guard.Drop();
     
-    buffer_pool_manager_->UnpinBlock(block);
     return block;
 }
 
 
 
-TableIterator TableHeap::Begin(Transaction *txn) {
+TableIterator TableHeap::Begin(Transaction *txn, bool bulk_read) {
+    // a bulk scan always reads ahead, but a table which fits in 
+    // a quarter of bufferpool is cached as usual instead of using a ring
+    std::shared_ptr<BufferAccessStrategy> strategy;
+    if (bulk_read) {
+        bool use_ring = GetFileSize(txn) > buffer_pool_manager_->GetBufferNum() / 4;
+        strategy = std::make_shared<BufferAccessStrategy>(use_ring ? SIMPLEDB_SCAN_RING_SIZE : 0);
+    }
+
     RID rid(0,-1);
     txn->LockShared(GetBlock(rid));
-    auto *table_page = static_cast<TablePage*> (buffer_pool_manager_->PinBlock(GetBlock(rid)));
-    table_page->RLock();
+    auto guard = buffer_pool_manager_->PinBlockRead(GetBlock(rid), strategy.get());
 
 
-    if (!table_page->GetFirstTupleRid(rid)) {
+    if (!guard.As<TablePage>()->GetFirstTupleRid(rid)) {
         while (rid.GetSlot() == -1) {
 
-            table_page->RUnlock();
+            // remember unpin before return
+            guard.Drop();
 
             // if this txn's isolation level is rc, means we need to acquire
             // s-block but don't need to grant it until txn terminated
             txn->UnLockWhenRUC(GetBlock(rid));
 
-            // remember unpin before return
-            buffer_pool_manager_->UnpinBlock(GetBlock(rid));
-
             // not have next block, we can't create new one in query
             if (AtLastBlock(txn, rid.GetBlockNum())) {
                 return End();
@@ -278,23 +260,21 @@ TableIterator TableHeap::Begin(Transaction *txn) {
             
             // acquire lock again
             txn->LockShared( GetBlock(rid));
-            table_page = static_cast<TablePage*> (buffer_pool_manager_->PinBlock(GetBlock(rid)));
+            guard = buffer_pool_manager_->PinBlockRead(GetBlock(rid), strategy.get());
 
             // acquire next tuple again
-            table_page->RLock();
-            table_page->GetNextTupleRid(&rid);
+            guard.As<TablePage>()->GetNextTupleRid(&rid);
         }
     }
 
     // release source
-    table_page->RUnlock();
-    buffer_pool_manager_->UnpinBlock(GetBlock(rid));
+    guard.Drop();
     txn->UnLockWhenRUC(GetBlock(rid));
 
     if (rid.GetSlot() == -1) {
         return End();
     }
-    return TableIterator(txn, this, rid);
+    return TableIterator(txn, this, rid, strategy);
 }
 
 
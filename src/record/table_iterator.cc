@@ -14,12 +14,13 @@ TableIterator& TableIterator::operator=(const TableIterator &iter) {
         table_heap_ = iter.table_heap_;
         rid_ = iter.rid_;
         tuple_ = iter.tuple_;
+        strategy_ = iter.strategy_;
         
         // unpin current block before pinblock
         Close();
         // we should pin this table page again
         if (rid_.GetBlockNum() != -1) {
-            table_page_ = static_cast<TablePage*> (txn_->PinBlock(GetBlock()));
+            PinTablePage();
         }
     }
     return *this;
@@ -29,11 +30,16 @@ TableIterator& TableIterator::operator=(const TableIterator &iter) {
 void TableIterator::GetTuple() {
     // gettuple directly
     txn_->LockShared(GetBlock());
-    table_page_->RLock();
 
-    bool res = table_page_->GetTuple(rid_, &tuple_);
+    // try to read it without latch first
+    bool res;
+    auto *table_page = GetTablePage();
+    if (!table_page->OptimisticGetTuple(rid_, &tuple_, &res)) {
+        table_page->RLock();
+        res = table_page->GetTuple(rid_, &tuple_);
+        table_page->RUnlock();
+    }
     
-    table_page_->RUnlock();
     txn_->UnLockWhenRUC(GetBlock());
     // catch the event
     if (!res) {
@@ -66,14 +72,15 @@ Tuple *TableIterator::operator->() {
 TableIterator TableIterator::operator++() {
     // acquire resource but don't need to pin
     txn_->LockShared(GetBlock());
-    table_page_->RLock();
+    auto *table_page = GetTablePage();
+    table_page->RLock();
 
     // find the next tuple's rid
-    if (!table_page_->GetNextTupleRid(&rid_)) {
+    if (!table_page->GetNextTupleRid(&rid_)) {
         while(rid_.GetSlot() == -1) {
 
             // release resource
-            table_page_->RUnlock();
+            table_page->RUnlock();
             // we should unpinblock here. but we can't replace the 
             // close function with unpinblock. it will unpin the block twice.
             Close(); 
@@ -90,18 +97,19 @@ TableIterator TableIterator::operator++() {
             
             // get resource again
             txn_->LockShared(GetBlock());
-            table_page_ = static_cast<TablePage*>(txn_->PinBlock(GetBlock()));
-            table_page_->RLock();
+            PinTablePage();
+            table_page = GetTablePage();
+            table_page->RLock();
 
             // acquire next tuple again
-            table_page_->GetNextTupleRid(&rid_);
+            table_page->GetNextTupleRid(&rid_);
         }
     }
 
     
 
     // release resource
-    table_page_->RUnlock();
+    table_page->RUnlock();
     txn_->UnLockWhenRUC(GetBlock());
 
     return *this;
@@ -134,11 +142,8 @@ BlockId TableIterator::GetBlock() {
 
 
 void TableIterator::Close() {
-    if (table_page_ != nullptr) {
-        assert(rid_.GetBlockNum() != -1);
-        txn_->UnpinBlock(GetBlock());
-        table_page_ = nullptr;
-    }
+    // the guard unpins the buffer it holds, no need to look up it again
+    page_guard_.Drop();
 }
 
 
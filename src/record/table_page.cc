@@ -13,8 +13,8 @@ void TablePage::InitPage(Transaction *txn, RecoveryManager *rm) {
         SetPageLsn(lsn);
     }
 
-    data_->SetPageType(PageType::TABLE_PAGE);
-    SetFreeSpacePtr(data_->GetSize());
+    data_.SetPageType(PageType::TABLE_PAGE);
+    SetFreeSpacePtr(data_.GetSize());
     SetTupleCount(0);
 }
 
@@ -39,11 +39,57 @@ bool TablePage::GetTuple(const RID &rid, Tuple *tuple) {
     }
 
 
-    *tuple = Tuple(data_->GetBytes(tuple_offset));
+    *tuple = Tuple(data_.GetBytes(tuple_offset));
     tuple->SetRID(rid);
     return true;
 }
 
+bool TablePage::OptimisticGetTuple(const RID &rid, Tuple *tuple, bool *exist) {
+    uint64_t version;
+    if (!TryOptimisticRead(&version)) {
+        return false;
+    }
+
+    // the page may be modified while we are reading, so every
+    // offset is checked before use instead of asserting it
+    int page_size = data_.GetSize();
+    int slot_number = rid.GetSlot();
+    int tuple_count = data_.GetInt(TUPLE_COUNT_OFFSET);
+    int slot_pos = SLOT_ARRAY_OFFSET + SLOT_SIZE * slot_number;
+    std::vector<char> bytes;
+    
+    *exist = false;
+    if (slot_number < tuple_count && slot_pos + SLOT_SIZE <= page_size) {
+        int tuple_offset = data_.GetInt(slot_pos);
+        
+        if (!IsDeleted(tuple_offset)) {
+            if (tuple_offset < SLOT_ARRAY_OFFSET || 
+                tuple_offset > page_size - static_cast<int>(sizeof(int))) {
+                return false;
+            }
+            
+            int tuple_size = data_.GetInt(tuple_offset);
+            if (tuple_size < 0 || tuple_size > page_size - tuple_offset - static_cast<int>(sizeof(int))) {
+                return false;
+            }
+
+            const char *begin = data_.GetRawDataPtr() + tuple_offset + sizeof(int);
+            bytes.assign(begin, begin + tuple_size);
+            *exist = true;
+        }
+    }
+
+    if (!Validate(version)) {
+        return false;
+    }
+
+    if (*exist) {
+        *tuple = Tuple(bytes);
+        tuple->SetRID(rid);
+    }
+    return true;
+}
+
 bool TablePage::Insert(RID *rid, const Tuple &tuple, 
                        const std::function<bool(const BlockId &)> &upgrade, 
                        Transaction *txn, RecoveryManager *rm) {
@@ -87,7 +133,7 @@ bool TablePage::Insert(RID *rid, const Tuple &tuple,
 
     SetFreeSpacePtr(GetFreeSpacePtr() - need_size);
     SetTupleOffset(i, GetFreeSpacePtr());
-    data_->SetBytes(GetTupleOffset(i), *tuple.GetData());
+    data_.SetBytes(GetTupleOffset(i), *tuple.GetData());
 
     // set rid
     if (rid != nullptr) {
@@ -148,7 +194,7 @@ bool TablePage::InsertWithRID(const RID &rid, const Tuple &tuple,
     // we can't use need_size to replace Page::Maxlength(...)
     // because slot_size is not need to add.
     int new_free_space_ptr = GetFreeSpacePtr() - Page::MaxLength(tuple.GetSize());
-    data_->SetBytes(new_free_space_ptr, *tuple.GetData());
+    data_.SetBytes(new_free_space_ptr, *tuple.GetData());
     
     SetFreeSpacePtr(new_free_space_ptr);
     SetTupleOffset(slot_number, new_free_space_ptr);
@@ -178,7 +224,7 @@ bool TablePage::Delete(const RID &rid, Tuple *tuple,
     }
 
     int tuple_offset = GetTupleOffset(slot_number);
-    *tuple = Tuple(data_->GetBytes(tuple_offset));
+    *tuple = Tuple(data_.GetBytes(tuple_offset));
     tuple->SetRID(rid);
     int tuple_size = Page::MaxLength(tuple->GetSize());
     int old_free_space_ptr = GetFreeSpacePtr();
@@ -187,8 +233,8 @@ bool TablePage::Delete(const RID &rid, Tuple *tuple,
 
     // for deleting a tuple, we should move the 
     // tuple before the tuple_pos_begin backwards
-    memmove(data_->GetRawDataPtr() + new_free_space_ptr, // dist
-            data_->GetRawDataPtr() + old_free_space_ptr, // src
+    memmove(data_.GetRawDataPtr() + new_free_space_ptr, // dist
+            data_.GetRawDataPtr() + old_free_space_ptr, // src
             move_total_size);
 
 
@@ -237,7 +283,7 @@ bool TablePage::Update(const RID &rid,
 
     SIMPLEDB_ASSERT(tuple_offset > 0, "can not update a non-exist tuple");
 
-    *old_tuple = data_->GetBytes(tuple_offset);
+    *old_tuple = data_.GetBytes(tuple_offset);
     old_tuple->SetRID(rid);
     
     int old_tuple_size = Page::MaxLength(old_tuple->GetSize());
@@ -254,8 +300,8 @@ bool TablePage::Update(const RID &rid,
 
     // for updating a tuple, we should move the 
     // tuple before the tuple_offset backwards
-    memmove(data_->GetRawDataPtr() + new_free_space_ptr,
-            data_->GetRawDataPtr() + old_free_space_ptr,
+    memmove(data_.GetRawDataPtr() + new_free_space_ptr,
+            data_.GetRawDataPtr() + old_free_space_ptr,
             tuple_offset - old_free_space_ptr);
     
     SetTupleOffset(slot_number, tuple_offset - change_size);
@@ -264,7 +310,7 @@ bool TablePage::Update(const RID &rid,
     // update new tuple offset
     tuple_offset = tuple_offset - change_size;
     // update new tuple data
-    data_->SetBytes(tuple_offset, *new_tuple.GetData());
+    data_.SetBytes(tuple_offset, *new_tuple.GetData());
 
 
     // update the offset of slot which before the tuple_offset
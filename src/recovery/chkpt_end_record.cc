@@ -7,14 +7,14 @@ namespace SimpleDB {
 
 // a txn_map_entry = integer + tx_table_entry
 // entry format:
-// | int | tx_table_entry.lsn | tx_table_entry.status |
-// the size of entry is constant
+// | txn_id | tx_table_entry.lsn | tx_table_entry.status |
 
 
 // a dp_map_entry = blockid + lsn_t
 // entry format:
-// | filename size | filename | int | lsn_t |
-// the size of entry is not constant, we should dynamically calc
+// | filename size | filename | block number | lsn_t |
+// all the integers are varints, so we should dynamically calc 
+// the size of entry
 
 
 ChkptEndRecord::ChkptEndRecord(std::map<txn_id_t, TxTableEntry> tx_table,
@@ -24,86 +24,47 @@ ChkptEndRecord::ChkptEndRecord(std::map<txn_id_t, TxTableEntry> tx_table,
 }
     
 ChkptEndRecord::ChkptEndRecord(Page *p) {
-    GetHeaderInfor(p);
+    LogDecoder decoder(p->GetRawDataPtr(), p->GetSize());
+    DeserializeHeader(&decoder);
     SIMPLEDB_ASSERT(type_ == LogRecordType::CHECKPOINTEND, "");
     
-    int addr = HEADER_SIZE;
-    int txn_table_size = p->GetInt(addr);
-    int txn_table_end = addr + txn_table_size;
-    int txn_table_entry_size = sizeof(int) + sizeof(lsn_t) + sizeof(int);
-
-    SIMPLEDB_ASSERT(txn_table_size % 4 == 0, "should not happen");
-
-    addr += sizeof(int);
-    for (;addr < txn_table_end; addr += txn_table_entry_size) {
-        int offset = 0;
-        int txn_id, tx_status;
-        lsn_t last_lsn;
-        
-        txn_id = p->GetInt(addr + offset);
-        offset += sizeof(int);
-        last_lsn = p->GetInt(addr + offset);
-        offset += sizeof(lsn_t);
-        tx_status = p->GetInt(addr + offset);
+    int txn_table_count = decoder.GetVarint();
+    for (int i = 0;i < txn_table_count;i ++) {
+        txn_id_t txn_id = decoder.GetSignedVarint();
+        lsn_t last_lsn = decoder.GetSignedVarint();
+        int tx_status = decoder.GetByte();
 
         txn_table_[txn_id] = TxTableEntry(last_lsn, 
                              static_cast<TxStatus> (tx_status));
     } 
     
-    int dp_table_size = p->GetInt(addr);
-    int dp_table_end = addr + dp_table_size;
-    int dp_table_entry_size;
-    
-    addr += sizeof(int);
-    for (;addr < dp_table_end; addr += dp_table_entry_size) {
-        std::string file_name;
-        int block_number;
-        lsn_t first_lsn;
-        dp_table_entry_size = 0;
-        
-        file_name = p->GetString(addr + dp_table_entry_size);
-        dp_table_entry_size += Page::MaxLength(file_name.size());
-        block_number = p->GetInt(addr + dp_table_entry_size);
-        dp_table_entry_size += sizeof(int);
-        first_lsn = p->GetInt(addr + dp_table_entry_size);
-        dp_table_entry_size += sizeof(lsn_t);
+    int dp_table_count = decoder.GetVarint();
+    for (int i = 0;i < dp_table_count;i ++) {
+        std::string file_name = decoder.GetString();
+        int block_number = decoder.GetSignedVarint();
+        lsn_t first_lsn = decoder.GetSignedVarint();
         
         dp_table_[BlockId(file_name, block_number)] = first_lsn;
     }
 }
 
 int ChkptEndRecord::RecordSize() {
-    int txn_entry_size;
-    int dp_entry_size;
-    int txn_table_size;
-    int dp_table_size;
-    int record_size;
-
-    // a txn_map_entry = integer + tx_table_entry
-    // entry format:
-    // | int | tx_table_entry.lsn | tx_table_entry.status |
-    // the size of entry is constant
-    txn_entry_size = sizeof(int) + sizeof(lsn_t) + sizeof(int);
-    // sizeof(int) means byte-array'ssize
-    txn_table_size = sizeof(int) + txn_entry_size * txn_table_.size();
-    
-    // a dp_map_entry = blockid + lsn_t
-    // entry format:
-    // | filename size | filename | int | lsn_t |
-    // the size of entry is not constant, we should dynamically calc
-    dp_entry_size = 0;
-    dp_table_size = 0; 
+    int record_size = HeaderSize();
 
-    for (auto t:dp_table_) {
-        dp_entry_size = Page::MaxLength(t.first.FileName().size()) +
-                        sizeof(int) +
-                        sizeof(lsn_t);
-        dp_table_size += dp_entry_size;
+    record_size += LogEncoder::VarintSize(txn_table_.size());
+    for (auto &t:txn_table_) {
+        record_size += LogEncoder::SignedVarintSize(t.first) + 
+                       LogEncoder::SignedVarintSize(t.second.last_lsn_) + 
+                       sizeof(uint8_t);
     }
 
-    dp_table_size += sizeof(int);
+    record_size += LogEncoder::VarintSize(dp_table_.size());
+    for (auto &t:dp_table_) {
+        record_size += LogEncoder::BytesSize(t.first.FileName().size()) +
+                       LogEncoder::SignedVarintSize(t.first.BlockNum()) +
+                       LogEncoder::SignedVarintSize(t.second);
+    }
 
-    record_size = HEADER_SIZE + txn_table_size + dp_table_size;
     return record_size;
 }
 
@@ -114,53 +75,25 @@ std::string ChkptEndRecord::ToString() {
     return header;
 }
 
-std::shared_ptr<std::vector<char>> ChkptEndRecord::Serializeto() {
-    int record_size = RecordSize();
-    auto p = GetHeaderPage(record_size);
-    int addr = HEADER_SIZE;
-    int txn_table_begin = addr;
-    int dp_table_begin;
+void ChkptEndRecord::WriteTo(char *buf) {
+    LogEncoder encoder(buf);
+    SerializeHeader(&encoder);
 
-    addr += sizeof(int);
-    for (auto t:txn_table_) {
-        int offset = 0;
-        int txn_id = t.first;
-        lsn_t last_lsn = t.second.last_lsn_;
-        TxStatus tx_status = t.second.status_;
-        
-        p.SetInt(addr + offset, txn_id);
-        offset += sizeof(int);
-        p.SetInt(addr + offset, last_lsn);
-        offset += sizeof(lsn_t);
-        p.SetInt(addr + offset, static_cast<int>(tx_status));
-        offset += sizeof(int);
-
-        addr += offset;
+    encoder.PutVarint(txn_table_.size());
+    for (auto &t:txn_table_) {
+        encoder.PutSignedVarint(t.first);
+        encoder.PutSignedVarint(t.second.last_lsn_);
+        encoder.PutByte(static_cast<uint8_t>(t.second.status_));
     }
 
-    p.SetInt(txn_table_begin, addr - txn_table_begin - sizeof(int));
-    
-    dp_table_begin = addr;
-    addr += sizeof(int);
-    for (auto t:dp_table_) {
-        int offset = 0;
-        std::string file_name = t.first.FileName();
-        int block_number = t.first.BlockNum();
-        lsn_t lsn = t.second;
-
-        p.SetString(addr + offset, file_name);
-        offset += Page::MaxLength(file_name.size());
-        p.SetInt(addr + offset, block_number);
-        offset += sizeof(int);
-        p.SetInt(addr + offset, lsn);
-        offset += sizeof(lsn_t);
-
-        addr += offset;
+    encoder.PutVarint(dp_table_.size());
+    for (auto &t:dp_table_) {
+        encoder.PutString(t.first.FileName());
+        encoder.PutSignedVarint(t.first.BlockNum());
+        encoder.PutSignedVarint(t.second);
     }
-    p.SetInt(dp_table_begin, addr - dp_table_begin - sizeof(int));
 
-    SIMPLEDB_ASSERT(record_size == addr, "");
-    return p.content();
+    SIMPLEDB_ASSERT(encoder.GetOffset() == RecordSize(), "");
 }
 
 std::string ChkptEndRecord::TxTableToString() {
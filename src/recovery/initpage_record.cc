@@ -15,17 +15,15 @@ namespace SimpleDB {
 */
 
 InitPageRecord::InitPageRecord(Page *p) {
-    GetHeaderInfor(p);
+    LogDecoder decoder(p->GetRawDataPtr(), p->GetSize());
+    DeserializeHeader(&decoder);
     SIMPLEDB_ASSERT(type_ == LogRecordType::INITPAGE, "");
+    int body_pos = decoder.GetOffset();
     
-    int file_pos = HEADER_SIZE;
-    int blk_num_pos;
-    
-    file_name_ = p->GetString(file_pos);
-    blk_num_pos = file_pos + Page::MaxLength(file_name_.size());
-    block_number_ = p->GetInt(blk_num_pos);
+    file_name_ = decoder.GetString();
+    block_number_ = decoder.GetSignedVarint();
 
-    record_size_ = blk_num_pos + sizeof(int);   
+    body_size_ = decoder.GetOffset() - body_pos;
 }
 
 InitPageRecord::InitPageRecord(txn_id_t txn, 
@@ -35,8 +33,8 @@ InitPageRecord::InitPageRecord(txn_id_t txn,
     txn_id_ = txn;
     type_ = LogRecordType::INITPAGE;
     
-    record_size_ = HEADER_SIZE + Page::MaxLength(file_name_.size()) +
-                   sizeof(int);
+    body_size_ = LogEncoder::BytesSize(file_name_.size()) +
+                 LogEncoder::SignedVarintSize(block_number_);
 }
 
 
@@ -47,16 +45,14 @@ std::string InitPageRecord::ToString() {
     return str;
 }
 
-std::shared_ptr<std::vector<char>> InitPageRecord::Serializeto() {
-    auto p = GetHeaderPage(record_size_);
-    
-    int file_pos = HEADER_SIZE;
-    int blk_num_pos = file_pos + Page::MaxLength(file_name_.size());
+void InitPageRecord::WriteTo(char *buf) {
+    LogEncoder encoder(buf);
+    SerializeHeader(&encoder);
     
-    p.SetString(file_pos, file_name_);
-    p.SetInt(blk_num_pos, block_number_);
+    encoder.PutString(file_name_);
+    encoder.PutSignedVarint(block_number_);
 
-    return p.content();
+    SIMPLEDB_ASSERT(encoder.GetOffset() == RecordSize(), "");
 }
 
 
@@ -14,29 +14,21 @@ namespace SimpleDB {
 */
 
 InsertRecord::InsertRecord(Page *p) {
-    GetHeaderInfor(p);
+    LogDecoder decoder(p->GetRawDataPtr(), p->GetSize());
+    DeserializeHeader(&decoder);
     SIMPLEDB_ASSERT(type_ == LogRecordType::INSERT, "");
-
-    int addr = HEADER_SIZE;
-    int file_pos = addr;
-    int rid_pos;
-    int tuple_pos;
-    int rid_x, rid_y;
-    std::vector<char> data;
+    int body_pos = decoder.GetOffset();
 
     // get file_name
-    file_name_ = p->GetString(file_pos);
+    file_name_ = decoder.GetString();
     // get rid
-    rid_pos = file_pos + Page::MaxLength(file_name_.size());
-    rid_x = p->GetInt(rid_pos);
-    rid_y = p->GetInt(rid_pos + sizeof(int));
+    int rid_x = decoder.GetSignedVarint();
+    int rid_y = decoder.GetSignedVarint();
     rid_ = RID(rid_x, rid_y);
     // get tuple
-    tuple_pos = rid_pos + 2 * sizeof(int);
-    data = p->GetBytes(tuple_pos);
-    tuple_ = Tuple(data);
+    tuple_ = Tuple(decoder.GetBytes());
 
-    record_size_ = tuple_pos + Page::MaxLength(tuple_.GetSize());
+    body_size_ = decoder.GetOffset() - body_pos;
 }
 
 InsertRecord::InsertRecord(txn_id_t txn, 
@@ -48,9 +40,10 @@ InsertRecord::InsertRecord(txn_id_t txn,
     txn_id_ = txn;
     type_ = LogRecordType::INSERT;
 
-    record_size_ = HEADER_SIZE + Page::MaxLength(file_name_.size()) + 
-                   2 * sizeof(int) + 
-                   Page::MaxLength(tuple_.GetSize());
+    body_size_ = LogEncoder::BytesSize(file_name_.size()) + 
+                 LogEncoder::SignedVarintSize(rid_.GetBlockNum()) + 
+                 LogEncoder::SignedVarintSize(rid_.GetSlot()) + 
+                 LogEncoder::BytesSize(tuple_.GetSize());
 }
 
 
@@ -62,26 +55,19 @@ std::string InsertRecord::ToString() {
     return str;
 }
 
-std::shared_ptr<std::vector<char>> InsertRecord::Serializeto() {
-    auto p = GetHeaderPage(record_size_);
-    int addr = HEADER_SIZE;
-    int file_pos = addr;
-    int rid_pos;
-    int tuple_pos;
-    std::vector<char> data;
+void InsertRecord::WriteTo(char *buf) {
+    LogEncoder encoder(buf);
+    SerializeHeader(&encoder);
 
     // set file_name
-    p.SetString(file_pos, file_name_);
+    encoder.PutString(file_name_);
     // set rid
-    rid_pos = file_pos + Page::MaxLength(file_name_.size());
-    p.SetInt(rid_pos, rid_.GetBlockNum());
-    p.SetInt(rid_pos + sizeof(int), rid_.GetSlot());
+    encoder.PutSignedVarint(rid_.GetBlockNum());
+    encoder.PutSignedVarint(rid_.GetSlot());
     // set tuple
-    tuple_pos = rid_pos + 2 * sizeof(int);
-    p.SetBytes(tuple_pos, *tuple_.GetData());
+    encoder.PutBytes(tuple_.GetDataPtr(), tuple_.GetSize());
 
-    
-    return p.content();
+    SIMPLEDB_ASSERT(encoder.GetOffset() == RecordSize(), "");
 }
 
 
@@ -6,51 +6,74 @@
 
 namespace SimpleDB {
 
-Page LogRecord::GetHeaderPage(int record_size) {
-    int lsn_pos = 0;
-    int txn_pos = sizeof(lsn_t);
-    int prev_lsn_pos = txn_pos + sizeof(txn_id_t);
-    int logtype_pos = prev_lsn_pos + sizeof(lsn_t);
-    int clr_pos = logtype_pos + sizeof(LogRecordType);
-    int undo_next_pos = clr_pos + sizeof(int);
-
-    std::shared_ptr<std::vector<char>> array = 
-            std::make_shared<std::vector<char>> (record_size);
-    Page p(array);
-    
-    p.SetInt(lsn_pos, lsn_);
-    p.SetInt(txn_pos, txn_id_);
-    p.SetInt(prev_lsn_pos, prev_lsn_);
-    p.SetInt(logtype_pos, static_cast<int>(type_));
-    p.SetInt(clr_pos, is_clr_);
-    p.SetInt(undo_next_pos, undo_next_);
-    return p;
+int LogRecord::HeaderSize() {
+    int size = sizeof(uint8_t) + 
+               LogEncoder::SignedVarintSize(lsn_) + 
+               LogEncoder::SignedVarintSize(txn_id_);
+    if (prev_lsn_ != INVALID_LSN) {
+        size += LogEncoder::SignedVarintSize(static_cast<int64_t>(lsn_) - prev_lsn_);
+    }
+    if (undo_next_ != INVALID_LSN) {
+        size += LogEncoder::SignedVarintSize(static_cast<int64_t>(lsn_) - undo_next_);
+    }
+    return size;
 }
 
 
-void LogRecord::GetHeaderInfor(Page *p) {
-    int lsn_pos = 0;
-    int txn_pos = sizeof(lsn_t);
-    int prev_lsn_pos = txn_pos + sizeof(txn_id_t);
-    int logtype_pos = prev_lsn_pos + sizeof(lsn_t);
-    int clr_pos = logtype_pos + sizeof(LogRecordType);
-    int undo_next_pos = clr_pos + sizeof(int);
-
-    lsn_ = p->GetInt(lsn_pos);
-    txn_id_ = p->GetInt(txn_pos);
-    prev_lsn_ = p->GetInt(prev_lsn_pos);
-    type_ = static_cast<LogRecordType>(p->GetInt(logtype_pos));
-    is_clr_ = p->GetInt(clr_pos);
-    undo_next_ = p->GetInt(undo_next_pos);
+void LogRecord::SerializeHeader(LogEncoder *encoder) {
+    SIMPLEDB_ASSERT((static_cast<int>(type_) & ~TYPE_MASK) == 0, "invalid log type");
+
+    uint8_t flags = static_cast<uint8_t>(type_);
+    if (is_clr_) {
+        flags |= CLR_FLAG;
+    }
+    if (prev_lsn_ != INVALID_LSN) {
+        flags |= PREV_LSN_FLAG;
+    }
+    if (undo_next_ != INVALID_LSN) {
+        flags |= UNDO_NEXT_FLAG;
+    }
+
+    encoder->PutByte(flags);
+    encoder->PutSignedVarint(lsn_);
+    encoder->PutSignedVarint(txn_id_);
+    if (prev_lsn_ != INVALID_LSN) {
+        encoder->PutSignedVarint(static_cast<int64_t>(lsn_) - prev_lsn_);
+    }
+    if (undo_next_ != INVALID_LSN) {
+        encoder->PutSignedVarint(static_cast<int64_t>(lsn_) - undo_next_);
+    }
+}
+
+
+void LogRecord::DeserializeHeader(LogDecoder *decoder) {
+    uint8_t flags = decoder->GetByte();
+    type_ = static_cast<LogRecordType>(flags & TYPE_MASK);
+    is_clr_ = (flags & CLR_FLAG) != 0;
+    lsn_ = decoder->GetSignedVarint();
+    txn_id_ = decoder->GetSignedVarint();
+    prev_lsn_ = INVALID_LSN;
+    undo_next_ = INVALID_LSN;
+    if (flags & PREV_LSN_FLAG) {
+        prev_lsn_ = lsn_ - decoder->GetSignedVarint();
+    }
+    if (flags & UNDO_NEXT_FLAG) {
+        undo_next_ = lsn_ - decoder->GetSignedVarint();
+    }
 }
 
 std::shared_ptr<LogRecord> LogRecord::DeserializeFrom
 (const std::vector<char> &byte_array) {
+    if (byte_array.empty()) {
+        return nullptr;
+    }
+
     auto vector_ptr = std::make_shared<std::vector<char>> (byte_array);      
     Page page(vector_ptr);
     
+    // the log type is in the first byte of header
     LogRecordType type = static_cast<LogRecordType> 
-                            (page.GetInt(0 + 2 * sizeof(lsn_t) + sizeof(txn_id_t)));
+                            (static_cast<uint8_t>(byte_array[0]) & TYPE_MASK);
                             
     switch(type) {
     case LogRecordType::INSERT:
@@ -99,55 +122,50 @@ std::shared_ptr<LogRecord> LogRecord::DeserializeFrom
 
 
 
-std::shared_ptr<std::vector<char>> ChkptBeginRecord::Serializeto() {
-    auto page = GetHeaderPage(HEADER_SIZE);
-
-    return page.content();
+void ChkptBeginRecord::WriteTo(char *buf) {
+    LogEncoder encoder(buf);
+    SerializeHeader(&encoder);
 }
 
 
 //////////////////////////////////////////// Begin Transaction record ///////////////////////////////////////////////////
 
-std::shared_ptr<std::vector<char>> BeginRecord::Serializeto() {
-    auto page = GetHeaderPage(HEADER_SIZE);
+void BeginRecord::WriteTo(char *buf) {
+    LogEncoder encoder(buf);
+    SerializeHeader(&encoder);
 
     // should not undo
     SIMPLEDB_ASSERT(undo_next_ == INVALID_LSN, "");
-
-    return page.content();
 } 
 
-std::shared_ptr<std::vector<char>> CommitRecord::Serializeto() {
-    auto page = GetHeaderPage(HEADER_SIZE);
+void CommitRecord::WriteTo(char *buf) {
+    LogEncoder encoder(buf);
+    SerializeHeader(&encoder);
     
     // should have prev record
     SIMPLEDB_ASSERT(prev_lsn_ != INVALID_LSN, "");
     // should not undo
     SIMPLEDB_ASSERT(undo_next_ == INVALID_LSN, "");
-
-    return page.content();
 }
 
 
-std::shared_ptr<std::vector<char>> AbortRecord::Serializeto() {
-    auto page = GetHeaderPage(HEADER_SIZE);
+void AbortRecord::WriteTo(char *buf) {
+    LogEncoder encoder(buf);
+    SerializeHeader(&encoder);
 
     // should have prev record
     SIMPLEDB_ASSERT(prev_lsn_ != INVALID_LSN, "");
     // should not record
     SIMPLEDB_ASSERT(undo_next_ == INVALID_LSN, "");
-
-    return page.content();
 }
 
 
-std::shared_ptr<std::vector<char>> TxnEndRecord::Serializeto() {
-    auto page = GetHeaderPage(HEADER_SIZE);
+void TxnEndRecord::WriteTo(char *buf) {
+    LogEncoder encoder(buf);
+    SerializeHeader(&encoder);
 
     // should have prev record
     //SIMPLEDB_ASSERT(prev_lsn_ != INVALID_LSN, "");
-
-    return page.content();
 }
 
 
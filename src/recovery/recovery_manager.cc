@@ -9,6 +9,7 @@
 #include <set>
 #include <iostream>
 #include <queue>
+#include <vector>
 
 namespace SimpleDB
 {
@@ -17,7 +18,7 @@ RecoveryManager::RecoveryManager(LogManager *lm) : log_manager_(lm) {}
 
 void RecoveryManager::Begin(Transaction *txn) {
     
-    int log_offset;
+    log_offset_t log_offset;
     txn_id_t txn_id = txn->GetTxnID();
     lsn_t last_lsn;
 
@@ -29,6 +30,9 @@ void RecoveryManager::Begin(Transaction *txn) {
     SetTxTableEntry(txn_id, TxTableEntry(last_lsn, TxStatus::U));
     // update lsn_map_
     InsertLsnMap(last_lsn, log_offset);
+
+    std::lock_guard<std::mutex> latch(latch_);
+    begin_lsn_[txn_id] = last_lsn;
 }
 
 void RecoveryManager::Commit(Transaction *txn) {
@@ -45,7 +49,13 @@ void RecoveryManager::Commit(Transaction *txn) {
 
     // flush the lsn immediately
     // no need to update lsn_map_ and txn_map
-    log_manager_->Flush(last_lsn);
+    if (txn->IsAsyncCommit()) {
+        // the log is flushed in order, so a txn which commits later
+        // and depends on this txn never survives a crash without it
+        log_manager_->FlushAsync(last_lsn);
+    } else {
+        log_manager_->Flush(last_lsn);
+    }
 
     // 2. write the txn-end log after commit log immediately
     TxnEnd(txn_id);
@@ -59,7 +69,7 @@ void RecoveryManager::Abort(Transaction *txn) {
     
     // not need to flush buffer immediately
     // and not need to flush log immediately
-    int offset;
+    log_offset_t offset;
     txn_id_t txn_id = txn->GetTxnID();
     lsn_t last_lsn = GetLastLsn(txn_id);
 
@@ -85,17 +95,108 @@ void RecoveryManager::Abort(Transaction *txn) {
 
 
 void RecoveryManager::CheckPoint() {
-    int offset;
+    // the cleaned blocks are pruned by the checkpoint which took them,
+    // so two checkpoints can't run at the same time
+    std::lock_guard<std::mutex> chkpt_latch(chkpt_latch_);
+    log_offset_t offset;
     auto chkpt_begin = ChkptBeginRecord();
     lsn_t prev_lsn = log_manager_->AppendLogRecord(chkpt_begin);
-    auto chkpt_end = ChkptEndRecord(tx_table_, dp_table_);
+
+    // take the tables together, the log they need is kept by truncation
+    std::map<txn_id_t, TxTableEntry> tx_table;
+    std::map<BlockId, lsn_t> dp_table;
+    std::map<txn_id_t, lsn_t> begin_lsn;
+    std::vector<BlockId> cleaned_blocks;
+    {
+        std::lock_guard<std::mutex> latch(latch_);
+        tx_table = tx_table_;
+        dp_table = dp_table_;
+        begin_lsn = begin_lsn_;
+        for (auto &t : cleaned_blocks_) {
+            cleaned_blocks.push_back(t.first);
+        }
+    }
+
+    auto chkpt_end = ChkptEndRecord(tx_table, dp_table);
     
     chkpt_end.SetPrevLSN(prev_lsn);
     prev_lsn = log_manager_->AppendLogWithOffset(chkpt_end, &offset);
 
-    // flush to disk
-    log_manager_->SetMasterLsnOffset(offset);
+    // flush to disk, the checkpoint record should be
+    // in log file before master record points to it
     log_manager_->Flush(prev_lsn);
+    log_manager_->SetMasterLsnOffset(offset);
+
+    // the blocks cleaned before syncing files are durable now
+    {
+        std::lock_guard<std::mutex> latch(latch_);
+        for (auto &block : cleaned_blocks) {
+            auto iter = cleaned_blocks_.find(block);
+            if (iter == cleaned_blocks_.end()) {
+                continue;
+            }
+            if (iter->second == INVALID_LSN) {
+                dp_table_.erase(block);
+            } else {
+                dp_table_[block] = iter->second;
+            }
+            cleaned_blocks_.erase(iter);
+        }
+    }
+
+    // the segments before the oldest needed log can be recycled
+    log_offset_t truncate_offset = GetOldestNeededOffset(offset, tx_table, dp_table, begin_lsn);
+    if (truncate_offset != -1) {
+        log_manager_->Truncate(truncate_offset);
+    }
+}
+
+
+log_offset_t RecoveryManager::GetOldestNeededOffset(log_offset_t chkpt_offset, 
+                                                    const std::map<txn_id_t, TxTableEntry> &tx_table,
+                                                    const std::map<BlockId, lsn_t> &dp_table,
+                                                    const std::map<txn_id_t, lsn_t> &begin_lsn) {
+    std::lock_guard<std::mutex> latch(latch_);
+    log_offset_t offset = chkpt_offset;
+    
+    auto update_offset = [&](lsn_t lsn) {
+        auto iter = lsn_map_.find(lsn);
+        if (iter == lsn_map_.end()) {
+            return false;
+        }
+        offset = std::min(offset, iter->second);
+        return true;
+    };
+
+    // both the tables in checkpoint and the current tables are 
+    // considered, since entries may be removed after the checkpoint
+
+    // redo starts from the earliest lsn of dirty pages
+    const std::map<BlockId, lsn_t> *dp_tables[] = {&dp_table, &dp_table_};
+    for (auto *table : dp_tables) {
+        for (auto &t : *table) {
+            if (!update_offset(t.second)) {
+                return -1;
+            }
+        }
+    }
+
+    // undo goes back to the begin of active transactions
+    const std::map<txn_id_t, TxTableEntry> *tx_tables[] = {&tx_table, &tx_table_};
+    for (auto *table : tx_tables) {
+        for (auto &t : *table) {
+            lsn_t lsn = INVALID_LSN;
+            if (begin_lsn.find(t.first) != begin_lsn.end()) {
+                lsn = begin_lsn.at(t.first);
+            } else if (begin_lsn_.find(t.first) != begin_lsn_.end()) {
+                lsn = begin_lsn_.at(t.first);
+            }
+            if (lsn == INVALID_LSN || !update_offset(lsn)) {
+                return -1;
+            }
+        }
+    }
+    return offset;
 }
 
 
@@ -105,7 +206,7 @@ lsn_t RecoveryManager::InsertLogRec(Transaction *txn,
                                     const Tuple &tuple,
                                     bool is_clr) {
     
-    int offset;
+    log_offset_t offset;
     txn_id_t txn_id = txn->GetTxnID();
     lsn_t last_lsn = GetLastLsn(txn_id);
     BlockId block(file_name, rid.GetBlockNum());
@@ -134,7 +235,7 @@ lsn_t RecoveryManager::DeleteLogRec(Transaction *txn,
                                     const Tuple &tuple,
                                     bool is_clr) {
     
-    int offset;
+    log_offset_t offset;
     txn_id_t txn_id = txn->GetTxnID();
     lsn_t last_lsn = GetLastLsn(txn_id);
     BlockId block(file_name, rid.GetBlockNum());
@@ -165,7 +266,7 @@ lsn_t RecoveryManager::UpdateLogRec(Transaction *txn,
                                     bool is_clr) {
     
     // update is same to insert and delete
-    int offset;
+    log_offset_t offset;
     txn_id_t txn_id = txn->GetTxnID();
     lsn_t last_lsn = GetLastLsn(txn_id);
     BlockId block(file_name, rid.GetBlockNum());
@@ -194,7 +295,7 @@ lsn_t RecoveryManager::InitPageLogRec(Transaction *txn,
                                       int block_numer,
                                       bool is_clr) {
     
-    int offset;
+    log_offset_t offset;
     txn_id_t txn_id = txn->GetTxnID();
     lsn_t last_lsn = GetLastLsn(txn_id);
     BlockId block(file_name, block_numer);
@@ -219,13 +320,14 @@ lsn_t RecoveryManager::InitPageLogRec(Transaction *txn,
 
 void RecoveryManager::FlushBlock(BlockId block, lsn_t lsn) {
     log_manager_->Flush(lsn);
-    
-    // SIMPLEDB_ASSERT(lsn >= GetEarlistLsn(block), "logic error");
+}
 
-    
-    // bacause we have written the block to disk, the block isn't dirty
-    // so we should erase it from dp_table_
-    RemoveEarlistLsn(block);
+void RecoveryManager::BlockCleaned(const BlockId &block) {
+    // the write is not synced, if we erased the block from dp_table_
+    // now, a crash may lose the block and redo would skip its logs.
+    // so it's erased by the checkpoint after syncing files
+    std::lock_guard<std::mutex> latch(latch_);
+    cleaned_blocks_.emplace(block, INVALID_LSN);
 }
 
 
@@ -249,7 +351,7 @@ void RecoveryManager::DoRollBack(Transaction *txn) {
     while (toUndo.size())
     {   
         
-        int offset;
+        log_offset_t offset;
         lsn_t lsn = toUndo.top();
         toUndo.pop();
 
@@ -352,12 +454,10 @@ void RecoveryManager::DoRollBack(Transaction *txn) {
         {
             UpdateRecord *log = dynamic_cast<UpdateRecord *>(log_record.get());
             std::string file_name = log->GetFileName();
-            Tuple old_tuple = log->GetOldTuple();
-            Tuple new_tuple = log->GetNewTuple();
             RID rid = log->GetRID();
 
             // 1. write clr to disk
-            auto clr_record = std::make_shared<UpdateRecord>(txn_id, file_name, rid, new_tuple, old_tuple);
+            auto clr_record = log->ReverseRecord(txn_id);
             clr_record->SetCLR(true);
             clr_record->SetPrevLSN(last_lsn);
             clr_record->SetUndoNext(prev_lsn);
@@ -429,7 +529,7 @@ void RecoveryManager::DoAnalyze() {
     //    (2) update dp_table 's earliest_lsn
     
     // 1. get the lastest checkpoint log record
-    int chkpt_offset = log_manager_->GetMasterLsnOffset();
+    log_offset_t chkpt_offset = log_manager_->GetMasterLsnOffset();
     auto log_iter = log_manager_->Iterator();
    
     // 2. get txn_table and dp_table
@@ -657,7 +757,7 @@ void RecoveryManager::DoUndo(Transaction *txn) {
     }
 
     while (toUndo.size()) {
-        int offset;
+        log_offset_t offset;
         lsn_t lsn = toUndo.top();
         toUndo.pop();
 
@@ -768,12 +868,10 @@ void RecoveryManager::DoUndo(Transaction *txn) {
             {   
                 UpdateRecord *log = dynamic_cast<UpdateRecord *>(log_record.get());
                 std::string file_name = log->GetFileName();
-                Tuple old_tuple = log->GetOldTuple();
-                Tuple new_tuple = log->GetNewTuple();
                 RID rid = log->GetRID();
 
                 // 1. write clr log to disk, set the information of clr log
-                auto clr_record = std::make_shared<UpdateRecord>(txn_id, file_name, rid, new_tuple, old_tuple);
+                auto clr_record = log->ReverseRecord(txn_id);
                 clr_record->SetCLR(true);
                 clr_record->SetPrevLSN(last_lsn);
                 clr_record->SetUndoNext(prev_lsn);
@@ -833,6 +931,8 @@ void RecoveryManager::TxnEnd(txn_id_t txn_id) {
     log_manager_->AppendLogRecord(txn_end_record);
 
     RemoveTableEntry(txn_id);
+    std::lock_guard<std::mutex> latch(latch_);
+    begin_lsn_.erase(txn_id);
 }
 
 
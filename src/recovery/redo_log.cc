@@ -40,7 +40,7 @@ void RecoveryManager::RedoLog(Transaction *txn, LogRecord *log) {
         }
 
 
-        auto block2 = file_manager->Append(block.FileName());
+        [[maybe_unused]] auto block2 = file_manager->Append(block.FileName());
         SIMPLEDB_ASSERT(block == block2, "should equal");
 
         // acquire resource
@@ -118,8 +118,6 @@ void RecoveryManager::RedoLog(Transaction *txn, LogRecord *log) {
         auto log_record = static_cast<UpdateRecord*>(log);
         auto block = BlockId(log_record->GetFileName(), log_record->GetRID().GetBlockNum());
         auto rid = log_record->GetRID();
-        auto old_tuple = log_record->GetOldTuple();
-        auto new_tuple = log_record->GetNewTuple();
 
         // acquire resource
         Buffer *buffer = txn->PinBlock(block);
@@ -128,10 +126,16 @@ void RecoveryManager::RedoLog(Transaction *txn, LogRecord *log) {
         table_page->WLock();
         // check if need to redo
         if (table_page->GetPageLsn() < log_record->GetLsn()) {
+            // the page has the old tuple, apply the changed bytes to it
             Tuple tuple;
+            if (!table_page->GetTuple(rid, &tuple)) {
+                table_page->WUnlock();
+                txn->UnpinBlock(block);
+                throw std::runtime_error("can't find the tuple to redo " + rid.ToString());
+            }
+            auto new_tuple = log_record->GetNewTuple(tuple);
             table_page->Update(rid, &tuple, new_tuple);
             table_page->SetPageLsn(log_record->GetLsn());
-            assert(old_tuple == tuple);
         }
 
         // release resource
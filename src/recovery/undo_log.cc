@@ -103,8 +103,6 @@ void RecoveryManager::UndoLog(Transaction *txn, LogRecord *log, lsn_t undo_lsn)
         auto log_record = static_cast<UpdateRecord*>(log);
         auto block = BlockId(log_record->GetFileName(), log_record->GetRID().GetBlockNum());
         auto rid = log_record->GetRID();
-        auto old_tuple = log_record->GetOldTuple();
-        auto new_tuple = log_record->GetNewTuple();
 
         // acquire resource
         Buffer *buffer = txn->PinBlock(block);
@@ -114,10 +112,18 @@ void RecoveryManager::UndoLog(Transaction *txn, LogRecord *log, lsn_t undo_lsn)
         // if pagelsn < lsn, i think it's a logic error
         assert(table_page->GetPageLsn() >= log_record->GetLsn());
         
-        // undo
+        // undo, the log only has the changed bytes, so the old
+        // tuple is built from the new tuple in page
         Tuple tuple;
-        bool res = table_page->Update(rid, &tuple, old_tuple);
-        SIMPLEDB_ASSERT(res == true && new_tuple == tuple, "logic error");
+        bool res = table_page->GetTuple(rid, &tuple);
+        if (!res) {
+            table_page->WUnlock();
+            txn->UnpinBlock(block);
+            throw std::runtime_error("can't find the tuple to undo " + rid.ToString());
+        }
+        auto old_tuple = log_record->GetOldTuple(tuple);
+        res = table_page->Update(rid, &tuple, old_tuple);
+        SIMPLEDB_ASSERT(res == true, "logic error");
         table_page->SetPageLsn(undo_lsn);
 
         // release resource
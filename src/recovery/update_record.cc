@@ -5,44 +5,50 @@
 #include "record/table_page.h"
 #include "concurrency/transaction.h"
 
+#include <algorithm>
+
 namespace SimpleDB {
 
 /**
 * For Update
-* -----------------------------------------------------------------------------------------------------------------
-* | Header | FileName.size() | FileName | RID | Old Tuple size | Old Tuple Data | New Tuple size | New Tuple Data |
-* -----------------------------------------------------------------------------------------------------------------
+* ----------------------------------------------------------------------------------------------
+* | Header | FileName.size() | FileName | RID | Old Tuple size | New Tuple size | Range count | 
+* ----------------------------------------------------------------------------------------------
+* every range is 
+* ---------------------------------------------------------------------
+* | Gap | Old Data size | Old Data | New Data size | New Data |
+* ---------------------------------------------------------------------
 */
 
+// starting a new range costs 3 bytes (gap and two sizes), a shorter 
+// unchanged gap is cheaper to be stored twice inside the range
+static constexpr int MIN_RANGE_GAP = 4;
+
 UpdateRecord::UpdateRecord(Page *p) {
-    GetHeaderInfor(p);
+    LogDecoder decoder(p->GetRawDataPtr(), p->GetSize());
+    DeserializeHeader(&decoder);
     SIMPLEDB_ASSERT(type_ == LogRecordType::UPDATE, "");
-
-    int addr = HEADER_SIZE;
-    int file_pos = addr;
-    int rid_pos;
-    int old_tuple_pos;
-    int new_tuple_pos;
-    int rid_x, rid_y;
-    std::vector<char> data;
+    int body_pos = decoder.GetOffset();
 
     // get file_name
-    file_name_ = p->GetString(file_pos);
+    file_name_ = decoder.GetString();
     // get rid
-    rid_pos = file_pos + Page::MaxLength(file_name_.size());
-    rid_x = p->GetInt(rid_pos);
-    rid_y = p->GetInt(rid_pos + sizeof(int));
+    int rid_x = decoder.GetSignedVarint();
+    int rid_y = decoder.GetSignedVarint();
     rid_ = RID(rid_x, rid_y);
-    // get old tuple
-    old_tuple_pos = rid_pos + 2 * sizeof(int);
-    data = p->GetBytes(old_tuple_pos);
-    old_tuple_ = Tuple(data);
-    // get new tuple
-    new_tuple_pos = old_tuple_pos + Page::MaxLength(old_tuple_.GetSize());
-    data = p->GetBytes(new_tuple_pos);
-    new_tuple_ = Tuple(data);
-
-    record_size_ = new_tuple_pos + Page::MaxLength(new_tuple_.GetSize());
+    // get tuple sizes
+    old_size_ = decoder.GetVarint();
+    new_size_ = decoder.GetVarint();
+    // get changed ranges
+    int range_count = decoder.GetVarint();
+    ranges_.resize(range_count);
+    for (auto &range : ranges_) {
+        range.gap_ = decoder.GetVarint();
+        range.old_data_ = decoder.GetBytes();
+        range.new_data_ = decoder.GetBytes();
+    }
+
+    body_size_ = decoder.GetOffset() - body_pos;
 }
 
 UpdateRecord::UpdateRecord(txn_id_t txn, 
@@ -50,15 +56,86 @@ UpdateRecord::UpdateRecord(txn_id_t txn,
                            const RID &rid,
                            const Tuple &old_tuple,
                            const Tuple &new_tuple) 
-    : LogRecord(), file_name_(file_name), 
-      rid_(rid), old_tuple_(old_tuple), new_tuple_(new_tuple) {
+    : LogRecord(), file_name_(file_name), rid_(rid),
+      old_size_(old_tuple.GetSize()), new_size_(new_tuple.GetSize()) {
     txn_id_ = txn;
     type_ = LogRecordType::UPDATE;
 
-    record_size_ = HEADER_SIZE + Page::MaxLength(file_name_.size()) + 
-                   2 * sizeof(int) + 
-                   Page::MaxLength(old_tuple_.GetSize()) +
-                   Page::MaxLength(new_tuple_.GetSize());
+    const char *old_data = old_tuple.GetDataPtr();
+    const char *new_data = new_tuple.GetDataPtr();
+    int min_size = std::min(old_size_, new_size_);
+
+    if (old_size_ != new_size_) {
+        // the bytes after a resized field are shifted, so only 
+        // the common prefix and suffix are left out
+        int prefix = 0;
+        while (prefix < min_size && old_data[prefix] == new_data[prefix]) {
+            prefix ++;
+        }
+        int suffix = 0;
+        while (suffix < min_size - prefix && 
+               old_data[old_size_ - suffix - 1] == new_data[new_size_ - suffix - 1]) {
+            suffix ++;
+        }
+
+        ranges_.push_back({prefix, 
+            std::vector<char>(old_data + prefix, old_data + old_size_ - suffix),
+            std::vector<char>(new_data + prefix, new_data + new_size_ - suffix)});
+    } else {
+        // every run of changed bytes is a range, unless 
+        // the gap between two runs is too short
+        int last_end = 0;
+        int i = 0;
+        while (i < min_size) {
+            if (old_data[i] == new_data[i]) {
+                i ++;
+                continue;
+            }
+
+            int begin = i;
+            int end = i + 1;
+            for (int j = end;j < min_size;j ++) {
+                if (old_data[j] != new_data[j]) {
+                    end = j + 1;
+                } else if (j - end + 1 >= MIN_RANGE_GAP) {
+                    break;
+                }
+            }
+
+            ranges_.push_back({begin - last_end, 
+                std::vector<char>(old_data + begin, old_data + end),
+                std::vector<char>(new_data + begin, new_data + end)});
+            last_end = end;
+            i = end;
+        }
+    }
+
+    CalcBodySize();
+}
+
+
+Tuple UpdateRecord::GetNewTuple(const Tuple &old_tuple) {
+    return ApplyRanges(old_tuple, true);
+}
+
+Tuple UpdateRecord::GetOldTuple(const Tuple &new_tuple) {
+    return ApplyRanges(new_tuple, false);
+}
+
+std::shared_ptr<UpdateRecord> UpdateRecord::ReverseRecord(txn_id_t txn) {
+    auto record = std::make_shared<UpdateRecord>();
+    record->txn_id_ = txn;
+    record->type_ = LogRecordType::UPDATE;
+    record->file_name_ = file_name_;
+    record->rid_ = rid_;
+    record->old_size_ = new_size_;
+    record->new_size_ = old_size_;
+    for (auto &range : ranges_) {
+        record->ranges_.push_back({range.gap_, range.new_data_, range.old_data_});
+    }
+
+    record->CalcBodySize();
+    return record;
 }
 
 
@@ -66,34 +143,88 @@ std::string UpdateRecord::ToString() {
     std::string str = GetHeaderToString();
     str += "file_name = " + file_name_ 
         +  rid_.ToString() + " "
-        + "old_tuple = " + old_tuple_.ToString() + " "
-        + "new_tuple = " + new_tuple_.ToString();
+        + "old_size = " + std::to_string(old_size_) + " "
+        + "new_size = " + std::to_string(new_size_);
+    for (auto &range : ranges_) {
+        str += " [gap = " + std::to_string(range.gap_) + " "
+            +  "old = " + std::string(range.old_data_.begin(), range.old_data_.end()) + " "
+            +  "new = " + std::string(range.new_data_.begin(), range.new_data_.end()) + "]";
+    }
     return str;
 }
 
-std::shared_ptr<std::vector<char>> UpdateRecord::Serializeto() {
-    auto p = GetHeaderPage(record_size_);
-    int addr = HEADER_SIZE;
-    int file_pos = addr;
-    int rid_pos;
-    int old_tuple_pos;
-    int new_tuple_pos;
-    std::vector<char> data;
+void UpdateRecord::WriteTo(char *buf) {
+    LogEncoder encoder(buf);
+    SerializeHeader(&encoder);
 
     // set file_name
-    p.SetString(file_pos, file_name_);
+    encoder.PutString(file_name_);
     // set rid
-    rid_pos = file_pos + Page::MaxLength(file_name_.size());
-    p.SetInt(rid_pos, rid_.GetBlockNum());
-    p.SetInt(rid_pos + sizeof(int), rid_.GetSlot());
-    // set old tuple
-    old_tuple_pos = rid_pos + 2 * sizeof(int);
-    p.SetBytes(old_tuple_pos, *old_tuple_.GetData());
-    // set new tuple
-    new_tuple_pos = old_tuple_pos + Page::MaxLength(old_tuple_.GetSize());
-    p.SetBytes(new_tuple_pos, *new_tuple_.GetData());
-
-    return p.content();
+    encoder.PutSignedVarint(rid_.GetBlockNum());
+    encoder.PutSignedVarint(rid_.GetSlot());
+    // set tuple sizes
+    encoder.PutVarint(old_size_);
+    encoder.PutVarint(new_size_);
+    // set changed ranges
+    encoder.PutVarint(ranges_.size());
+    for (auto &range : ranges_) {
+        encoder.PutVarint(range.gap_);
+        encoder.PutBytes(range.old_data_.data(), range.old_data_.size());
+        encoder.PutBytes(range.new_data_.data(), range.new_data_.size());
+    }
+
+    SIMPLEDB_ASSERT(encoder.GetOffset() == RecordSize(), "");
+}
+
+
+void UpdateRecord::CalcBodySize() {
+    body_size_ = LogEncoder::BytesSize(file_name_.size()) + 
+                 LogEncoder::SignedVarintSize(rid_.GetBlockNum()) + 
+                 LogEncoder::SignedVarintSize(rid_.GetSlot()) + 
+                 LogEncoder::VarintSize(old_size_) + 
+                 LogEncoder::VarintSize(new_size_) + 
+                 LogEncoder::VarintSize(ranges_.size());
+    for (auto &range : ranges_) {
+        body_size_ += LogEncoder::VarintSize(range.gap_) + 
+                      LogEncoder::BytesSize(range.old_data_.size()) + 
+                      LogEncoder::BytesSize(range.new_data_.size());
+    }
+}
+
+Tuple UpdateRecord::ApplyRanges(const Tuple &tuple, bool redo) {
+    // the log only has the changed bytes, so a tuple which doesn't match
+    // the log can't be repaired. these checks must survive release builds,
+    // otherwise we would read past the tuple and write garbage to the page
+    int src_size = redo ? old_size_ : new_size_;
+    if (tuple.GetSize() != src_size) {
+        throw std::runtime_error("the tuple doesn't match the update log");
+    }
+
+    const char *src = tuple.GetDataPtr();
+    std::vector<char> data;
+    data.reserve(redo ? new_size_ : old_size_);
+
+    int pos = 0;
+    for (auto &range : ranges_) {
+        auto &from = redo ? range.old_data_ : range.new_data_;
+        auto &to = redo ? range.new_data_ : range.old_data_;
+        
+        if (range.gap_ < 0 || pos + range.gap_ > src_size) {
+            throw std::runtime_error("the tuple doesn't match the update log");
+        }
+        data.insert(data.end(), src + pos, src + pos + range.gap_);
+        pos += range.gap_;
+        
+        if (pos + static_cast<int>(from.size()) > src_size ||
+            memcmp(src + pos, from.data(), from.size()) != 0) {
+            throw std::runtime_error("the tuple doesn't match the update log");
+        }
+        data.insert(data.end(), to.begin(), to.end());
+        pos += from.size();
+    }
+    data.insert(data.end(), src + pos, src + src_size);
+
+    return Tuple(data);
 }
 
 
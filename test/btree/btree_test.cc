@@ -19,6 +19,8 @@
 #include <cstring>
 #include <algorithm>
 #include <future>
+#include <chrono>
+#include <thread>
 
 
 namespace SimpleDB {
@@ -631,4 +633,92 @@ TEST(BtreeTest, RandomInsertTest) {
 
 
 
+TEST(BtreeTest, ConcurrentReadBenchmark) {
+
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string test_dir = local_path + "/" + "test_dir";
+    std::string cmd;
+    cmd = "rm -rf " + test_dir;
+    system(cmd.c_str());
+
+    std::string log_file_name = "log.log";
+    std::unique_ptr<FileManager> fm 
+        = std::make_unique<FileManager>(test_dir, 4096);
+    
+    std::unique_ptr<LogManager> lm 
+        = std::make_unique<LogManager>(fm.get(), log_file_name);
+
+    std::unique_ptr<RecoveryManager> rm 
+        = std::make_unique<RecoveryManager>(lm.get());
+
+    // the whole tree is resident, so only latches are contended
+    std::unique_ptr<BufferManager> bfm
+        = std::make_unique<BufferManager>(fm.get(), rm.get(), 1000, 16);
+
+    auto colA = Column("colA", TypeID::INTEGER);
+    std::vector<Column> cols;
+    cols.push_back(colA);
+    auto schema = Schema(cols);
+
+    GenericComparator<4> comparator(&schema);
+    BPlusTree<GenericKey<4>, RID, GenericComparator<4>> btree("read_bench", INVALID_BLOCK_NUM, 
+                                                             comparator, bfm.get());
+
+    int key_num = 30000;
+    std::vector<int> keys(key_num);
+    for (int i = 0;i < key_num;i ++) {
+        keys[i] = i;
+    }
+    std::shuffle(keys.begin(), keys.end(), std::default_random_engine{});
+
+    GenericKey<4> index_key;
+    for (auto i : keys) {
+        auto tmp = Tuple({Value(i)}, schema);
+        index_key.SetFromKey(tmp);
+        btree.Insert(index_key, RID(i, i));
+    }
+    // building the tree must not leave any block pinned
+    EXPECT_EQ(bfm->CheckPinCount(), true);
+
+    // readers only, every lookup is verified
+    int read_num = 200000;
+    for (int thread_num : {1, 2, 4, 8}) {
+        std::vector<std::thread> workers;
+        std::atomic<int> wrong_num{0};
+        auto start = std::chrono::steady_clock::now();
+        
+        for (int t = 0;t < thread_num;t ++) {
+            workers.emplace_back([&, t]() {
+                std::mt19937 gen(t);
+                std::uniform_int_distribution<int> dist(0, key_num - 1);
+                GenericKey<4> key;
+                for (int i = 0;i < read_num / thread_num;i ++) {
+                    int k = dist(gen);
+                    auto tmp = Tuple({Value(k)}, schema);
+                    key.SetFromKey(tmp);
+                    std::vector<RID> result;
+                    if (!btree.GetValue(key, &result) || 
+                        result.size() != 1 || result[0] != RID(k, k)) {
+                        wrong_num ++;
+                    }
+                }
+            });
+        }
+        for (auto &t : workers) {
+            t.join();
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        std::cout << thread_num << " threads: " << read_num / ms 
+                  << " lookups/ms" << std::endl;
+        EXPECT_EQ(wrong_num, 0);
+    }
+
+    EXPECT_EQ(bfm->CheckPinCount(), true);
+}
+
+
+
 } // namespace SimpleDB
@@ -10,13 +10,19 @@
 #include "gtest/gtest.h"
 #include "recovery/recovery_manager.h"
 
+#include <chrono>
 #include <execinfo.h>
+#include <fstream>
+#include <fcntl.h>
 #include <iostream>
 #include <random>
 #include <queue>
 #include <cstring>
 #include <sstream>
 #include <map>
+#include <numeric>
+#include <set>
+#include <thread>
 
 namespace SimpleDB {
 
@@ -433,4 +439,761 @@ TEST(BufferManagerTest, SpeedTest) {// return;
 
 
 
-} // namespace SimpleDB
\ No newline at end of file
+TEST(BufferManagerTest, DirectIOSpeedTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string directory_path = local_path + "/test_directory";
+    std::string cmd = "rm -rf " + directory_path;
+    system(cmd.c_str());
+
+    // the dataset is much larger than bufferpool, so most of pins miss
+    const int block_size = 4 * 1024;
+    const int buffer_pool_size = 100;
+    const int total_block_num = 8192;
+    const int access_num = 20000;
+    std::string file_name = "direct.table";
+
+    {
+        FileManager fm(directory_path, block_size);
+        Page page(block_size);
+        for (int i = 0;i < total_block_num;i ++) {
+            page.SetInt(0, i);
+            fm.Write(BlockId(file_name, i), &page);
+        }
+        fm.SyncAll();
+    }
+
+    auto run = [&](bool direct_io) {
+        // drop the blocks from os page cache, so both modes start cold
+        std::string file_path = directory_path + "/" + file_name;
+        int fd = open(file_path.c_str(), O_RDONLY);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+
+        FileManager fm(directory_path, block_size, direct_io);
+        LogManager lm(&fm, "buffertest.log");
+        RecoveryManager rm(&lm);
+        BufferManager bpm(&fm, &rm, buffer_pool_size);
+        EXPECT_EQ(fm.IsDirectIO(), direct_io);
+
+        std::mt19937 mt(2023);
+        std::uniform_int_distribution<int> dis(0, total_block_num - 1);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0;i < access_num;i ++) {
+            int block_num = dis(mt);
+            auto *buffer = bpm.PinBlock(BlockId(file_name, block_num));
+            EXPECT_EQ(buffer->contents()->GetInt(0), block_num);
+            if (i % 5 == 0) {
+                buffer->contents()->SetInt(4, i);
+                bpm.UnpinBlock(buffer->GetBlockID(), true);
+            } else {
+                bpm.UnpinBlock(buffer->GetBlockID());
+            }
+        }
+        bpm.FlushAll();
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    };
+
+    double buffered_time = run(false);
+    double direct_time = run(true);
+    std::cout << "buffered io = " << buffered_time << " ms, "
+              << "direct io = " << direct_time << " ms" << std::endl;
+
+    system(cmd.c_str());
+}
+
+
+TEST(BufferManagerTest, FrameArenaTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string directory_path = local_path + "/test_directory";
+    std::string cmd = "rm -rf " + directory_path;
+    system(cmd.c_str());
+
+    const int block_size = 4 * 1024;
+    const int buffer_pool_size = 600;
+    std::string file_name = "arena.table";
+
+    {
+        FrameArena arena(buffer_pool_size, block_size);
+        std::cout << "huge page = " << arena.IsHugePage() << std::endl;
+        for (int i = 0;i < buffer_pool_size;i ++) {
+            EXPECT_EQ(arena.GetFrame(i), arena.GetFrame(0) + i * block_size);
+            // the arena is zeroed
+            EXPECT_EQ(arena.GetFrame(i)[block_size - 1], 0);
+        }
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(arena.GetFrame(0)) % SIMPLEDB_DIRECT_IO_ALIGNMENT, 0);
+    }
+
+    FileManager fm(directory_path, block_size);
+    LogManager lm(&fm, "buffertest.log");
+    RecoveryManager rm(&lm);
+    BufferManager bpm(&fm, &rm, buffer_pool_size);
+
+    // every frame is a distinct, aligned slice of one arena
+    std::vector<Buffer*> buffers;
+    char *lowest = nullptr;
+    for (int i = 0;i < buffer_pool_size;i ++) {
+        auto *buffer = bpm.NewBlock(file_name);
+        char *frame = buffer->contents()->GetRawDataPtr();
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(frame) % SIMPLEDB_DIRECT_IO_ALIGNMENT, 0);
+        lowest = (lowest == nullptr || frame < lowest) ? frame : lowest;
+        buffer->contents()->SetInt(0, i);
+        buffers.push_back(buffer);
+    }
+
+    std::set<char*> frames;
+    for (int i = 0;i < buffer_pool_size;i ++) {
+        char *frame = buffers[i]->contents()->GetRawDataPtr();
+        EXPECT_LT(frame - lowest, buffer_pool_size * block_size);
+        EXPECT_EQ(buffers[i]->contents()->GetInt(0), i);
+        frames.insert(frame);
+        bpm.UnpinBlock(buffers[i]->GetBlockID(), true);
+    }
+    EXPECT_EQ(static_cast<int>(frames.size()), buffer_pool_size);
+
+    system(cmd.c_str());
+}
+
+
+TEST(BufferManagerTest, ShardedPinSpeedTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string directory_path = local_path + "/test_directory";
+    std::string cmd = "rm -rf " + directory_path;
+    system(cmd.c_str());
+
+    const int block_size = 4 * 1024;
+    const int buffer_pool_size = 1024;
+    const int block_num = 512;
+    const int total_ops = 200000;
+    std::string file_name = "sharded.table";
+
+    for (int shard_num : {1, 8, 32}) {
+        FileManager fm(directory_path, block_size);
+        LogManager lm(&fm, "buffertest.log");
+        RecoveryManager rm(&lm);
+        BufferManager bpm(&fm, &rm, buffer_pool_size, shard_num);
+
+        // make all blocks resident, so we only measure the pin/unpin path
+        if (fm.GetFileBlockNum(file_name) == 0) {
+            for (int i = 0;i < block_num;i ++) {
+                auto *buffer = bpm.NewBlock(file_name);
+                buffer->contents()->SetInt(0, i);
+                bpm.UnpinBlock(buffer->GetBlockID(), true);
+            }
+            bpm.FlushAll();
+        }
+        for (int i = 0;i < block_num;i ++) {
+            EXPECT_EQ(bpm.PinBlock(BlockId(file_name, i))->contents()->GetInt(0), i);
+            bpm.UnpinBlock(BlockId(file_name, i));
+        }
+
+        for (int thread_num = 1;thread_num <= 8;thread_num *= 2) {
+            std::vector<std::thread> threads;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int t = 0;t < thread_num;t ++) {
+                threads.emplace_back([&, t]() {
+                    std::mt19937 mt(t);
+                    std::uniform_int_distribution<int> dis(0, block_num - 1);
+                    for (int i = 0;i < total_ops / thread_num;i ++) {
+                        BlockId block(file_name, dis(mt));
+                        auto *buffer = bpm.PinBlock(block);
+                        EXPECT_EQ(buffer->contents()->GetInt(0), block.BlockNum());
+                        bpm.UnpinBlock(block);
+                    }
+                });
+            }
+            for (auto &t : threads) {
+                t.join();
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            double time = std::chrono::duration<double, std::milli>(end - start).count();
+            std::cout << "shards = " << shard_num << ", threads = " << thread_num 
+                      << ", pin/unpin = " << total_ops / time << " ops/ms" << std::endl;
+        }
+
+        EXPECT_EQ(bpm.available(), buffer_pool_size);
+    }
+
+    system(cmd.c_str());
+}
+
+
+TEST(BufferManagerTest, ScanRingTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string directory_path = local_path + "/test_directory";
+    std::string cmd = "rm -rf " + directory_path;
+    system(cmd.c_str());
+
+    const int block_size = 4 * 1024;
+    const int buffer_pool_size = 64;
+    const int hot_num = 16;
+    const int scan_num = 512;
+    std::string hot_file = "hot.index";
+    std::string scan_file = "scan.table";
+
+    for (bool use_ring : {false, true}) {
+        FileManager fm(directory_path, block_size);
+        LogManager lm(&fm, "buffertest.log");
+        RecoveryManager rm(&lm);
+        BufferManager bpm(&fm, &rm, buffer_pool_size);
+
+        Page zero(block_size);
+        if (fm.GetFileBlockNum(hot_file) == 0) {
+            for (int i = 0;i < hot_num;i ++) {
+                fm.Write(BlockId(hot_file, i), &zero);
+            }
+            for (int i = 0;i < scan_num;i ++) {
+                fm.Write(BlockId(scan_file, i), &zero);
+            }
+        }
+
+        // mark the hot blocks in memory only, if they are evicted
+        // we will read zero from disk again
+        for (int i = 0;i < hot_num;i ++) {
+            auto *buffer = bpm.PinBlock(BlockId(hot_file, i));
+            buffer->contents()->SetInt(0, i + 1);
+            bpm.UnpinBlock(BlockId(hot_file, i));
+        }
+
+        BufferAccessStrategy strategy;
+        for (int i = 0;i < scan_num;i ++) {
+            BlockId block(scan_file, i);
+            bpm.PinBlock(block, use_ring ? &strategy : nullptr);
+            bpm.UnpinBlock(block);
+        }
+
+        int resident = 0;
+        for (int i = 0;i < hot_num;i ++) {
+            auto *buffer = bpm.PinBlock(BlockId(hot_file, i));
+            resident += buffer->contents()->GetInt(0) == i + 1;
+            bpm.UnpinBlock(BlockId(hot_file, i));
+        }
+
+        std::cout << "use ring = " << use_ring << ", resident hot blocks = " 
+                  << resident << "/" << hot_num << std::endl;
+        EXPECT_EQ(resident, use_ring ? hot_num : 0);
+        EXPECT_EQ(bpm.available(), buffer_pool_size);
+    }
+
+    system(cmd.c_str());
+}
+
+
+TEST(BufferManagerTest, BackgroundWriterTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string directory_path = local_path + "/test_directory";
+    std::string cmd = "rm -rf " + directory_path;
+    system(cmd.c_str());
+
+    const int block_size = 4 * 1024;
+    const int buffer_pool_size = 64;
+    const int block_num = 256;
+    const int total_ops = 4000;
+    std::string file_name = "bgwriter.table";
+
+    uint64_t foreground_writes[2];
+    for (bool use_writer : {false, true}) {
+        FileManager fm(directory_path, block_size);
+        LogManager lm(&fm, "buffertest.log");
+        RecoveryManager rm(&lm);
+        BufferManager bpm(&fm, &rm, buffer_pool_size);
+        Page zero(block_size);
+        for (int i = 0;i < block_num;i ++) {
+            fm.Write(BlockId(file_name, i), &zero);
+        }
+        if (use_writer) {
+            bpm.StartBackgroundWriter(buffer_pool_size / 2, std::chrono::milliseconds(1));
+        }
+
+        // every op dirties a block, with a little think time
+        std::mt19937 mt(use_writer);
+        std::uniform_int_distribution<int> dis(0, block_num - 1);
+        std::vector<int> expected(block_num, 0);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0;i < total_ops;i ++) {
+            BlockId block(file_name, dis(mt));
+            auto *buffer = bpm.PinBlock(block);
+            buffer->WLock();
+            buffer->contents()->SetInt(0, i + 1);
+            buffer->WUnlock();
+            expected[block.BlockNum()] = i + 1;
+            bpm.UnpinBlock(block, true);
+            if (i % 16 == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double time = std::chrono::duration<double, std::milli>(end - start).count();
+
+        bpm.StopBackgroundWriter();
+        foreground_writes[use_writer] = bpm.GetForegroundWriteNum();
+        std::cout << "background writer = " << use_writer 
+                  << ", foreground writes = " << bpm.GetForegroundWriteNum()
+                  << ", background writes = " << bpm.GetBackgroundWriteNum()
+                  << ", time = " << time << "ms" << std::endl;
+        
+        // no write is lost
+        bpm.FlushAll();
+        Page page(block_size);
+        for (int i = 0;i < block_num;i ++) {
+            if (expected[i] != 0) {
+                fm.Read(BlockId(file_name, i), &page);
+                EXPECT_EQ(page.GetInt(0), expected[i]);
+            }
+        }
+        EXPECT_EQ(bpm.available(), buffer_pool_size);
+        system(cmd.c_str());
+    }
+
+    EXPECT_LT(foreground_writes[1], foreground_writes[0]);
+}
+
+
+TEST(BufferManagerTest, ReadAheadTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string directory_path = local_path + "/test_directory";
+    std::string cmd = "rm -rf " + directory_path;
+    system(cmd.c_str());
+
+    const int block_size = 4 * 1024;
+    const int buffer_pool_size = 256;
+    const int block_num = 4096;
+    std::string file_name = "readahead.table";
+
+    {
+        FileManager fm(directory_path, block_size, true);
+        Page page(block_size, SIMPLEDB_DIRECT_IO_ALIGNMENT);
+        for (int i = 0;i < block_num;i ++) {
+            page.SetInt(0, i);
+            fm.Write(BlockId(file_name, i), &page);
+        }
+    }
+
+    // direct io bypasses the page cache, so every miss goes to device
+    // (ring size, read-ahead blocks)
+    std::vector<std::pair<int, int>> configs = {
+        {SIMPLEDB_SCAN_RING_SIZE, 0}, 
+        {SIMPLEDB_SCAN_RING_SIZE, SIMPLEDB_READ_AHEAD_BLOCK_NUM},
+        {0, 32}
+    };
+    for (auto [ring_size, read_ahead_num] : configs) {
+        FileManager fm(directory_path, block_size, true);
+        LogManager lm(&fm, "buffertest.log");
+        RecoveryManager rm(&lm);
+        BufferManager bpm(&fm, &rm, buffer_pool_size);
+        BufferAccessStrategy strategy(ring_size, read_ahead_num);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0;i < block_num;i ++) {
+            BlockId block(file_name, i);
+            auto *buffer = bpm.PinBlock(block, &strategy);
+            EXPECT_EQ(buffer->contents()->GetInt(0), i);
+            bpm.UnpinBlock(block);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double time = std::chrono::duration<double, std::milli>(end - start).count();
+
+        std::cout << "ring = " << ring_size << ", read ahead = " << read_ahead_num << ", scan = " 
+                  << static_cast<double>(block_num) * block_size / 1024 / 1024 / (time / 1000)
+                  << " MB/s" << std::endl;
+        EXPECT_EQ(bpm.available(), buffer_pool_size);
+    }
+
+    system(cmd.c_str());
+}
+
+
+TEST(BufferManagerTest, ResizeTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string directory_path = local_path + "/test_directory";
+    std::string cmd = "rm -rf " + directory_path;
+    system(cmd.c_str());
+
+    const int block_size = 4 * 1024;
+    const int shard_num = 4;
+    const int hot_num = 32;
+    const int block_num = 512;
+    std::string file_name = "resize.table";
+
+    for (auto replacer_type : {ReplacerType::LRU, ReplacerType::CLOCK, ReplacerType::LRU_K}) {
+        FileManager fm(directory_path, block_size);
+        LogManager lm(&fm, "buffertest.log");
+        RecoveryManager rm(&lm);
+        BufferManager bpm(&fm, &rm, 256, shard_num, replacer_type);
+
+        Page zero(block_size);
+        if (fm.GetFileBlockNum(file_name) == 0) {
+            for (int i = 0;i < block_num;i ++) {
+                fm.Write(BlockId(file_name, i), &zero);
+            }
+        }
+
+        // 1. mark the hot blocks in memory only, they use the first 
+        // frames of every shard, so shrinking doesn't evict them
+        for (int i = 0;i < hot_num;i ++) {
+            auto *buffer = bpm.PinBlock(BlockId(file_name, i));
+            buffer->contents()->SetInt(0, -1);
+            bpm.UnpinBlock(BlockId(file_name, i));
+        }
+        EXPECT_TRUE(bpm.Resize(128));
+        EXPECT_EQ(bpm.GetBufferNum(), 128);
+        for (int i = 0;i < hot_num;i ++) {
+            auto *buffer = bpm.PinBlock(BlockId(file_name, i));
+            EXPECT_EQ(buffer->contents()->GetInt(0), -1);
+            bpm.UnpinBlock(BlockId(file_name, i));
+        }
+
+        // 2. dirty blocks are written when they are evicted by shrinking
+        for (int i = hot_num;i < block_num;i ++) {
+            auto *buffer = bpm.PinBlock(BlockId(file_name, i));
+            buffer->contents()->SetInt(0, i);
+            bpm.UnpinBlock(BlockId(file_name, i), true);
+        }
+        EXPECT_TRUE(bpm.Resize(16));
+        for (int i = hot_num;i < block_num;i ++) {
+            auto *buffer = bpm.PinBlock(BlockId(file_name, i));
+            EXPECT_EQ(buffer->contents()->GetInt(0), i);
+            bpm.UnpinBlock(BlockId(file_name, i));
+        }
+
+        // 3. resize while others are pinning blocks
+        std::atomic<bool> stop{false};
+        std::atomic<int> wrong_num{0};
+        std::vector<std::thread> workers;
+        for (int t = 0;t < 4;t ++) {
+            workers.emplace_back([&, t]() {
+                std::mt19937 gen(t);
+                std::uniform_int_distribution<int> dist(hot_num, block_num - 1);
+                while (!stop) {
+                    int block_num = dist(gen);
+                    BlockId block(file_name, block_num);
+                    auto *buffer = bpm.PinBlock(block);
+                    wrong_num += buffer->contents()->GetInt(0) != block_num;
+                    bpm.UnpinBlock(block);
+                }
+            });
+        }
+
+        for (int buffer_nums : {64, 256, 8, 512, 32, 128}) {
+            EXPECT_TRUE(bpm.Resize(buffer_nums));
+            EXPECT_EQ(bpm.GetBufferNum(), buffer_nums);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+
+        stop = true;
+        for (auto &worker : workers) {
+            worker.join();
+        }
+
+        EXPECT_EQ(wrong_num, 0);
+        EXPECT_EQ(bpm.available(), 128);
+        EXPECT_TRUE(bpm.CheckPinCount());
+    }
+
+    system(cmd.c_str());
+}
+
+
+TEST(BufferManagerTest, WarmUpTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string directory_path = local_path + "/test_directory";
+    std::string cmd = "rm -rf " + directory_path;
+    system(cmd.c_str());
+
+    const int block_size = 4 * 1024;
+    const int block_num = 256;
+    const int hot_begin = 100;
+    const int hot_end = 148;
+    std::string file_name = "warmup.table";
+
+    {
+        FileManager fm(directory_path, block_size);
+        LogManager lm(&fm, "buffertest.log");
+        RecoveryManager rm(&lm);
+        Page page(block_size);
+        for (int i = 0;i < block_num;i ++) {
+            page.SetInt(0, i);
+            fm.Write(BlockId(file_name, i), &page);
+        }
+
+        // the resident blocks are dumped when bufferpool is destroyed,
+        // with one shard the order of dump is exactly the order of lru
+        BufferManager bpm(&fm, &rm, 64);
+        bpm.SetDumpFile();
+        for (int i = hot_begin;i < hot_end;i ++) {
+            bpm.PinBlock(BlockId(file_name, i));
+            bpm.UnpinBlock(BlockId(file_name, i));
+        }
+    }
+
+    // the most recently used block comes first
+    std::ifstream dump(directory_path + "/" + SIMPLEDB_BUFFER_DUMP_FILE_NAME);
+    std::string line;
+    std::getline(dump, line);
+    EXPECT_EQ(line, std::to_string(hot_end - 1) + " " + file_name);
+
+    for (int buffer_nums : {64, 16}) {
+        FileManager fm(directory_path, block_size);
+        LogManager lm(&fm, "buffertest.log");
+        RecoveryManager rm(&lm);
+        BufferManager bpm(&fm, &rm, buffer_nums, 4);
+        int load_num = std::min(buffer_nums, hot_end - hot_begin);
+        EXPECT_EQ(bpm.LoadResidentBlocks(), load_num);
+
+        // change the disk behind bufferpool, so we know 
+        // which blocks are read before
+        Page page(block_size);
+        page.SetInt(0, -1);
+        for (int i = 0;i < block_num;i ++) {
+            fm.Write(BlockId(file_name, i), &page);
+        }
+
+        // the hottest blocks are loaded
+        for (int i = hot_end - load_num;i < hot_end;i ++) {
+            auto *buffer = bpm.PinBlock(BlockId(file_name, i));
+            EXPECT_EQ(buffer->contents()->GetInt(0), i);
+            bpm.UnpinBlock(BlockId(file_name, i));
+        }
+
+        // restore the disk for next round
+        for (int i = 0;i < block_num;i ++) {
+            page.SetInt(0, i);
+            fm.Write(BlockId(file_name, i), &page);
+        }
+        EXPECT_EQ(bpm.available(), buffer_nums);
+    }
+
+    system(cmd.c_str());
+}
+
+
+TEST(BufferManagerTest, PageGuardTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string directory_path = local_path + "/test_directory";
+    std::string cmd = "rm -rf " + directory_path;
+    system(cmd.c_str());
+
+    const int block_size = 4 * 1024;
+    std::string file_name = "guard.table";
+    FileManager fm(directory_path, block_size);
+    LogManager lm(&fm, "buffertest.log");
+    RecoveryManager rm(&lm);
+    BufferManager bpm(&fm, &rm, 4);
+    for (int i = 0;i < 4;i ++) {
+        fm.Append(file_name);
+    }
+
+    {
+        // moving a guard moves the pin, it's released only once
+        auto guard = bpm.PinBlockGuarded(BlockId(file_name, 0));
+        EXPECT_EQ(bpm.available(), 3);
+        BasicPageGuard other(std::move(guard));
+        EXPECT_FALSE(guard.IsValid());
+        EXPECT_EQ(other.GetBlockNum(), 0);
+        EXPECT_EQ(other.GetBuffer()->GetPinCount(), 1);
+
+        // assigning releases the old pin first
+        other = bpm.PinBlockGuarded(BlockId(file_name, 1));
+        EXPECT_EQ(other.GetBlockNum(), 1);
+        EXPECT_EQ(bpm.available(), 3);
+    }
+    EXPECT_EQ(bpm.available(), 4);
+
+    {
+        // readers share the latch, and a writer can get it after they are dropped
+        auto reader1 = bpm.PinBlockRead(BlockId(file_name, 2));
+        auto reader2 = bpm.PinBlockRead(BlockId(file_name, 2));
+        EXPECT_EQ(reader1.GetBuffer(), reader2.GetBuffer());
+        EXPECT_EQ(reader1.GetBuffer()->GetPinCount(), 2);
+        reader1.Drop();
+        reader2.Drop();
+        reader2.Drop();
+
+        auto writer = bpm.PinBlockWrite(BlockId(file_name, 2));
+        writer.As<Buffer>()->contents()->SetInt(0, 1234);
+        writer.SetDirty();
+        EXPECT_EQ(writer.GetBuffer()->GetPinCount(), 1);
+    }
+    EXPECT_EQ(bpm.available(), 4);
+
+    {
+        // the dirty flag is carried to unpinning
+        auto reader = bpm.PinBlockRead(BlockId(file_name, 2));
+        EXPECT_TRUE(reader.GetBuffer()->IsDirty());
+        EXPECT_EQ(reader.DataAs<int>()[0], 1234);
+
+        // guards can be kept in containers
+        std::vector<WritePageGuard> guards;
+        guards.emplace_back(bpm.PinBlockWrite(BlockId(file_name, 0)));
+        guards.emplace_back(bpm.PinBlockWrite(BlockId(file_name, 1)));
+        guards.emplace_back(bpm.PinBlockWrite(BlockId(file_name, 3)));
+        EXPECT_EQ(bpm.available(), 0);
+        guards.erase(guards.begin());
+        EXPECT_EQ(bpm.available(), 1);
+        EXPECT_FALSE(guards.front().GetBuffer()->IsDirty());
+    }
+    EXPECT_EQ(bpm.available(), 4);
+    EXPECT_TRUE(bpm.CheckPinCount());
+
+    system(cmd.c_str());
+}
+
+
+
+TEST(BufferManagerTest, StatsTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string directory_path = local_path + "/test_directory";
+    std::string cmd = "rm -rf " + directory_path;
+    system(cmd.c_str());
+
+    const int block_size = 4 * 1024;
+    std::string file_name = "stats.table";
+    FileManager fm(directory_path, block_size);
+    LogManager lm(&fm, "buffertest.log");
+    RecoveryManager rm(&lm);
+    BufferManager bpm(&fm, &rm, 4);
+    for (int i = 0;i < 8;i ++) {
+        fm.Append(file_name);
+    }
+    auto before = bpm.GetStats();
+
+    // 4 misses fill bufferpool, then a hit
+    for (int i = 0;i < 4;i ++) {
+        bpm.PinBlock(BlockId(file_name, i));
+        bpm.UnpinBlock(BlockId(file_name, i), i == 0);
+    }
+    bpm.PinBlock(BlockId(file_name, 1));
+    bpm.UnpinBlock(BlockId(file_name, 1));
+
+    // evict all of them, only block 0 is dirty
+    for (int i = 4;i < 8;i ++) {
+        bpm.PinBlock(BlockId(file_name, i));
+        bpm.UnpinBlock(BlockId(file_name, i));
+    }
+
+    auto stats = bpm.GetStats();
+    EXPECT_EQ(stats.hit_num_ - before.hit_num_, 1);
+    EXPECT_EQ(stats.miss_num_ - before.miss_num_, 8);
+    EXPECT_EQ(stats.file_stats_[file_name].hit_num_, 1);
+    EXPECT_EQ(stats.file_stats_[file_name].miss_num_, 8);
+    EXPECT_EQ(stats.clean_eviction_num_, 3);
+    EXPECT_EQ(stats.dirty_eviction_num_, 1);
+    EXPECT_NEAR(stats.HitRatio(), 1.0 / 9, 1e-9);
+
+    EXPECT_EQ(stats.io_.read_num_ - before.io_.read_num_, 8);
+    EXPECT_EQ(stats.io_.read_bytes_ - before.io_.read_bytes_, 8 * block_size);
+    EXPECT_EQ(stats.io_.write_num_ - before.io_.write_num_, 1);
+    EXPECT_EQ(stats.io_.write_bytes_ - before.io_.write_bytes_, block_size);
+    EXPECT_GE(stats.io_.read_latency_.Percentile(0.99), 
+              stats.io_.read_latency_.Percentile(0.5));
+    EXPECT_EQ(stats.pin_wait_.count_, 0);
+
+    // a pin waits for a free frame
+    for (int i = 0;i < 4;i ++) {
+        bpm.PinBlock(BlockId(file_name, i));
+    }
+    std::thread unpin_thread([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        bpm.UnpinBlock(BlockId(file_name, 0));
+    });
+    bpm.PinBlock(BlockId(file_name, 4));
+    unpin_thread.join();
+
+    stats = bpm.GetStats();
+    EXPECT_EQ(stats.pin_wait_.count_, 1);
+    EXPECT_GE(stats.pin_wait_.Percentile(0.5), 16 * 1024);
+    std::cout << "pin wait mean = " << stats.pin_wait_.Mean() << " us" << std::endl;
+
+    for (int i = 1;i < 5;i ++) {
+        bpm.UnpinBlock(BlockId(file_name, i));
+    }
+    system(cmd.c_str());
+}
+
+
+TEST(BufferManagerTest, PinWaitQueueTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string directory_path = local_path + "/test_directory";
+    std::string cmd = "rm -rf " + directory_path;
+    system(cmd.c_str());
+
+    const int block_size = 4 * 1024;
+    const int waiter_num = 4;
+    std::string file_name = "waitqueue.table";
+    FileManager fm(directory_path, block_size);
+    LogManager lm(&fm, "buffertest.log");
+    RecoveryManager rm(&lm);
+    BufferManager bpm(&fm, &rm, 2);
+    for (int i = 0;i < 2 + waiter_num;i ++) {
+        fm.Append(file_name);
+    }
+
+    // exhaust bufferpool
+    bpm.PinBlock(BlockId(file_name, 0));
+    bpm.PinBlock(BlockId(file_name, 1));
+    EXPECT_EQ(bpm.TryPinBlock(BlockId(file_name, 2)), nullptr);
+    
+    // a hit doesn't need a free frame
+    auto *buffer = bpm.TryPinBlock(BlockId(file_name, 1));
+    ASSERT_NE(buffer, nullptr);
+    bpm.UnpinBlock(buffer);
+
+    // waiters arrive one by one, every one passes the frame to the next 
+    // after using it. they should get the frame in arrival order
+    std::mutex order_latch;
+    std::vector<int> order;
+    std::vector<std::thread> waiters;
+    for (int i = 0;i < waiter_num;i ++) {
+        waiters.emplace_back([&, i]() {
+            BlockId block(file_name, 2 + i);
+            bpm.PinBlock(block);
+            {
+                std::lock_guard<std::mutex> lock(order_latch);
+                order.push_back(i);
+            }
+            bpm.UnpinBlock(block);
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    // others can't overtake the waiters
+    EXPECT_EQ(bpm.TryPinBlock(BlockId(file_name, 2)), nullptr);
+    
+    bpm.UnpinBlock(BlockId(file_name, 0));
+    for (auto &t : waiters) {
+        t.join();
+    }
+    std::vector<int> expect_order(waiter_num);
+    std::iota(expect_order.begin(), expect_order.end(), 0);
+    EXPECT_EQ(order, expect_order);
+    EXPECT_EQ(bpm.GetStats().pin_wait_.count_, waiter_num);
+
+    // a pin gives up after the timeout
+    bpm.SetPinTimeout(std::chrono::milliseconds(50));
+    bpm.PinBlock(BlockId(file_name, 0));
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_THROW(bpm.PinBlock(BlockId(file_name, 2)), std::runtime_error);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+
+    // the waiter which gave up has left the queue
+    bpm.UnpinBlock(BlockId(file_name, 1));
+    bpm.UnpinBlock(BlockId(file_name, 0));
+    EXPECT_NE(bpm.TryPinBlock(BlockId(file_name, 2)), nullptr);
+    bpm.UnpinBlock(BlockId(file_name, 2));
+    EXPECT_EQ(bpm.available(), 2);
+
+    system(cmd.c_str());
+}
+
+} // namespace SimpleDB
@@ -4,8 +4,16 @@
 #include "file/file_manager.h"
 #include "file/block_id.h"
 #include "file/page.h"
+#include "config/config.h"
 
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
 #include <unistd.h>
 #include <cstdio>
 #include "sys/stat.h"
@@ -134,6 +142,420 @@ TEST(FileManagerTest, SpeedTest2) {
 }
 
 
+/**
+ * @brief the old io path of filemanager, every read and write is
+ * serialized by one latch and goes through seekp/read/write of fstream.
+ * only be used as the baseline of ConcurrentThroughputTest.
+ */
+class FStreamFileIO {
+
+public:
+
+    FStreamFileIO(const std::string &directory, int block_size)
+        : directory_(directory), block_size_(block_size) {}
+
+    void Read(const BlockId &block, Page *page) {
+        std::lock_guard<std::mutex> lock(latch_);
+        auto *file_io = GetFile(block.FileName());
+        file_io->seekp(block.BlockNum() * block_size_);
+        file_io->read(page->GetRawDataPtr(), block_size_);
+    }
+
+    void Write(const BlockId &block, Page *page) {
+        std::lock_guard<std::mutex> lock(latch_);
+        auto *file_io = GetFile(block.FileName());
+        file_io->seekp(block.BlockNum() * block_size_, std::ios::beg);
+        file_io->write(page->GetRawDataPtr(), block_size_);
+        file_io->flush();
+    }
+
+private:
+
+    std::fstream* GetFile(const std::string &file_name) {
+        if (files_.find(file_name) == files_.end()) {
+            auto file_io = std::make_unique<std::fstream>();
+            file_io->open(directory_ + "/" + file_name, 
+                          std::ios::binary | std::ios::in | std::ios::out);
+            files_[file_name] = std::move(file_io);
+        }
+        return files_[file_name].get();
+    }
+
+    std::string directory_;
+    int block_size_;
+    std::mutex latch_;
+    std::map<std::string, std::unique_ptr<std::fstream>> files_;
+};
+
+
+/**
+ * @brief every thread reads or writes(20%) random blocks of random files,
+ * and every block always stores its block number at offset 0.
+ * @return elapsed milliseconds
+ */
+template<typename IO>
+double RunConcurrentIO(IO *io, int thread_num, int total_ops,
+                       const std::vector<std::string> &file_names, int block_num) {
+    std::vector<std::thread> threads;
+    int block_size = 4 * 1024;
+    auto start = std::chrono::high_resolution_clock::now();
 
+    for (int i = 0;i < thread_num;i ++) {
+        threads.emplace_back([&, i]() {
+            std::default_random_engine e(i);
+            std::uniform_int_distribution<int> file_dist(0, file_names.size() - 1);
+            std::uniform_int_distribution<int> block_dist(0, block_num - 1);
+            std::uniform_int_distribution<int> op_dist(0, 9);
+            SimpleDB::Page p(block_size);
+
+            for (int j = 0;j < total_ops / thread_num;j ++) {
+                BlockId block(file_names[file_dist(e)], block_dist(e));
+                if (op_dist(e) < 2) {
+                    p.SetInt(0, block.BlockNum());
+                    io->Write(block, &p);
+                } else {
+                    io->Read(block, &p);
+                    EXPECT_EQ(p.GetInt(0), block.BlockNum());
+                }
+            }
+        });
+    }
+
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
 }
 
+
+TEST(FileManagerTest, ConcurrentThroughputTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string directory_path = local_path + "/test_directory";
+    std::string cmd = "rm -rf " + directory_path;
+    system(cmd.c_str());
+
+    int block_size = 4 * 1024;
+    const int file_num = 4;
+    const int block_num = 256;
+    const int total_ops = 32768;
+    std::vector<std::string> file_names;
+
+    SimpleDB::FileManager fm(directory_path, block_size);
+    SimpleDB::Page p(block_size);
+    for (int i = 0;i < file_num;i ++) {
+        file_names.push_back("concurrent" + std::to_string(i) + ".table");
+        for (int j = 0;j < block_num;j ++) {
+            auto block = fm.Append(file_names[i]);
+            p.SetInt(0, block.BlockNum());
+            fm.Write(block, &p);
+        }
+    }
+
+    FStreamFileIO legacy_io(directory_path, block_size);
+    for (int thread_num = 1;thread_num <= 32;thread_num *= 2) {
+        double fstream_time = RunConcurrentIO(&legacy_io, thread_num, total_ops, file_names, block_num);
+        double pread_time = RunConcurrentIO(&fm, thread_num, total_ops, file_names, block_num);
+        
+        std::cout << "threads = " << thread_num 
+                  << ", fstream = " << total_ops / fstream_time << " ops/ms"
+                  << ", pread/pwrite = " << total_ops / pread_time << " ops/ms" << std::endl;
+    }
+
+    system(cmd.c_str());
+}
+
+
+TEST(FileManagerTest, BatchIOTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string directory_path = local_path + "/test_directory";
+    std::string cmd = "rm -rf " + directory_path;
+    system(cmd.c_str());
+
+    int block_size = 4 * 1024;
+    const int block_num = 512;
+    SimpleDB::FileManager fm(directory_path, block_size);
+    std::vector<std::string> file_names = {"batch0.table", "batch1.table"};
+    std::vector<SimpleDB::BlockId> blocks;
+    std::vector<SimpleDB::Page> write_pages;
+    std::vector<SimpleDB::Page*> pages;
+
+    // blocks of two files are interleaved, and written without append
+    for (int i = 0;i < block_num;i ++) {
+        blocks.emplace_back(file_names[i % 2], i / 2);
+        write_pages.emplace_back(block_size);
+        write_pages.back().SetInt(0, i);
+        write_pages.back().SetInt(block_size - 4, -i);
+    }
+    for (auto &page : write_pages) {
+        pages.push_back(&page);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    fm.WriteBatch(blocks, pages);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "write batch = " 
+              << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+    EXPECT_EQ(fm.GetFileBlockNum(file_names[0]), block_num / 2);
+    EXPECT_EQ(fm.GetFileBlockNum(file_names[1]), block_num / 2);
+
+    // read them back in reverse order, and the blocks past end of file are zero
+    std::vector<SimpleDB::BlockId> read_blocks;
+    std::vector<SimpleDB::Page> read_pages;
+    std::vector<SimpleDB::Page*> read_ptrs;
+    for (int i = block_num - 1;i >= 0;i --) {
+        read_blocks.push_back(blocks[i]);
+        read_pages.emplace_back(block_size);
+    }
+    read_blocks.emplace_back(file_names[0], block_num);
+    read_pages.emplace_back(block_size);
+    read_pages.back().SetInt(0, 1);
+    for (auto &page : read_pages) {
+        read_ptrs.push_back(&page);
+    }
+
+    start = std::chrono::high_resolution_clock::now();
+    auto completion = fm.SubmitRead(read_blocks, read_ptrs);
+    completion->Wait();
+    end = std::chrono::high_resolution_clock::now();
+    EXPECT_TRUE(completion->IsDone());
+    std::cout << "read batch = " 
+              << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+
+    for (int i = 0;i < block_num;i ++) {
+        int block_index = block_num - 1 - i;
+        EXPECT_EQ(read_pages[i].GetInt(0), block_index);
+        EXPECT_EQ(read_pages[i].GetInt(block_size - 4), -block_index);
+    }
+    EXPECT_EQ(read_pages[block_num].GetInt(0), 0);
+
+    // an empty batch completes immediately
+    fm.ReadBatch({}, {});
+
+    system(cmd.c_str());
+}
+
+
+TEST(FileManagerTest, SyncTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string directory_path = local_path + "/test_directory";
+    std::string cmd = "rm -rf " + directory_path;
+    system(cmd.c_str());
+
+    int block_size = 4 * 1024;
+    const int block_num = 256;
+    std::string file_name = "sync.table";
+
+    auto write_blocks = [&](SimpleDB::FileManager &fm, int base, bool sync) {
+        SimpleDB::Page p(block_size);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0;i < block_num;i ++) {
+            p.SetInt(0, base + i);
+            fm.Write(SimpleDB::BlockId(file_name, i), &p);
+        }
+        if (sync) {
+            fm.SyncAll();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    };
+
+    {
+        SimpleDB::FileManager fm(directory_path, block_size);
+        EXPECT_FALSE(fm.IsWriteThrough());
+        // syncing a file which has not been written does nothing
+        fm.Sync(file_name);
+
+        fm.SetWriteThrough(true);
+        double through_time = write_blocks(fm, 0, false);
+        fm.SetWriteThrough(false);
+        double back_time = write_blocks(fm, block_num, true);
+
+        std::cout << "write-through = " << through_time << " ms, "
+                  << "write-back + SyncAll = " << back_time << " ms" << std::endl;
+    }
+
+    // the content written before sync can be read by another filemanager
+    SimpleDB::FileManager fm(directory_path, block_size);
+    SimpleDB::Page p(block_size);
+    for (int i = 0;i < block_num;i ++) {
+        fm.Read(SimpleDB::BlockId(file_name, i), &p);
+        EXPECT_EQ(p.GetInt(0), block_num + i);
+    }
+
+    system(cmd.c_str());
+}
+
+
+TEST(FileManagerTest, DirectIOTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string directory_path = local_path + "/test_directory";
+    std::string cmd = "rm -rf " + directory_path;
+    system(cmd.c_str());
+
+    int block_size = 4 * 1024;
+    const int block_num = 64;
+    std::string file_name = "direct.table";
+    SimpleDB::FileManager fm(directory_path, block_size, true);
+    EXPECT_TRUE(fm.IsDirectIO());
+
+    // direct io is ignored if block size is not aligned
+    SimpleDB::FileManager unaligned_fm(directory_path, 400, true);
+    EXPECT_FALSE(unaligned_fm.IsDirectIO());
+
+    // aligned pages are accessed directly, others are copied
+    // through an aligned page
+    SimpleDB::Page aligned_page(block_size, SIMPLEDB_DIRECT_IO_ALIGNMENT);
+    SimpleDB::Page page(block_size);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned_page.GetRawDataPtr()) % SIMPLEDB_DIRECT_IO_ALIGNMENT, 0);
+    for (int i = 0;i < block_num;i ++) {
+        auto block = fm.Append(file_name);
+        auto &p = i % 2 ? aligned_page : page;
+        p.SetInt(0, i);
+        fm.Write(block, &p);
+    }
+    EXPECT_EQ(fm.GetFileBlockNum(file_name), block_num);
+
+    std::vector<SimpleDB::BlockId> blocks;
+    std::vector<SimpleDB::Page> pages;
+    std::vector<SimpleDB::Page*> page_ptrs;
+    for (int i = 0;i < block_num;i ++) {
+        auto &p = i % 2 ? aligned_page : page;
+        fm.Read(SimpleDB::BlockId(file_name, i), &p);
+        EXPECT_EQ(p.GetInt(0), i);
+
+        blocks.emplace_back(file_name, i);
+        if (i % 2) {
+            pages.emplace_back(block_size, SIMPLEDB_DIRECT_IO_ALIGNMENT);
+        } else {
+            pages.emplace_back(block_size);
+        }
+    }
+    for (auto &p : pages) {
+        page_ptrs.push_back(&p);
+    }
+
+    fm.ReadBatch(blocks, page_ptrs);
+    for (int i = 0;i < block_num;i ++) {
+        EXPECT_EQ(pages[i].GetInt(0), i);
+    }
+
+    system(cmd.c_str());
+}
+
+
+TEST(FileManagerTest, ExtentTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string directory_path = local_path + "/test_directory";
+    std::string cmd = "rm -rf " + directory_path;
+    system(cmd.c_str());
+
+    int block_size = 4 * 1024;
+    const int block_num = 100;
+    std::string file_name = "extent.table";
+    std::string file_path = directory_path + "/" + file_name;
+    struct stat stat_buf;
+
+    {
+        SimpleDB::FileManager fm(directory_path, block_size);
+        EXPECT_EQ(fm.GetFileBlockNum(file_name), 0);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0;i < block_num;i ++) {
+            EXPECT_EQ(fm.Append(file_name).BlockNum(), i);
+            EXPECT_EQ(fm.GetFileBlockNum(file_name), i + 1);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "append " << block_num << " blocks = " 
+                  << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+
+        // the size of file is the high-water mark, the space of
+        // the whole extent has been allocated
+        stat(file_path.c_str(), &stat_buf);
+        EXPECT_EQ(stat_buf.st_size, block_num * block_size);
+        std::cout << "allocated = " << stat_buf.st_blocks * 512 / block_size << " blocks" << std::endl;
+
+        // write past the end of file raises the high-water mark
+        SimpleDB::Page page(block_size);
+        fm.Write(SimpleDB::BlockId(file_name, block_num + 4), &page);
+        EXPECT_EQ(fm.GetFileBlockNum(file_name), block_num + 5);
+
+        fm.SetFileSize(file_name, block_num);
+        EXPECT_EQ(fm.GetFileBlockNum(file_name), block_num);
+    }
+
+    // the high-water mark is persisted after restarting
+    SimpleDB::FileManager fm(directory_path, block_size);
+    EXPECT_EQ(fm.GetFileBlockNum(file_name), block_num);
+    EXPECT_EQ(fm.Append(file_name).BlockNum(), block_num);
+    stat(file_path.c_str(), &stat_buf);
+    EXPECT_EQ(stat_buf.st_size, (block_num + 1) * block_size);
+
+    system(cmd.c_str());
+}
+
+
+TEST(FileManagerTest, BlockIdTest) {
+    BlockId a("block_id_test.a", 1);
+    BlockId b(std::string("block_id_test.") + "a", 1);
+    BlockId c("block_id_test.c", 1);
+
+    // the same name is interned to the same id
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(a.FileId(), b.FileId());
+    EXPECT_NE(a, c);
+    EXPECT_EQ(a.Hash(), b.Hash());
+    EXPECT_EQ(c.FileName(), "block_id_test.c");
+    EXPECT_EQ(BlockId().FileName(), "");
+
+    // names registered concurrently get unique ids
+    const int thread_num = 4;
+    const int file_num = 1000;
+    std::vector<std::vector<uint32_t>> ids(thread_num);
+    std::vector<std::thread> threads;
+    for (int t = 0;t < thread_num;t ++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0;i < file_num;i ++) {
+                BlockId block("concurrent_" + std::to_string(i) + ".table", i);
+                ids[t].push_back(block.FileId());
+                EXPECT_EQ(block.FileName(), "concurrent_" + std::to_string(i) + ".table");
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    for (int t = 1;t < thread_num;t ++) {
+        EXPECT_EQ(ids[t], ids[0]);
+    }
+    EXPECT_EQ(std::set<uint32_t>(ids[0].begin(), ids[0].end()).size(), file_num);
+
+    // lookups of a page table don't hash strings any more
+    std::unordered_map<BlockId, int> page_table;
+    const int block_num = 4096;
+    std::vector<BlockId> blocks;
+    for (int i = 0;i < block_num;i ++) {
+        blocks.emplace_back("block_id_test.a", i);
+        page_table[blocks.back()] = i;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    long long sum = 0;
+    for (int round = 0;round < 100;round ++) {
+        for (auto &block : blocks) {
+            sum += page_table.find(block)->second;
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double time = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << "page table lookup = " << time / (100 * block_num) << " ns" << std::endl;
+    EXPECT_EQ(sum, 100LL * block_num * (block_num - 1) / 2);
+}
+
+}
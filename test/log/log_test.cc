@@ -3,12 +3,16 @@
 #include "recovery/log_record.h"
 #include "gtest/gtest.h"
 
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <random>
 #include <string>
 #include <cstring>
 #include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <thread>
 
 
 namespace SimpleDB {
@@ -349,6 +353,523 @@ TEST(LogManagerTest, FixSizeLogTest) {
 }
 
 
+/**
+* @brief append logs by many threads and check the log file,
+* every record should be in the file once, and the records 
+* of a thread should be in the order of appending
+*/
+void ConcurrentAppendCheck(LogManager *log_manager, int thread_num, int times) {
+    std::vector<std::thread> threads;
+    for (int t = 0;t < thread_num;t ++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0;i < times;i ++) {
+                std::string s = std::to_string(t) + " " + std::to_string(i);
+                lsn_t lsn = log_manager->Append(std::vector<char>(s.begin(), s.end()));
+                // commit every 10 records, the log should be durable after flushing
+                if (i % 10 == 9) {
+                    log_manager->Flush(lsn);
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    std::vector<int> next(thread_num, 0);
+    int total = 0;
+    auto log_iterator = log_manager->Iterator();
+    while (log_iterator.HasNextRecord()) {
+        auto record = log_iterator.CurrentRecord();
+        std::string s(record.begin(), record.end());
+        int t = std::stoi(s.substr(0, s.find(' ')));
+        int i = std::stoi(s.substr(s.find(' ') + 1));
+        EXPECT_EQ(next[t], i);
+        next[t] = i + 1;
+        total ++;
+        log_iterator.NextRecord();
+    }
+    EXPECT_EQ(total, thread_num * times);
+}
+
+TEST(LogManagerTest, GroupCommitTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string test_dir = local_path + "/" + "test_dir";
+    std::string cmd;
+    std::string log_file_name = "log.log";
+    std::unique_ptr<FileManager> file_manager 
+        = std::make_unique<FileManager>(test_dir, 4096);
+    std::unique_ptr<LogManager> log_manager 
+        = std::make_unique<LogManager>(file_manager.get(), log_file_name);
+    log_manager->StartFlushThread();
+
+    ConcurrentAppendCheck(log_manager.get(), 8, 2000);
+    log_manager->StopFlushThread();
+
+    cmd = "rm -rf " + test_dir;
+    system(cmd.c_str());
+}
+
+TEST(LogManagerTest, AsyncCommitTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string test_dir = local_path + "/" + "test_dir";
+    std::string cmd;
+    std::string log_file_name = "log.log";
+    std::unique_ptr<FileManager> file_manager 
+        = std::make_unique<FileManager>(test_dir, 4096);
+    std::unique_ptr<LogManager> log_manager 
+        = std::make_unique<LogManager>(file_manager.get(), log_file_name);
+
+    auto commit = [&](int times, bool async) {
+        lsn_t lsn = INVALID_LSN;
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0;i < times;i ++) {
+            CommitRecord record(i);
+            record.SetPrevLSN(0);
+            lsn = log_manager->AppendLogRecord(record);
+            if (async) {
+                log_manager->FlushAsync(lsn);
+            } else {
+                log_manager->Flush(lsn);
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        std::cout << (async ? "async commit: " : "sync commit: ") 
+                  << std::chrono::duration<double, std::micro>(end - begin).count() / times
+                  << " us per commit" << std::endl;
+        return lsn;
+    };
+
+    lsn_t sync_lsn = commit(1000, false);
+    EXPECT_EQ(log_manager->GetFlushedLsn(), sync_lsn);
+    
+    // the flush thread is started by the first async commit,
+    // and it flushes the log within its interval
+    lsn_t lsn = commit(100000, true);
+    auto begin = std::chrono::steady_clock::now();
+    while (log_manager->GetFlushedLsn() < lsn) {
+        ASSERT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds(5));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::cout << "the last async commit is durable after " 
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count()
+              << " ms" << std::endl;
+
+    // the log is complete
+    log_manager->StopFlushThread();
+    auto iter = log_manager->Iterator();
+    int record_num = 0;
+    while (iter.HasNextRecord()) {
+        record_num ++;
+        iter.NextRecord();
+    }
+    EXPECT_EQ(record_num, 101000);
+
+    log_manager.reset();
+    file_manager.reset();
+    cmd = "rm -rf " + test_dir;
+    system(cmd.c_str());
+}
+
+TEST(LogManagerTest, MultiBufferTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string test_dir = local_path + "/" + "test_dir";
+    std::string cmd;
+    std::string log_file_name = "log.log";
+
+    // small buffers, so that appenders seal and write them frequently
+    for (int buffer_num : {2, 4}) {
+        for (bool flush_thread : {false, true}) {
+            std::unique_ptr<FileManager> file_manager 
+                = std::make_unique<FileManager>(test_dir, 4096);
+            std::unique_ptr<LogManager> log_manager 
+                = std::make_unique<LogManager>(file_manager.get(), log_file_name, buffer_num, 1);
+            if (flush_thread) {
+                log_manager->StartFlushThread();
+            }
+
+            ConcurrentAppendCheck(log_manager.get(), 8, 2000);
+
+            log_manager.reset();
+            file_manager.reset();
+            cmd = "rm -rf " + test_dir;
+            system(cmd.c_str());
+        }
+    }
+}
+
+TEST(LogManagerTest, LargeRecordTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string test_dir = local_path + "/" + "test_dir";
+    std::string cmd;
+    std::string log_file_name = "log.log";
+
+    // records larger than a block are mixed with small ones
+    std::vector<std::vector<char>> records;
+    for (int i = 0;i < 30;i ++) {
+        auto record = CreateLogRecord(i);
+        if (i % 10 == 5) {
+            record.resize(6000 + i * 500, 'a' + i % 26);
+        }
+        records.push_back(record);
+    }
+
+    auto check_log = [&](LogManager *log_manager) {
+        auto log_iterator = log_manager->Iterator();
+        std::vector<log_offset_t> offsets;
+        int i = 0;
+        while (log_iterator.HasNextRecord()) {
+            EXPECT_EQ(log_iterator.CurrentRecord(), records[i]);
+            offsets.push_back(log_iterator.GetLogOffset());
+            i ++;
+            log_iterator.NextRecord();
+        }
+        EXPECT_EQ(i, static_cast<int>(records.size()));
+
+        // a large record can also be read by moving to it directly
+        auto move_iterator = log_manager->Iterator();
+        for (int j = static_cast<int>(offsets.size()) - 1;j >= 0;j --) {
+            EXPECT_EQ(move_iterator.MoveToRecord(offsets[j]), records[j]);
+        }
+    };
+
+    {
+        auto file_manager = std::make_unique<FileManager>(test_dir, 4096);
+        auto log_manager = std::make_unique<LogManager>(file_manager.get(), log_file_name);
+        lsn_t lsn = INVALID_LSN;
+        for (auto &record : records) {
+            lsn = log_manager->Append(record);
+        }
+        log_manager->Flush(lsn);
+        check_log(log_manager.get());
+    }
+
+    {
+        // the end of log is found after restarting
+        auto file_manager = std::make_unique<FileManager>(test_dir, 4096);
+        auto log_manager = std::make_unique<LogManager>(file_manager.get(), log_file_name);
+        check_log(log_manager.get());
+    }
+
+    cmd = "rm -rf " + test_dir;
+    system(cmd.c_str());
+}
+
+TEST(LogManagerTest, SegmentTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string test_dir = local_path + "/" + "test_dir";
+    std::string cmd;
+    std::string log_file_name = "log.log";
+    int segment_size = 16 * 4096;
+
+    auto segment_num = [&]() {
+        int num = 0;
+        for (auto &entry : std::filesystem::directory_iterator(test_dir)) {
+            if (entry.path().filename().string().rfind(log_file_name + ".", 0) == 0) {
+                num ++;
+            }
+        }
+        return num;
+    };
+
+    // read the log and check it's a suffix of records
+    auto check_log = [&](LogManager *log_manager, 
+                         std::vector<std::vector<char>> &records, 
+                         std::vector<log_offset_t> &offsets) -> int {
+        auto log_iterator = log_manager->Iterator();
+        int first = -1;
+        int i = 0;
+        while (log_iterator.HasNextRecord()) {
+            auto record = log_iterator.CurrentRecord();
+            if (first == -1) {
+                first = std::find(records.begin(), records.end(), record) - records.begin();
+                if (first == static_cast<int>(records.size())) {
+                    ADD_FAILURE() << "unknown record";
+                    return -1;
+                }
+                i = first;
+            }
+            EXPECT_EQ(record, records[i]);
+            EXPECT_EQ(log_iterator.GetLogOffset(), offsets[i]);
+            i ++;
+            log_iterator.NextRecord();
+        }
+        EXPECT_EQ(i, static_cast<int>(records.size()));
+        return first;
+    };
+
+    std::vector<std::vector<char>> records;
+    std::vector<log_offset_t> offsets;
+    auto append = [&](LogManager *log_manager, int times) {
+        lsn_t lsn = INVALID_LSN;
+        for (int i = 0;i < times;i ++) {
+            records.push_back(CreateLogRecord(records.size()));
+            lsn = log_manager->Append(records.back());
+        }
+        log_manager->Flush(lsn);
+        
+        // the offsets are checked later
+        auto log_iterator = log_manager->Iterator(offsets.empty() ? 0 : offsets.back());
+        if (!offsets.empty()) {
+            log_iterator.NextRecord();
+        }
+        while (log_iterator.HasNextRecord()) {
+            offsets.push_back(log_iterator.GetLogOffset());
+            log_iterator.NextRecord();
+        }
+    };
+
+    {
+        auto file_manager = std::make_unique<FileManager>(test_dir, 4096);
+        auto log_manager = std::make_unique<LogManager>(file_manager.get(), log_file_name, 
+                                                        4, 1, segment_size);
+        // records span many segments, but none of them spans two segments
+        append(log_manager.get(), 3000);
+        for (auto offset : offsets) {
+            EXPECT_LE(offset % segment_size + 104, segment_size);
+        }
+        EXPECT_EQ(check_log(log_manager.get(), records, offsets), 0);
+    }
+
+    {
+        // the end of log is found after restarting
+        auto file_manager = std::make_unique<FileManager>(test_dir, 4096);
+        auto log_manager = std::make_unique<LogManager>(file_manager.get(), log_file_name, 
+                                                        4, 1, segment_size);
+        append(log_manager.get(), 1000);
+        EXPECT_EQ(check_log(log_manager.get(), records, offsets), 0);
+
+        // the log before the record is not needed anymore
+        int keep = 2000;
+        log_manager->Truncate(offsets[keep]);
+        int first = check_log(log_manager.get(), records, offsets);
+        EXPECT_GT(first, 0);
+        EXPECT_LE(first, keep);
+        EXPECT_EQ(offsets[first] % segment_size, 0);
+
+        // segments are recycled, so the number of them is bounded
+        int used_num = (offsets.back() - offsets[first]) / segment_size + 1;
+        EXPECT_LE(segment_num(), used_num + SIMPLEDB_LOG_FREE_SEGMENT_NUM + 1);
+        for (int round = 0;round < 10;round ++) {
+            append(log_manager.get(), 1000);
+            log_manager->Truncate(offsets[offsets.size() - 500]);
+            EXPECT_LE(segment_num(), 2 + SIMPLEDB_LOG_FREE_SEGMENT_NUM + 1);
+        }
+        check_log(log_manager.get(), records, offsets);
+
+        // recycling segments doesn't block appending
+        log_offset_t truncate_offset = offsets[offsets.size() - 500];
+        std::thread truncater([&]() {
+            log_manager->Truncate(truncate_offset);
+        });
+        append(log_manager.get(), 1000);
+        truncater.join();
+        check_log(log_manager.get(), records, offsets);
+    }
+
+    {
+        // the truncated log is still readable after restarting
+        auto file_manager = std::make_unique<FileManager>(test_dir, 4096);
+        auto log_manager = std::make_unique<LogManager>(file_manager.get(), log_file_name, 
+                                                        4, 1, segment_size);
+        append(log_manager.get(), 100);
+        int first = check_log(log_manager.get(), records, offsets);
+        EXPECT_GT(first, 0);
+    }
+
+    {
+        // the offset keeps growing after recycling, so it may pass 2GB
+        auto file_manager = std::make_unique<FileManager>(test_dir, 4096);
+        auto log_manager = std::make_unique<LogManager>(file_manager.get(), log_file_name, 
+                                                        4, 1, segment_size);
+        log_offset_t offset = (static_cast<log_offset_t>(5) << 32) + 123;
+        log_manager->SetMasterLsnOffset(offset);
+        EXPECT_EQ(log_manager->GetMasterLsnOffset(), offset);
+    }
+
+    cmd = "rm -rf " + test_dir;
+    system(cmd.c_str());
+}
+
+TEST(LogManagerTest, AppendBenchmark) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string test_dir = local_path + "/" + "test_dir";
+    std::string cmd;
+    std::string log_file_name = "log.log";
+    std::vector<char> log_record(100, 'x');
+    int thread_num = 4;
+    int times = 50000;
+
+    for (int buffer_num : {2, 4, 8}) {
+        for (int buffer_block_num : {1, 16}) {
+            std::unique_ptr<FileManager> file_manager 
+                = std::make_unique<FileManager>(test_dir, 4096);
+            std::unique_ptr<LogManager> log_manager 
+                = std::make_unique<LogManager>(file_manager.get(), log_file_name, 
+                                               buffer_num, buffer_block_num);
+
+            auto begin = std::chrono::steady_clock::now();
+            std::vector<std::thread> threads;
+            for (int t = 0;t < thread_num;t ++) {
+                threads.emplace_back([&]() {
+                    for (int i = 0;i < times;i ++) {
+                        log_manager->Append(log_record);
+                    }
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            auto end = std::chrono::steady_clock::now();
+            double seconds = std::chrono::duration<double>(end - begin).count();
+            std::cout << "buffers = " << buffer_num 
+                      << ", buffer size = " << buffer_block_num * 4 << " KB: "
+                      << static_cast<int>(thread_num * times / seconds) << " appends/s"
+                      << std::endl;
+
+            log_manager.reset();
+            file_manager.reset();
+            cmd = "rm -rf " + test_dir;
+            system(cmd.c_str());
+        }
+    }
+}
+
+TEST(LogManagerTest, AppendLogRecordBenchmark) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string test_dir = local_path + "/" + "test_dir";
+    std::string cmd;
+    std::string log_file_name = "log.log";
+    int thread_num = 4;
+    int times = 50000;
+
+    // copy: serialize to a temporary byte array, then copy it to log buffer.
+    // in place: serialize in the reserved space of log buffer
+    for (bool in_place : {false, true}) {
+        std::unique_ptr<FileManager> file_manager 
+            = std::make_unique<FileManager>(test_dir, 4096);
+        std::unique_ptr<LogManager> log_manager 
+            = std::make_unique<LogManager>(file_manager.get(), log_file_name);
+
+        auto begin = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int t = 0;t < thread_num;t ++) {
+            threads.emplace_back([&, t]() {
+                std::vector<char> old_data(100, 'a');
+                std::vector<char> new_data(100, 'a');
+                new_data[50] = 'b';
+                InsertRecord insert_record(t, "test1.txt", RID(t, 0), Tuple(old_data));
+                UpdateRecord update_record(t, "test1.txt", RID(t, 0), Tuple(old_data), Tuple(new_data));
+                insert_record.SetPrevLSN(0);
+                update_record.SetPrevLSN(0);
+
+                for (int i = 0;i < times;i ++) {
+                    LogRecord &record = i % 2 == 0 ? static_cast<LogRecord&>(insert_record) 
+                                                   : static_cast<LogRecord&>(update_record);
+                    if (in_place) {
+                        log_manager->AppendLogRecord(record);
+                    } else {
+                        log_manager->Append(*record.Serializeto());
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        auto end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - begin).count();
+        std::cout << (in_place ? "in place" : "copy") << ": "
+                  << static_cast<int>(thread_num * times / seconds) << " appends/s"
+                  << std::endl;
+
+        // the records serialized in place can be read back
+        if (in_place) {
+            auto iter = log_manager->Iterator();
+            int record_num = 0;
+            while (iter.HasNextRecord()) {
+                auto log_record = LogRecord::DeserializeFrom(iter.CurrentRecord());
+                EXPECT_NE(log_record, nullptr);
+                record_num ++;
+                iter.NextRecord();
+            }
+            EXPECT_EQ(record_num, thread_num * times);
+        }
+
+        log_manager.reset();
+        file_manager.reset();
+        cmd = "rm -rf " + test_dir;
+        system(cmd.c_str());
+    }
+}
+
+TEST(LogManagerTest, GroupCommitBenchmark) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string test_dir = local_path + "/" + "test_dir";
+    std::string cmd;
+    std::string log_file_name = "log.log";
+
+    auto run = [&](int client_num, bool group_commit) {
+        std::unique_ptr<FileManager> file_manager 
+            = std::make_unique<FileManager>(test_dir, 4096);
+        std::unique_ptr<LogManager> log_manager 
+            = std::make_unique<LogManager>(file_manager.get(), log_file_name);
+        if (group_commit) {
+            log_manager->StartFlushThread();
+        }
+
+        // every client commits a transaction at a time
+        std::atomic<bool> stop{false};
+        std::atomic<int> commit_num{0};
+        std::vector<std::thread> clients;
+        for (int t = 0;t < client_num;t ++) {
+            clients.emplace_back([&, t]() {
+                txn_id_t txn_id = t;
+                while (!stop) {
+                    CommitRecord record(txn_id);
+                    record.SetPrevLSN(0);
+                    lsn_t lsn = log_manager->AppendLogRecord(record);
+                    log_manager->Flush(lsn);
+                    commit_num ++;
+                    txn_id += client_num;
+                }
+            });
+        }
+        
+        auto begin = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        stop = true;
+        for (auto &client : clients) {
+            client.join();
+        }
+        auto end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - begin).count();
+
+        log_manager.reset();
+        file_manager.reset();
+        cmd = "rm -rf " + test_dir;
+        system(cmd.c_str());
+        return commit_num / seconds;
+    };
+
+    for (int client_num : {1, 2, 4, 8, 16}) {
+        double sync_rate = run(client_num, false);
+        double group_rate = run(client_num, true);
+        std::cout << "clients = " << client_num 
+                  << ", sync flush: " << static_cast<int>(sync_rate) << " commits/s"
+                  << ", group commit: " << static_cast<int>(group_rate) << " commits/s"
+                  << std::endl;
+    }
+}
+
 TEST(LogTest, LogIteratorMixTest) {
     return ;
 }
@@ -9,6 +9,7 @@
 #include <string>
 #include <cstring>
 #include <algorithm>
+#include <chrono>
 
 namespace SimpleDB {
 
@@ -436,4 +437,143 @@ TEST(LogRecordTest, ChkptEndLogTest1) {
 }
 
 
+TEST(LogRecordTest, UpdateRangeTest) {
+    std::random_device seed; // get ramdom seed
+    std::ranlux48 engine(seed());
+    std::uniform_int_distribution<> distrib(0, 99);
+
+    for (int i = 0;i < 1000;i ++) {
+        Tuple old_tuple = GetRandomTuple();
+        Tuple new_tuple;
+        if (i % 2 == 0) {
+            // same size, change a few bytes
+            std::vector<char> data = *old_tuple.GetData();
+            for (int j = 0;j < 3;j ++) {
+                data[distrib(engine) % data.size()] = 'a' + j;
+            }
+            new_tuple = Tuple(data);
+        } else {
+            new_tuple = GetRandomTuple();
+        }
+
+        auto log_record = UpdateRecord(1, "test1.txt", RID(1, 2), old_tuple, new_tuple);
+        log_record.SetLsn(100);
+        log_record.SetPrevLSN(99);
+        auto log_record_tmp = LogRecord::DeserializeFrom(*log_record.Serializeto());
+        auto tmp = dynamic_cast<UpdateRecord*> (log_record_tmp.get());
+        EXPECT_EQ(*tmp, log_record);
+
+        // redo and undo only by the changed ranges
+        EXPECT_EQ(tmp->GetNewTuple(old_tuple), new_tuple);
+        EXPECT_EQ(tmp->GetOldTuple(new_tuple), old_tuple);
+
+        auto clr_record = tmp->ReverseRecord(1);
+        EXPECT_EQ(clr_record->GetNewTuple(new_tuple), old_tuple);
+        EXPECT_EQ(clr_record->GetOldTuple(old_tuple), new_tuple);
+
+        if (i % 2 == 0) {
+            // unchanged bytes are not logged
+            EXPECT_LE(log_record.RecordSize(), 64);
+        }
+    }
+
+    // a tuple which doesn't match the log must be rejected, not patched
+    std::vector<char> old_data(20, 'a');
+    std::vector<char> new_data(20, 'a');
+    new_data[10] = 'b';
+    auto log_record = UpdateRecord(1, "test1.txt", RID(1, 2), Tuple(old_data), Tuple(new_data));
+    EXPECT_THROW(log_record.GetNewTuple(Tuple()), std::runtime_error);
+    EXPECT_THROW(log_record.GetNewTuple(Tuple(new_data)), std::runtime_error);
+    EXPECT_THROW(log_record.GetOldTuple(Tuple(std::vector<char>(30, 'a'))), std::runtime_error);
+}
+
+TEST(LogRecordTest, LogVolumeBenchmark) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string test_dir = local_path + "/" + "test_dir";
+    std::string test_file = "test1.txt";
+    std::string cmd;
+
+    cmd = "rm -rf " + test_dir;
+    system(cmd.c_str());
+
+    std::string log_file_name = "log.log";
+    std::unique_ptr<FileManager> file_manager 
+        = std::make_unique<FileManager>(test_dir, 4096);
+    std::unique_ptr<LogManager> log_manager 
+        = std::make_unique<LogManager>(file_manager.get(), log_file_name);
+
+    Schema schema;
+    schema.AddColumn(Column("name", TypeID::CHAR, 20));
+    schema.AddColumn(Column("balance", TypeID::INTEGER));
+    schema.AddColumn(Column("rate", TypeID::DECIMAL));
+    schema.AddColumn(Column("note", TypeID::VARCHAR, 60));
+
+    // every txn updates the balance of 8 rows
+    int txn_num = 10000;
+    int update_num = 8;
+    int64_t compact_size = 0;
+    int64_t fixed_size = 0;
+    
+    // the size of record with the former fixed-width format
+    int fixed_header = 6 * sizeof(int);
+    auto fixed_update_size = [&](const Tuple &old_tuple, const Tuple &new_tuple) {
+        return fixed_header + Page::MaxLength(test_file.size()) + 2 * sizeof(int) + 
+               Page::MaxLength(old_tuple.GetSize()) + Page::MaxLength(new_tuple.GetSize());
+    };
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int txn_id = 0;txn_id < txn_num;txn_id ++) {
+        BeginRecord begin_record(txn_id);
+        lsn_t last_lsn = log_manager->AppendLogRecord(begin_record);
+        compact_size += Page::MaxLength(begin_record.RecordSize());
+        fixed_size += Page::MaxLength(fixed_header);
+
+        for (int i = 0;i < update_num;i ++) {
+            std::vector<Value> old_values{Value("customer" + std::to_string(i), TypeID::CHAR),
+                Value(txn_id * 10 + i), Value(0.05), Value("a note which is not changed", TypeID::VARCHAR)};
+            std::vector<Value> new_values{Value("customer" + std::to_string(i), TypeID::CHAR),
+                Value(txn_id * 10 + i + 100), Value(0.05), Value("a note which is not changed", TypeID::VARCHAR)};
+            Tuple old_tuple(old_values, schema);
+            Tuple new_tuple(new_values, schema);
+
+            UpdateRecord update_record(txn_id, test_file, RID(txn_id / 16, i), old_tuple, new_tuple);
+            update_record.SetPrevLSN(last_lsn);
+            last_lsn = log_manager->AppendLogRecord(update_record);
+            compact_size += Page::MaxLength(update_record.RecordSize());
+            fixed_size += Page::MaxLength(fixed_update_size(old_tuple, new_tuple));
+        }
+
+        CommitRecord commit_record(txn_id);
+        commit_record.SetPrevLSN(last_lsn);
+        log_manager->AppendLogRecord(commit_record);
+        compact_size += Page::MaxLength(commit_record.RecordSize());
+        fixed_size += Page::MaxLength(fixed_header);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+
+    std::cout << "txns = " << txn_num << " "
+              << "updates per txn = " << update_num << std::endl;
+    std::cout << "fixed-width log bytes = " << fixed_size << " "
+              << "compact log bytes = " << compact_size << " "
+              << "ratio = " << static_cast<double>(fixed_size) / compact_size << " "
+              << "append time = " << ms << " ms" << std::endl;
+    EXPECT_LT(compact_size, fixed_size);
+
+    // all the records can be read back
+    auto iter = log_manager->Iterator();
+    int record_num = 0;
+    while (iter.HasNextRecord()) {
+        auto log_record = LogRecord::DeserializeFrom(iter.CurrentRecord());
+        EXPECT_NE(log_record, nullptr);
+        record_num ++;
+        iter.NextRecord();
+    }
+    EXPECT_EQ(record_num, txn_num * (update_num + 2));
+
+    cmd = "rm -rf " + test_dir;
+    system(cmd.c_str());
+}
+
 } // namespace SimpleDB
@@ -13,6 +13,8 @@
 #include <string>
 #include <cstring>
 #include <algorithm>
+#include <chrono>
+#include <thread>
 
 
 
@@ -172,6 +174,73 @@ TEST(TransactionTest, IsolationTest) {
     system(cmd.c_str());
 }
 
+TEST(TransactionTest, AsyncCommitTest) {
+    char buf[100];
+    std::string local_path = getcwd(buf, 100);
+    std::string test_dir = local_path + "/" + "test_dir";
+    std::string cmd;
+    cmd = "rm -rf " + test_dir;
+    system(cmd.c_str());
+
+    std::string log_file_name = "log.log";
+    std::unique_ptr<FileManager> file_manager 
+        = std::make_unique<FileManager>(test_dir, 4096);
+    std::unique_ptr<LogManager> log_manager 
+        = std::make_unique<LogManager>(file_manager.get(), log_file_name);
+    std::unique_ptr<RecoveryManager> rm 
+        = std::make_unique<RecoveryManager>(log_manager.get());
+    std::unique_ptr<BufferManager> buf_manager
+        = std::make_unique<BufferManager>(file_manager.get(), rm.get(), 10);
+
+    auto lock = std::make_unique<LockManager>();
+    TransactionManager txn_mgr(std::move(lock), rm.get(), file_manager.get(), buf_manager.get());
+
+    // a normal txn waits for its commit log
+    auto tx1 = txn_mgr.Begin();
+    EXPECT_FALSE(tx1->IsAsyncCommit());
+    txn_mgr.Commit(tx1.get());
+    lsn_t sync_lsn = log_manager->GetFlushedLsn();
+
+    // the log of tx1 is followed by its txn-end, 
+    // and the begin, commit of tx2
+    auto interval = std::chrono::milliseconds(100);
+    log_manager->StartFlushThread(interval);
+    auto tx2 = txn_mgr.Begin(IsoLationLevel::SERIALIZABLE, true);
+    txn_id_t tx2_id = tx2->GetTxnID();
+    EXPECT_TRUE(tx2->IsAsyncCommit());
+    txn_mgr.Commit(tx2.get());
+    auto begin = std::chrono::steady_clock::now();
+    lsn_t commit_lsn = sync_lsn + 3;
+    EXPECT_LT(log_manager->GetFlushedLsn(), commit_lsn);
+
+    // durable within an interval, plus a write and sync
+    while (log_manager->GetFlushedLsn() < commit_lsn) {
+        ASSERT_LT(std::chrono::steady_clock::now() - begin, interval + std::chrono::seconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    log_manager->StopFlushThread();
+
+    bool found = false;
+    auto log_iter = log_manager->Iterator();
+    while (log_iter.HasNextRecord()) {
+        auto log_record = LogRecord::DeserializeFrom(log_iter.CurrentRecord());
+        if (log_record->GetRecordType() == LogRecordType::COMMIT &&
+            log_record->GetTxnID() == tx2_id) {
+            EXPECT_EQ(log_record->GetLsn(), commit_lsn);
+            found = true;
+        }
+        log_iter.NextRecord();
+    }
+    EXPECT_TRUE(found);
+
+    buf_manager.reset();
+    rm.reset();
+    log_manager.reset();
+    file_manager.reset();
+    cmd = "rm -rf " + test_dir;
+    system(cmd.c_str());
+}
+
 
 
 } // namespace SimpleDB
\ No newline at end of file